@@ -4,9 +4,15 @@ include(ExternalProject)
 
 set(COMMON_DIR ${CMAKE_CURRENT_LIST_DIR}/../common)
 
+option(AOC_COUNT_ALLOCS
+  "Count heap allocations for --bench and --stats"
+  OFF
+  )
+
 ExternalProject_Add(common-ext
   SOURCE_DIR ${COMMON_DIR}
   CMAKE_ARGS -DUNITTESTS_ENABLED=OFF -DCMAKE_BUILD_TYPE=Release
+    -DAOC_COUNT_ALLOCS=${AOC_COUNT_ALLOCS}
   CMAKE_GENERATOR ${CMAKE_GENERATOR}
   BUILD_BYPRODUCTS <BINARY_DIR>/libaoc_common.a
   INSTALL_COMMAND ""
@@ -20,8 +26,11 @@ set_property(TARGET common-imp
   )
 add_dependencies(common-imp common-ext)
 
+set(THREADS_PREFER_PTHREAD_FLAG ON)
+find_package(Threads REQUIRED)
+
 add_library(common INTERFACE)
-target_link_libraries(common INTERFACE common-imp)
+target_link_libraries(common INTERFACE common-imp Threads::Threads)
 target_include_directories(common INTERFACE
   ${COMMON_DIR}
   )
@@ -0,0 +1,74 @@
+/**
+ * @file alloc_count.c
+ * @brief Implementation of the allocation counters
+ */
+
+#include "alloc_count.h"
+
+#include <stdlib.h>
+
+/**
+ * The counters are updated from every thread which allocates, so
+ * they're incremented atomically. No ordering is needed, readers only
+ * look at them once the work they're measuring is done.
+ */
+static alloc_count_t counters;
+
+#define COUNT(field, n) __atomic_fetch_add(&counters.field, (n), __ATOMIC_RELAXED)
+
+#if defined(AOC_COUNT_ALLOCS) && defined(__GLIBC__)
+
+// The allocator entry points glibc exports for malloc replacements
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+void* malloc(size_t size){
+  COUNT(allocs, 1);
+  COUNT(bytes, size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t nmemb, size_t size){
+  COUNT(allocs, 1);
+  COUNT(bytes, nmemb*size);
+  return __libc_calloc(nmemb, size);
+}
+
+void* realloc(void* ptr, size_t size){
+  if(ptr == NULL){
+    COUNT(allocs, 1);
+  }
+  else{
+    COUNT(reallocs, 1);
+  }
+  COUNT(bytes, size);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr){
+  if(ptr != NULL){
+    COUNT(frees, 1);
+  }
+  __libc_free(ptr);
+}
+
+bool alloc_count_enabled(void){
+  return true;
+}
+
+#else
+
+bool alloc_count_enabled(void){
+  return false;
+}
+
+#endif
+
+void alloc_count_get(alloc_count_t* count){
+  count->allocs = __atomic_load_n(&counters.allocs, __ATOMIC_RELAXED);
+  count->reallocs = __atomic_load_n(&counters.reallocs, __ATOMIC_RELAXED);
+  count->frees = __atomic_load_n(&counters.frees, __ATOMIC_RELAXED);
+  count->bytes = __atomic_load_n(&counters.bytes, __ATOMIC_RELAXED);
+}
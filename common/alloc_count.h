@@ -0,0 +1,38 @@
+/**
+ * @file alloc_count.h
+ * @brief Process wide heap allocation counters
+ *
+ * Built with AOC_COUNT_ALLOCS defined (the CMake option of the same
+ * name), this module replaces malloc, calloc, realloc and free with thin
+ * wrappers which count the calls before handing them on to the C
+ * library's allocator. Counting costs a few atomic operations on shared
+ * counters per allocation, so it is off by default. It only works with
+ * glibc, otherwise the counters stay at zero.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct alloc_count{
+  size_t allocs;
+  size_t reallocs;
+  size_t frees;
+  size_t bytes;
+} alloc_count_t;
+
+/**
+ * @brief Returns whether allocations are counted in this build
+ */
+bool alloc_count_enabled(void);
+
+/**
+ * @brief Stores the current counter values in @e count
+ *
+ * The counters are never reset, compare two snapshots to get the
+ * allocations of a section of code.
+ *
+ * @param count Receives the counter values
+ */
+void alloc_count_get(alloc_count_t* count);
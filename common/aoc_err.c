@@ -5,36 +5,86 @@
 
 #include "aoc_err.h"
 
+#include <stdarg.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 /**
- * Holds the latest error message from a AoC Day function
+ * The error records of a thread
  *
- * NULL when no error occured.
+ * Every thread has its own, so day functions running in parallel don't
+ * overwrite each other's errors. All storage is preallocated, recording
+ * an error never touches the heap.
  */
-static char* aoc_err_msg;
+struct aoc_err_ctx{
+  aoc_err_rec_t recs[AOC_ERR_RING_SIZE];
+  // Total number of records written, the latest is at (count-1) % size
+  unsigned long count;
+  // Whether the latest record was not yet retrieved
+  bool pending;
+};
+
+static _Thread_local struct aoc_err_ctx aoc_err_ctx;
+
+void aoc_err_set(aoc_err_code_t code, int errnum, const char* file, int line,
+                 const char* func, const char* fmt, ...){
+  struct aoc_err_ctx* ctx = &aoc_err_ctx;
+  aoc_err_rec_t* rec = &ctx->recs[ctx->count % AOC_ERR_RING_SIZE];
+  rec->code = code;
+  rec->errnum = errnum;
+  rec->file = file;
+  rec->line = line;
+  rec->func = func;
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(rec->msg, AOC_ERR_MSG_LEN, fmt, args);
+  va_end(args);
+  ctx->count++;
+  ctx->pending = true;
+}
+
+const aoc_err_rec_t* aoc_err_get(unsigned age){
+  struct aoc_err_ctx* ctx = &aoc_err_ctx;
+  if(age >= AOC_ERR_RING_SIZE || age >= ctx->count){
+    return NULL;
+  }
+  return &ctx->recs[(ctx->count - 1 - age) % AOC_ERR_RING_SIZE];
+}
+
+void aoc_err_clear(void){
+  aoc_err_ctx.count = 0;
+  aoc_err_ctx.pending = false;
+}
 
 void set_aoc_err_msg(const char* errmsg, int errcode){
   if(errmsg == NULL){
     return;
   }
-  size_t msg_len = strlen(errmsg)+1;
-  if(errcode != 0){
-    msg_len += 1 + strlen(strerror(errcode));
+  aoc_err_set(errcode != 0 ? AOC_ERR_SYS : AOC_ERR_GENERIC, errcode,
+              NULL, 0, NULL, "%s", errmsg);
+}
+
+char* get_latest_aoc_err_msg(){
+  if(!aoc_err_ctx.pending){
+    return NULL;
+  }
+  aoc_err_ctx.pending = false;
+  const aoc_err_rec_t* rec = aoc_err_get(0);
+  size_t msg_len = strlen(rec->msg)+1;
+  if(rec->errnum != 0){
+    msg_len += 1 + strlen(strerror(rec->errnum));
   }
-  aoc_err_msg = malloc(msg_len);
-  if(errcode != 0){
-    snprintf(aoc_err_msg, msg_len, "%s\n%s", errmsg, strerror(errcode));
+  char* latest_msg = malloc(msg_len);
+  if(latest_msg == NULL){
+    return NULL;
+  }
+  if(rec->errnum != 0){
+    snprintf(latest_msg, msg_len, "%s\n%s", rec->msg, strerror(rec->errnum));
   }
   else{
-    snprintf(aoc_err_msg, msg_len, "%s", errmsg);
+    snprintf(latest_msg, msg_len, "%s", rec->msg);
   }
-}
-
-char* get_latest_aoc_err_msg(){
-  char* latest_msg = aoc_err_msg;
-  aoc_err_msg = NULL;
   return latest_msg;
 }
@@ -5,18 +5,95 @@
 
 #pragma once
 
+/**
+ * Number of error records kept per thread
+ */
+#define AOC_ERR_RING_SIZE 8
+
+/**
+ * Size of the message buffer of an error record, including the
+ * terminator. Longer messages are truncated.
+ */
+#define AOC_ERR_MSG_LEN 256
+
+/**
+ * Kinds of AoC errors
+ */
+typedef enum aoc_err_code{
+  AOC_ERR_NONE = 0,
+  AOC_ERR_GENERIC,  // Set via set_aoc_err_msg without an errcode
+  AOC_ERR_INVAL,    // Invalid argument, e.g. a NULL or empty tokenizer
+  AOC_ERR_PARSE,    // Malformed input
+  AOC_ERR_RANGE,    // A number in the input is out of range
+  AOC_ERR_NOTFOUND, // The input has no solution
+  AOC_ERR_SYS,      // A system or library call failed, see errnum
+} aoc_err_code_t;
+
+/**
+ * A single error, with the location it was raised at
+ */
+typedef struct aoc_err_rec{
+  aoc_err_code_t code;
+  int errnum;
+  const char* file;
+  int line;
+  const char* func;
+  char msg[AOC_ERR_MSG_LEN];
+} aoc_err_rec_t;
+
+/**
+ * @brief Records an AoC error
+ *
+ * Formats the message into the next slot of the calling thread's ring of
+ * error records, overwriting the oldest one once the ring is full. Never
+ * allocates, so it's safe to use on hot error paths. Use the AOC_ERR
+ * macro instead of calling this directly.
+ *
+ * @param code The kind of error
+ * @param errnum The errno value of a failed call or 0
+ * @param file Source file the error was raised in, may be NULL
+ * @param line Source line the error was raised at
+ * @param func Function the error was raised in, may be NULL
+ * @param fmt printf style format of the message
+ */
+void aoc_err_set(aoc_err_code_t code, int errnum, const char* file, int line,
+                 const char* func, const char* fmt, ...)
+  __attribute__((format(printf, 6, 7)));
+
+/**
+ * @brief Records an AoC error raised at the current source location
+ *
+ * Usage: AOC_ERR(code, errnum, fmt, ...)
+ */
+#define AOC_ERR(code, errnum, ...)                                      \
+  aoc_err_set((code), (errnum), __FILE__, __LINE__, __func__, __VA_ARGS__)
+
+/**
+ * @brief Returns one of the calling thread's latest error records
+ *
+ * Looking at records does not count as retrieving them for
+ * get_latest_aoc_err_msg.
+ *
+ * @param age 0 for the latest record, 1 for the one before and so on
+ * @returns The record or NULL if there is no record that old
+ */
+const aoc_err_rec_t* aoc_err_get(unsigned age);
+
+/**
+ * @brief Drops all of the calling thread's error records
+ */
+void aoc_err_clear(void);
 
 /**
  * @brief Helper function to set AoC error message
  *
- * Sets the @e aoc_err_msg string.
- * If errcode is 0, @e aoc_err_msg is set to errmsg. Otherwise, @e aoc_err_msg
- * is set to @e errmsg\nstrerror(errcode). Note the explicit lack of a
+ * Records an error with the message @e errmsg.
+ * If errcode is 0, the message is @e errmsg. Otherwise, the message
+ * is @e errmsg\nstrerror(errcode). Note the explicit lack of a
  * trailing newline.
  *
- * NOTE: Errors in this function are explicitly not handled - when an
- * error occurs in your error handling function, you're pretty well screwed
- * and the program will just bail out.
+ * The messages are kept per thread, so they have to be retrieved on the
+ * thread which set them.
  *
  * @param errmsg The error message to show to the user
  * @param errcode The syscall error code which occured. 
@@ -27,8 +104,8 @@ void set_aoc_err_msg(const char* errmsg, int errcode);
  * @brief Returns the latest unretrieved AoC error message
  *
  * The latest, not yet retrieved error message set with set_aoc_err_msg
- * is returned. Subsequent calls to this function without intervening calls
- * to set_aoc_err_msg will return NULL.
+ * or AOC_ERR is returned. Subsequent calls to this function without
+ * intervening new errors will return NULL.
  *
  * The returned string is null terminated and dynamically allocated. The
  * caller is responsible for cleaning it up.
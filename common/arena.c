@@ -0,0 +1,165 @@
+/**
+ * @file arena.c
+ * @brief Implementation of the arena allocator
+ */
+
+#include "arena.h"
+
+#include <stdalign.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN alignof(max_align_t)
+
+/**
+ * A chunk of heap memory the arena hands out from front to back
+ */
+struct block {
+  struct block* next;
+  size_t size;
+  size_t used;
+  alignas(max_align_t) unsigned char data[];
+};
+
+struct deferred {
+  struct deferred* next;
+  void (*fn)(void*);
+  void* arg;
+};
+
+struct arena {
+  size_t block_size;
+  struct block* first;
+  struct block* current;
+  struct deferred* deferred;
+};
+
+static struct block* new_block(size_t size){
+  struct block* b = malloc(sizeof(struct block) + size);
+  if(b == NULL){
+    return NULL;
+  }
+  b->next = NULL;
+  b->size = size;
+  b->used = 0;
+  return b;
+}
+
+arena_t* arena_create(size_t block_size){
+  arena_t* arena = malloc(sizeof(arena_t));
+  if(arena == NULL){
+    return NULL;
+  }
+  arena->block_size = block_size == 0 ? ARENA_DEFAULT_BLOCK : block_size;
+  arena->first = new_block(arena->block_size);
+  if(arena->first == NULL){
+    free(arena);
+    return NULL;
+  }
+  arena->current = arena->first;
+  arena->deferred = NULL;
+  return arena;
+}
+
+void* arena_alloc(arena_t* arena, size_t size){
+  if(size > SIZE_MAX - ARENA_ALIGN){
+    return NULL;
+  }
+  size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+  struct block* b = arena->current;
+  // Blocks behind the current one are left over from before a reset
+  while(b->size - b->used < size && b->next != NULL){
+    b = b->next;
+  }
+  if(b->size - b->used < size){
+    struct block* grown = new_block(size > arena->block_size
+                                    ? size : arena->block_size);
+    if(grown == NULL){
+      return NULL;
+    }
+    b->next = grown;
+    b = grown;
+  }
+  arena->current = b;
+  void* mem = b->data + b->used;
+  b->used += size;
+  return mem;
+}
+
+void* arena_calloc(arena_t* arena, size_t nmemb, size_t size){
+  if(size != 0 && nmemb > SIZE_MAX / size){
+    return NULL;
+  }
+  void* mem = arena_alloc(arena, nmemb*size);
+  if(mem != NULL){
+    memset(mem, 0, nmemb*size);
+  }
+  return mem;
+}
+
+char* arena_sprintf(arena_t* arena, const char* fmt, ...){
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(NULL, 0, fmt, args);
+  va_end(args);
+  if(len < 0){
+    return NULL;
+  }
+  char* s = arena_alloc(arena, len + 1);
+  if(s == NULL){
+    return NULL;
+  }
+  va_start(args, fmt);
+  vsnprintf(s, len + 1, fmt, args);
+  va_end(args);
+  return s;
+}
+
+int arena_defer(arena_t* arena, void (*fn)(void*), void* arg){
+  struct deferred* d = arena_alloc(arena, sizeof(struct deferred));
+  if(d == NULL){
+    return -1;
+  }
+  d->fn = fn;
+  d->arg = arg;
+  d->next = arena->deferred;
+  arena->deferred = d;
+  return 0;
+}
+
+void arena_reset(arena_t* arena){
+  for(struct deferred* d = arena->deferred; d != NULL; d = d->next){
+    d->fn(d->arg);
+  }
+  arena->deferred = NULL;
+  for(struct block* b = arena->first; b != NULL; b = b->next){
+    b->used = 0;
+  }
+  arena->current = arena->first;
+}
+
+void arena_destroy(arena_t* arena){
+  if(arena == NULL){
+    return;
+  }
+  arena_reset(arena);
+  struct block* b = arena->first;
+  while(b != NULL){
+    struct block* next = b->next;
+    free(b);
+    b = next;
+  }
+  free(arena);
+}
+
+size_t arena_capacity(const arena_t* arena){
+  size_t capacity = 0;
+  for(const struct block* b = arena->first; b != NULL; b = b->next){
+    capacity += b->size;
+  }
+  return capacity;
+}
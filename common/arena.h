@@ -0,0 +1,81 @@
+/**
+ * @file arena.h
+ * @brief Bump allocator for state living as long as a single day run
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+struct arena;
+typedef struct arena arena_t;
+
+/**
+ * Default size of an arena's memory blocks
+ */
+#define ARENA_DEFAULT_BLOCK (64u*1024u)
+
+/**
+ * @brief Creates an empty arena
+ *
+ * Memory is taken from the heap in blocks of @e block_size bytes, larger
+ * allocations get a block of their own.
+ *
+ * @param block_size Size of the arena's blocks, 0 for ARENA_DEFAULT_BLOCK
+ * @returns The arena or NULL on error
+ */
+arena_t* arena_create(size_t block_size);
+
+/**
+ * @brief Allocates @e size bytes from @e arena
+ *
+ * The memory is suitably aligned for any type and stays valid until the
+ * arena is reset or destroyed. There is no way to free it individually.
+ *
+ * @returns Pointer to the memory or NULL on error
+ */
+void* arena_alloc(arena_t* arena, size_t size);
+
+/**
+ * @brief Like arena_alloc, for @e nmemb zeroed elements of @e size bytes
+ */
+void* arena_calloc(arena_t* arena, size_t nmemb, size_t size);
+
+/**
+ * @brief Formats a string into memory from @e arena, like sprintf
+ *
+ * @returns The null terminated string or NULL on error
+ */
+char* arena_sprintf(arena_t* arena, const char* fmt, ...)
+  __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Registers @e fn to be called with @e arg on the next reset
+ *
+ * For objects allocated from the arena which hold resources of their
+ * own. The functions are called in reverse order of registration.
+ *
+ * @returns 0 on success, -1 on error
+ */
+int arena_defer(arena_t* arena, void (*fn)(void*), void* arg);
+
+/**
+ * @brief Frees everything allocated from @e arena at once
+ *
+ * Runs the deferred functions and rewinds the arena. Its blocks are
+ * kept, so an arena reused for similar work stops allocating from the
+ * heap after the first round.
+ */
+void arena_reset(arena_t* arena);
+
+/**
+ * @brief Resets @e arena and returns all its memory to the heap
+ *
+ * @param arena The arena to destroy, may be NULL
+ */
+void arena_destroy(arena_t* arena);
+
+/**
+ * @brief Returns the number of bytes @e arena holds from the heap
+ */
+size_t arena_capacity(const arena_t* arena);
@@ -0,0 +1,128 @@
+/**
+ * @file bench_fastparse.c
+ * @brief Compares the fastparse parsers with their libc counterparts
+ *
+ * Usage: bench_fastparse [LINES]
+ *
+ * Generates LINES random lines in the formats of day 01 ("+123") and
+ * day 03 ("#12 @ 3,4: 5x6"), parses them with libc and with each
+ * fastparse kernel the CPU supports, and prints the best time of several
+ * rounds for each.
+ */
+
+#include "fastparse.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ROUNDS 5
+#define LINE_LEN 64
+
+static uint64_t now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec*1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static int64_t sum_strtol(char* lines, size_t n){
+  int64_t sum = 0;
+  for(size_t i = 0; i < n; i++){
+    sum += strtol(lines + i*LINE_LEN, NULL, 10);
+  }
+  return sum;
+}
+
+static int64_t sum_fp_i64(char* lines, size_t n){
+  int64_t sum = 0;
+  for(size_t i = 0; i < n; i++){
+    int64_t val;
+    fp_parse_i64(lines + i*LINE_LEN, NULL, &val);
+    sum += val;
+  }
+  return sum;
+}
+
+static int64_t sum_sscanf(char* lines, size_t n){
+  int64_t sum = 0;
+  for(size_t i = 0; i < n; i++){
+    unsigned v[5];
+    sscanf(lines + i*LINE_LEN, "#%u @ %u,%u: %ux%u",
+           &v[0], &v[1], &v[2], &v[3], &v[4]);
+    sum += v[0] + v[1] + v[2] + v[3] + v[4];
+  }
+  return sum;
+}
+
+static int64_t sum_fp_all(char* lines, size_t n){
+  int64_t sum = 0;
+  for(size_t i = 0; i < n; i++){
+    uint64_t v[5];
+    fp_parse_all_u64(lines + i*LINE_LEN, NULL, v, 5);
+    sum += v[0] + v[1] + v[2] + v[3] + v[4];
+  }
+  return sum;
+}
+
+/**
+ * Runs @e f ROUNDS times and returns the best time in ns per line.
+ */
+static double best_ns(int64_t (*f)(char*, size_t), char* lines, size_t n,
+                      int64_t* sum){
+  uint64_t best = UINT64_MAX;
+  for(int r = 0; r < ROUNDS; r++){
+    uint64_t start = now_ns();
+    *sum = f(lines, n);
+    uint64_t t = now_ns() - start;
+    best = t < best ? t : best;
+  }
+  return (double) best / (double) n;
+}
+
+static int compare(const char* name, int64_t (*libc)(char*, size_t),
+                   int64_t (*fp)(char*, size_t), char* lines, size_t n){
+  static const char* impl_names[] = {"scalar", "swar", "sse4.1", "avx2"};
+  int64_t libc_sum;
+  double libc_ns = best_ns(libc, lines, n, &libc_sum);
+  printf("%s: libc %.2f ns/line\n", name, libc_ns);
+  int ret = 0;
+  for(int impl = FP_IMPL_SCALAR; impl <= FP_IMPL_AVX2; impl++){
+    if(fp_set_impl(impl) != 0){
+      continue;
+    }
+    int64_t fp_sum;
+    double fp_ns = best_ns(fp, lines, n, &fp_sum);
+    printf("%s: fastparse %-6s %.2f ns/line, speedup %.2fx\n", name,
+           impl_names[impl], fp_ns, libc_ns / fp_ns);
+    if(libc_sum != fp_sum){
+      fprintf(stderr, "%s: results differ (%lld vs %lld).\n", name,
+              (long long) libc_sum, (long long) fp_sum);
+      ret = -1;
+    }
+  }
+  return ret;
+}
+
+int main(int argc, char** argv){
+  size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  char* lines = malloc(n*LINE_LEN);
+  if(n == 0 || lines == NULL){
+    fprintf(stderr, "Usage: %s [LINES]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  srand(2018);
+  for(size_t i = 0; i < n; i++){
+    snprintf(lines + i*LINE_LEN, LINE_LEN, "%c%d", rand() % 2 ? '+' : '-',
+             rand() % 200000);
+  }
+  int ret = compare("day01", sum_strtol, sum_fp_i64, lines, n);
+  for(size_t i = 0; i < n; i++){
+    snprintf(lines + i*LINE_LEN, LINE_LEN, "#%u @ %d,%d: %dx%d", (unsigned) i + 1,
+             rand() % 1000, rand() % 1000, rand() % 30 + 1, rand() % 30 + 1);
+  }
+  ret |= compare("day03", sum_sscanf, sum_fp_all, lines, n);
+  free(lines);
+  return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
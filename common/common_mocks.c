@@ -12,40 +12,74 @@
 #include <stdlib.h>
 #include <string.h>
 
-struct mock_mm_file_read_t* mock_mm_file_read = NULL;
+struct mock_mm_file_open_t* mock_mm_file_open = NULL;
+struct mock_mm_file_close_t* mock_mm_file_close = NULL;
 struct mock_get_tokenizer_t* mock_get_tokenizer = NULL;
+struct mock_get_stream_tokenizer_t* mock_get_stream_tokenizer = NULL;
+struct mock_tok_error_t* mock_tok_error = NULL;
+struct mock_tok_count_t* mock_tok_count = NULL;
 struct mock_n_tok_t* mock_n_tok = NULL;
+struct mock_reset_tok_t* mock_reset_tok = NULL;
 struct mock_free_tok_t* mock_free_tok = NULL;
+struct mock_reload_tok_t* mock_reload_tok = NULL;
 struct mock_get_latest_aoc_err_msg_t* mock_get_latest_aoc_err_msg = NULL;
 
-char* mm_file_read(const char* fpath){
-  if(mock_mm_file_read == NULL){
-    fprintf(stderr,"mm_file_read called but no mock set. Aborting.");
+mm_file_t* mm_file_open(const char* fpath){
+  if(mock_mm_file_open == NULL){
+    fprintf(stderr,"mm_file_open called but no mock set. Aborting.");
     abort();
   }
   if(fpath==NULL){
-    mock_mm_file_read->param_1 = NULL;
+    mock_mm_file_open->param_1 = NULL;
   }
   else{
-    mock_mm_file_read->param_1 = malloc(strlen(fpath)+1);
-    strcpy(mock_mm_file_read->param_1, fpath);
+    mock_mm_file_open->param_1 = malloc(strlen(fpath)+1);
+    strcpy(mock_mm_file_open->param_1, fpath);
+  }
+  mock_mm_file_open->callcount++;
+  errno = mock_mm_file_open->set_errno_to;
+  if(mock_mm_file_open->retval == NULL){
+    return NULL;
+  }
+  mm_file_t* f = malloc(sizeof(mm_file_t));
+  f->content = mock_mm_file_open->retval;
+  return f;
+}
+
+const char* mm_file_data(const mm_file_t* f){
+  return f->content;
+}
+
+size_t mm_file_len(const mm_file_t* f){
+  return strlen(f->content);
+}
+
+void mm_file_close(mm_file_t* f){
+  if(mock_mm_file_close == NULL){
+    fprintf(stderr,"mm_file_close called but no mock set. Aborting.");
+    abort();
+  }
+  mock_mm_file_close->callcount++;
+  if(f != NULL){
+    free(f->content);
+    free(f);
   }
-  mock_mm_file_read->callcount++;
-  errno = mock_mm_file_read->set_errno_to;
-  return mock_mm_file_read->retval;
 }
 
-tok_t* get_tokenizer(char* s, char* delim){
+tok_t* get_tokenizer_parallel(const char* s, size_t len, char* delim,
+                              unsigned n_shards){
+  (void)(n_shards);
   if(mock_get_tokenizer == NULL){
-    fprintf(stderr,"get_tokenizer called but no mock set. Aborting.");
+    fprintf(stderr,"get_tokenizer_parallel called but no mock set. Aborting.");
     abort();
   }
   if(s==NULL){
-    mock_get_tokenizer->param_1 = s;
+    mock_get_tokenizer->param_1 = NULL;
   }
   else{
-    mock_get_tokenizer->param_1 = malloc(strlen(s)+1);
-    strcpy(mock_get_tokenizer->param_1, s);
+    mock_get_tokenizer->param_1 = malloc(len+1);
+    memcpy(mock_get_tokenizer->param_1, s, len);
+    mock_get_tokenizer->param_1[len] = '\0';
   }
   if(delim==NULL){
     mock_get_tokenizer->param_2 = delim;
@@ -58,6 +92,44 @@ tok_t* get_tokenizer(char* s, char* delim){
   return mock_get_tokenizer->retval;
 }
 
+tok_t* get_stream_tokenizer(const char* fpath, char* delim){
+  (void)(delim);
+  if(mock_get_stream_tokenizer == NULL){
+    fprintf(stderr,"get_stream_tokenizer called but no mock set. Aborting.");
+    abort();
+  }
+  if(fpath==NULL){
+    mock_get_stream_tokenizer->param_1 = NULL;
+  }
+  else{
+    mock_get_stream_tokenizer->param_1 = malloc(strlen(fpath)+1);
+    strcpy(mock_get_stream_tokenizer->param_1, fpath);
+  }
+  mock_get_stream_tokenizer->callcount++;
+  errno = mock_get_stream_tokenizer->set_errno_to;
+  return mock_get_stream_tokenizer->retval;
+}
+
+int tok_error(tok_t* tok){
+  (void)(tok);
+  if(mock_tok_error == NULL){
+    fprintf(stderr,"tok_error called but no mock set. Aborting.");
+    abort();
+  }
+  mock_tok_error->callcount++;
+  return mock_tok_error->retval;
+}
+
+int tok_count(tok_t* tok){
+  (void)(tok);
+  if(mock_tok_count == NULL){
+    fprintf(stderr,"tok_count called but no mock set. Aborting.");
+    abort();
+  }
+  mock_tok_count->callcount++;
+  return mock_tok_count->retval;
+}
+
 char* n_tok(tok_t* tok){
   if(mock_n_tok == NULL){
     fprintf(stderr,"n_tok called but no mock set. Aborting.");
@@ -74,6 +146,41 @@ char* n_tok(tok_t* tok){
   return mock_n_tok->retval;
 }
 
+int reload_tok(tok_t* tok, const char* s, size_t len, char* delim,
+               unsigned n_shards){
+  (void)(s);
+  (void)(len);
+  (void)(delim);
+  (void)(n_shards);
+  if(mock_reload_tok == NULL){
+    fprintf(stderr,"reload_tok called but no mock set. Aborting.");
+    abort();
+  }
+  mock_reload_tok->param_1 = tok;
+  mock_reload_tok->callcount++;
+  return mock_reload_tok->retval;
+}
+
+tok_t* get_tokenizer_n(const char* s, size_t len, char* delim){
+  return get_tokenizer_parallel(s, len, delim, 1);
+}
+
+char* tok_at(tok_t* tok, int i){
+  (void)(tok);
+  (void)(i);
+  fprintf(stderr,"tok_at called but not mocked. Aborting.");
+  abort();
+}
+
+void reset_tok(tok_t* tok){
+  if(mock_reset_tok == NULL){
+    fprintf(stderr,"reset_tok called but no mock set. Aborting.");
+    abort();
+  }
+  mock_reset_tok->param_1 = tok;
+  mock_reset_tok->callcount++;
+}
+
 void free_tok(tok_t* tok){
   if(mock_free_tok == NULL){
     fprintf(stderr,"free_tok called but no mock set. Aborting.");
@@ -88,6 +195,6 @@ char* get_latest_aoc_err_msg(){
     fprintf(stderr,"get_latest_aoc_err_msg called but no mock set. Aborting.");
     abort();
   }
-  mock_free_tok->callcount++;
+  mock_get_latest_aoc_err_msg->callcount++;
   return mock_get_latest_aoc_err_msg->retval;
 }
@@ -14,14 +14,25 @@ struct tokintern{
   unsigned id;
 };
 
-struct mock_mm_file_read_t{
+// Mapped file mock, owns the content handed to mm_file_open
+struct mm_file{
+  char* content;
+};
+
+struct mock_mm_file_open_t{
   char* retval;
   char* param_1;
   int callcount;
   int set_errno_to;
 };
 
-extern struct mock_mm_file_read_t* mock_mm_file_read;
+extern struct mock_mm_file_open_t* mock_mm_file_open;
+
+struct mock_mm_file_close_t{
+  int callcount;
+};
+
+extern struct mock_mm_file_close_t* mock_mm_file_close;
 
 struct mock_get_tokenizer_t{
   tok_t* retval;
@@ -32,6 +43,29 @@ struct mock_get_tokenizer_t{
 
 extern struct mock_get_tokenizer_t* mock_get_tokenizer;
 
+struct mock_get_stream_tokenizer_t{
+  tok_t* retval;
+  char* param_1;
+  int callcount;
+  int set_errno_to;
+};
+
+extern struct mock_get_stream_tokenizer_t* mock_get_stream_tokenizer;
+
+struct mock_tok_error_t{
+  int retval;
+  int callcount;
+};
+
+extern struct mock_tok_error_t* mock_tok_error;
+
+struct mock_tok_count_t{
+  int retval;
+  int callcount;
+};
+
+extern struct mock_tok_count_t* mock_tok_count;
+
 struct mock_n_tok_t{
   char* retval;
   tok_t* param_1;
@@ -40,6 +74,13 @@ struct mock_n_tok_t{
 
 extern struct mock_n_tok_t* mock_n_tok;
 
+struct mock_reset_tok_t{
+  tok_t* param_1;
+  int callcount;
+};
+
+extern struct mock_reset_tok_t* mock_reset_tok;
+
 struct mock_free_tok_t{
   tok_t* param_1;
   int callcount;
@@ -47,6 +88,14 @@ struct mock_free_tok_t{
 
 extern struct mock_free_tok_t* mock_free_tok;
 
+struct mock_reload_tok_t{
+  tok_t* param_1;
+  int retval;
+  int callcount;
+};
+
+extern struct mock_reload_tok_t* mock_reload_tok;
+
 struct mock_get_latest_aoc_err_msg_t{
   int callcount;
   char* retval;
@@ -0,0 +1,113 @@
+/**
+ * @file delim_scan.c
+ * @brief Implementation of the SIMD delimiter scanner
+ */
+
+#include "delim_scan.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DS_X86
+#include <immintrin.h>
+#endif
+
+static uint64_t mask64_scalar(const delim_set_t* set, const char* s){
+  uint64_t mask = 0;
+  for(unsigned i = 0; i < 64; i++){
+    mask |= (uint64_t) set->is_delim[(unsigned char) s[i]] << i;
+  }
+  return mask;
+}
+
+#ifdef DS_X86
+__attribute__((target("sse2")))
+static uint64_t mask64_sse2(const delim_set_t* set, const char* s){
+  uint64_t mask = 0;
+  for(unsigned block = 0; block < 4; block++){
+    __m128i in = _mm_loadu_si128((const __m128i*) (s + 16*block));
+    __m128i hits = _mm_setzero_si128();
+    for(unsigned i = 0; i < set->n; i++){
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(in, _mm_set1_epi8(set->chars[i])));
+    }
+    mask |= (uint64_t) (uint16_t) _mm_movemask_epi8(hits) << (16*block);
+  }
+  return mask;
+}
+
+__attribute__((target("avx2")))
+static uint64_t mask64_avx2(const delim_set_t* set, const char* s){
+  __m256i lo = _mm256_loadu_si256((const __m256i*) s);
+  __m256i hi = _mm256_loadu_si256((const __m256i*) (s + 32));
+  __m256i hits_lo = _mm256_setzero_si256();
+  __m256i hits_hi = _mm256_setzero_si256();
+  for(unsigned i = 0; i < set->n; i++){
+    __m256i c = _mm256_set1_epi8(set->chars[i]);
+    hits_lo = _mm256_or_si256(hits_lo, _mm256_cmpeq_epi8(lo, c));
+    hits_hi = _mm256_or_si256(hits_hi, _mm256_cmpeq_epi8(hi, c));
+  }
+  return (uint64_t) (uint32_t) _mm256_movemask_epi8(hits_lo)
+    | (uint64_t) (uint32_t) _mm256_movemask_epi8(hits_hi) << 32;
+}
+#endif
+
+static bool impl_supported(ds_impl_t impl){
+  switch(impl){
+  case DS_SCALAR:
+    return true;
+#ifdef DS_X86
+  case DS_SSE2:
+    return __builtin_cpu_supports("sse2");
+  case DS_AVX2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+int ds_init_impl(delim_set_t* set, const char* delim, ds_impl_t impl){
+  if(delim == NULL || *delim == '\0' || !impl_supported(impl)){
+    return -1;
+  }
+  memset(set->is_delim, 0, sizeof(set->is_delim));
+  set->n = 0;
+  for(const char* c = delim; *c != '\0'; c++){
+    if(!set->is_delim[(unsigned char) *c]){
+      set->is_delim[(unsigned char) *c] = true;
+      if(set->n < DS_SIMD_MAX){
+        set->chars[set->n] = *c;
+      }
+      set->n++;
+    }
+  }
+  if(set->n > DS_SIMD_MAX){
+    // Too many compares per block, the lookup table wins
+    impl = DS_SCALAR;
+  }
+  set->impl = impl;
+  switch(impl){
+#ifdef DS_X86
+  case DS_SSE2:
+    set->mask64 = mask64_sse2;
+    break;
+  case DS_AVX2:
+    set->mask64 = mask64_avx2;
+    break;
+#endif
+  default:
+    set->mask64 = mask64_scalar;
+    break;
+  }
+  return 0;
+}
+
+int ds_init(delim_set_t* set, const char* delim){
+  for(int impl = DS_AVX2; impl > DS_SCALAR; impl--){
+    if(impl_supported(impl)){
+      return ds_init_impl(set, delim, impl);
+    }
+  }
+  return ds_init_impl(set, delim, DS_SCALAR);
+}
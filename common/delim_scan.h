@@ -0,0 +1,66 @@
+/**
+ * @file delim_scan.h
+ * @brief SIMD delimiter scanner with runtime CPU dispatch.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Delimiter sets with more characters than this are always scanned
+ * with the scalar implementation.
+ */
+#define DS_SIMD_MAX 4
+
+/**
+ * Scanner implementations, in order of preference.
+ */
+typedef enum ds_impl{DS_SCALAR, DS_SSE2, DS_AVX2} ds_impl_t;
+
+typedef struct delim_set{
+  bool is_delim[256];
+  unsigned n;
+  char chars[DS_SIMD_MAX];
+  ds_impl_t impl;
+  uint64_t (*mask64)(const struct delim_set* set, const char* s);
+} delim_set_t;
+
+/**
+ * @brief Initialize @e set for the delimiter characters in @e delim
+ *
+ * Picks the fastest scanner implementation the CPU supports.
+ *
+ * @param set The set to initialize
+ * @param delim Null terminated delimiter characters, must not be empty
+ * @returns 0 on success, -1 if @e delim is empty
+ */
+int ds_init(delim_set_t* set, const char* delim);
+
+/**
+ * @brief Initialize @e set with a specific scanner implementation
+ *
+ * Mostly useful for testing the implementations against each other.
+ *
+ * @param set The set to initialize
+ * @param delim Null terminated delimiter characters, must not be empty
+ * @param impl The implementation to use
+ * @returns 0 on success, -1 if @e delim is empty or the CPU does not
+ *          support @e impl
+ */
+int ds_init_impl(delim_set_t* set, const char* delim, ds_impl_t impl);
+
+/**
+ * @brief Returns the delimiter mask of the 64 bytes starting at @e s
+ *
+ * Bit i of the result is set if s[i] is one of the delimiters. All
+ * 64 bytes must be readable.
+ *
+ * @param set The delimiter set
+ * @param s Start of the 64 byte block
+ * @returns The delimiter mask of the block
+ */
+static inline uint64_t ds_mask64(const delim_set_t* set, const char* s){
+  return set->mask64(set, s);
+}
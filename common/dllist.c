@@ -14,29 +14,97 @@ struct node{
   node_t* prev;
 };
 
+/**
+ * A contiguous block of nodes. The nodes of a list are handed out from
+ * its slabs front to back, removed nodes go on the list's free list.
+ */
+struct slab{
+  struct slab* next;
+  size_t cap;
+  size_t used;
+  node_t nodes[];
+};
+
 struct dllist{
   node_t* head;
   node_t* tail;
+  node_t* free;
+  struct slab* slabs;
+  size_t cap;
 };
 
+static struct slab* new_slab(size_t cap){
+  struct slab* slab = malloc(sizeof(struct slab) + cap*sizeof(node_t));
+  if(slab == NULL){
+    return NULL;
+  }
+  slab->next = NULL;
+  slab->cap = cap;
+  slab->used = 0;
+  return slab;
+}
+
 dllist_t* init_list(){
+  return init_list_with_capacity(0);
+}
+
+dllist_t* init_list_with_capacity(size_t capacity){
   dllist_t* newlist = malloc(sizeof(dllist_t));
+  if(newlist == NULL){
+    return NULL;
+  }
   newlist->tail = NULL;
   newlist->head = NULL;
+  newlist->free = NULL;
+  newlist->slabs = NULL;
+  newlist->cap = 0;
+  if(capacity > 0){
+    newlist->slabs = new_slab(capacity);
+    if(newlist->slabs == NULL){
+      free(newlist);
+      return NULL;
+    }
+    newlist->cap = capacity;
+  }
   return newlist;
 }
 
 void free_dllist(dllist_t* l){
-  node_t* curr = head(l);
-  node_t* prev = NULL;
-  while(curr != NULL){
-    prev = curr;
-    curr = next(curr);
-    free(prev);
+  if(l == NULL){
+    return;
+  }
+  struct slab* slab = l->slabs;
+  while(slab != NULL){
+    struct slab* next_slab = slab->next;
+    free(slab);
+    slab = next_slab;
   }
   free(l);
 }
 
+/**
+ * Takes a node from the free list or the newest slab. When both are
+ * exhausted, a new slab doubles the list's capacity.
+ */
+static node_t* alloc_node(dllist_t* l){
+  if(l->free != NULL){
+    node_t* n = l->free;
+    l->free = n->next;
+    return n;
+  }
+  if(l->slabs == NULL || l->slabs->used == l->slabs->cap){
+    size_t cap = l->cap < DLLIST_MIN_SLAB ? DLLIST_MIN_SLAB : l->cap;
+    struct slab* slab = new_slab(cap);
+    if(slab == NULL){
+      return NULL;
+    }
+    slab->next = l->slabs;
+    l->slabs = slab;
+    l->cap += cap;
+  }
+  return &l->slabs->nodes[l->slabs->used++];
+}
+
 void* data(const node_t* n){
   if(n == NULL){
     return NULL;
@@ -48,7 +116,10 @@ node_t* append(dllist_t* l, void* data){
   if(l == NULL){
     return NULL;
   }
-  node_t* newnode = malloc(sizeof(node_t));
+  node_t* newnode = alloc_node(l);
+  if(newnode == NULL){
+    return NULL;
+  }
   newnode->data = data;
   newnode->next = NULL;
   if(l->head == NULL){
@@ -81,7 +152,8 @@ node_t* remove_node(dllist_t* l, node_t* n){
   if(head(l) == n){
     l->head = successor;
   }
-  free(n);
+  n->next = l->free;
+  l->free = n;
   return successor;
 }
 
@@ -106,3 +178,7 @@ node_t* head(dllist_t* l){
 node_t* tail(dllist_t* l){
   return l->tail;
 }
+
+size_t capacity(const dllist_t* l){
+  return l->cap;
+}
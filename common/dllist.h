@@ -3,23 +3,47 @@
  * @brief Double Linked List for AoC
  */
 
+#include <stddef.h>
+
 struct dllist;
 typedef struct dllist dllist_t;
 
 struct node;
 typedef struct node node_t;
 
+/**
+ * Minimum number of nodes a list allocates at once when it runs out of
+ * nodes.
+ */
+#define DLLIST_MIN_SLAB 64
+
 /**
  * @brief Initialize empty Double Linked List
  *
- * @returns An empty dllist
+ * The nodes of the list are taken from slabs of contiguous memory, which
+ * are allocated as the list grows.
+ *
+ * @returns An empty dllist or NULL on error
  */
 dllist_t* init_list();
 
+/**
+ * @brief Initialize empty Double Linked List with room for @e capacity nodes
+ *
+ * Reserves a single slab for @e capacity nodes up front, so lists which
+ * never hold more nodes never allocate again, and their nodes lie
+ * next to each other in memory in the order they were appended.
+ *
+ * @param capacity The number of nodes to reserve, may be 0
+ * @returns An empty dllist or NULL on error
+ */
+dllist_t* init_list_with_capacity(size_t capacity);
+
 /**
  * @brief Frees an entire dllist
  *
- * This function frees all memory allocated by the list.
+ * This function frees all memory allocated by the list, in one call to
+ * free per slab.
  *
  * NOTE: The user needs to free the actual data.
  */
@@ -41,7 +65,7 @@ void* data(const node_t* n);
  *
  * @param l The list to append the new node to
  * @param data The data the node should store
- * @returns A pointer to the newly inserted node
+ * @returns A pointer to the newly inserted node or NULL on error
  */
 node_t* append(dllist_t* l, void* data);
 
@@ -51,7 +75,9 @@ node_t* append(dllist_t* l, void* data);
  * Node @e n is removed from the list, connecting it's successor
  * with it's predecessor.
  *
- * The returned node is @e n's successor.
+ * The returned node is @e n's successor. @e n itself is put on the
+ * list's free list and reused by the next append, so it must not be
+ * used anymore.
  *
  * @param n The node to remove
  * @returns @e n's former successor
@@ -95,3 +121,13 @@ node_t* head(dllist_t* l);
  * @returns The last node of @e l or NULL if @e l is empty
  */
 node_t* tail(dllist_t* l);
+
+/**
+ * @brief Returns the number of nodes @e l has room for
+ *
+ * Includes nodes in use, removed nodes and nodes not handed out yet.
+ *
+ * @param l The list
+ * @returns The node capacity of @e l
+ */
+size_t capacity(const dllist_t* l);
@@ -0,0 +1,543 @@
+/**
+ * @file fastparse.c
+ * @brief Implementation of the decimal integer parsers
+ */
+
+#include "fastparse.h"
+
+#include "delim_scan.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FP_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * Numbers with this many digits always fit into 64 bits
+ */
+#define SAFE_DIGITS 19
+
+/**
+ * Bytes the digit kernels read, regardless of the length of the number
+ */
+#define KERNEL_WIDTH 16
+
+static inline unsigned digit(char c){
+  // Wraps around for characters below '0', so a single compare suffices
+  return (unsigned) (unsigned char) c - '0';
+}
+
+/**
+ * A digit kernel converts the run of up to KERNEL_WIDTH digits at the
+ * start of @e s into @e val and returns its length. It may read all
+ * KERNEL_WIDTH bytes of @e s.
+ */
+typedef unsigned (*digits_fn)(const char* s, uint64_t* val);
+
+static unsigned digits_scalar(const char* s, uint64_t* val){
+  uint64_t res = 0;
+  unsigned n = 0;
+  unsigned d;
+  while(n < KERNEL_WIDTH && (d = digit(s[n])) < 10){
+    res = 10*res + d;
+    n++;
+  }
+  *val = res;
+  return n;
+}
+
+static const uint64_t pow10[] = {
+  1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u
+};
+
+/**
+ * Converts the first @e n digits of @e chunk, one per byte with values
+ * 0 to 9 and the first digit in the lowest byte, into their value.
+ */
+static inline uint64_t swar_convert(uint64_t chunk, unsigned n){
+  // Shift in leading zeros, so the number always has eight digits
+  chunk <<= 8*(8 - n);
+  chunk = (chunk * 10 + (chunk >> 8)) & 0x00ff00ff00ff00ffu;
+  chunk = (chunk * 100 + (chunk >> 16)) & 0x0000ffff0000ffffu;
+  return (chunk * 10000 + (chunk >> 32)) & 0xffffffffu;
+}
+
+/**
+ * Number of leading digits of the eight bytes in @e chunk, which holds
+ * the bytes with '0' already subtracted.
+ */
+static inline unsigned swar_count(uint64_t chunk){
+  // The high bit of a byte ends up set iff the byte is 10 or more
+  uint64_t non_digit = (((chunk & 0x7f7f7f7f7f7f7f7fu) + 0x7676767676767676u)
+                        | chunk) & 0x8080808080808080u;
+  return non_digit == 0 ? 8 : __builtin_ctzll(non_digit) / 8;
+}
+
+static unsigned digits_swar(const char* s, uint64_t* val){
+  uint64_t lo;
+  uint64_t hi;
+  memcpy(&lo, s, 8);
+  memcpy(&hi, s + 8, 8);
+  lo -= 0x3030303030303030u;
+  hi -= 0x3030303030303030u;
+  unsigned n = swar_count(lo);
+  if(n == 0){
+    *val = 0;
+    return 0;
+  }
+  *val = swar_convert(lo, n);
+  if(n < 8){
+    return n;
+  }
+  unsigned m = swar_count(hi);
+  if(m > 0){
+    *val = *val * pow10[m] + swar_convert(hi, m);
+  }
+  return 8 + m;
+}
+
+#ifdef FP_X86
+/**
+ * Shuffle masks moving the first n bytes to the end of the vector and
+ * zeroing the others, indexed by n
+ */
+static const int8_t right_align[KERNEL_WIDTH + 1][KERNEL_WIDTH]
+__attribute__((aligned(16))) = {
+#define RA(n, i) ((i) < KERNEL_WIDTH - (n) ? -1 : (i) - (KERNEL_WIDTH - (n)))
+#define RA_ROW(n) {RA(n, 0), RA(n, 1), RA(n, 2), RA(n, 3), RA(n, 4), \
+    RA(n, 5), RA(n, 6), RA(n, 7), RA(n, 8), RA(n, 9), RA(n, 10), \
+    RA(n, 11), RA(n, 12), RA(n, 13), RA(n, 14), RA(n, 15)}
+  RA_ROW(0), RA_ROW(1), RA_ROW(2), RA_ROW(3), RA_ROW(4), RA_ROW(5),
+  RA_ROW(6), RA_ROW(7), RA_ROW(8), RA_ROW(9), RA_ROW(10), RA_ROW(11),
+  RA_ROW(12), RA_ROW(13), RA_ROW(14), RA_ROW(15), RA_ROW(16)
+#undef RA_ROW
+#undef RA
+};
+
+/**
+ * The 128 bit kernel, shared by the SSE4.1 and AVX2 variants. Finds the
+ * digit run with one compare, right aligns it with a shuffle and then
+ * combines pairs of digits, pairs of those and so on with multiply-adds.
+ */
+#define DIGITS_SIMD_BODY                                                  \
+  __m128i in = _mm_sub_epi8(_mm_loadu_si128((const __m128i*) s),         \
+                            _mm_set1_epi8('0'));                          \
+  /* Unsigned compare, bytes below '0' wrapped around to large values */ \
+  __m128i non_digit = _mm_cmpeq_epi8(_mm_max_epu8(in, _mm_set1_epi8(10)), \
+                                     in);                                 \
+  unsigned mask = (unsigned) _mm_movemask_epi8(non_digit);                \
+  unsigned n = mask == 0 ? KERNEL_WIDTH : (unsigned) __builtin_ctz(mask); \
+  __m128i digits = _mm_shuffle_epi8(                                      \
+    in, _mm_load_si128((const __m128i*) right_align[n]));                 \
+  __m128i pairs = _mm_maddubs_epi16(                                      \
+    digits, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1,                     \
+                          10, 1, 10, 1, 10, 1, 10, 1));                   \
+  __m128i quads = _mm_madd_epi16(                                         \
+    pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));               \
+  quads = _mm_packus_epi32(quads, quads);                                 \
+  __m128i octs = _mm_madd_epi16(                                          \
+    quads, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));       \
+  *val = (uint64_t) (uint32_t) _mm_cvtsi128_si32(octs) * 100000000u       \
+    + (uint32_t) _mm_extract_epi32(octs, 1);                              \
+  return n;
+
+__attribute__((target("sse4.1")))
+static unsigned digits_sse41(const char* s, uint64_t* val){
+  DIGITS_SIMD_BODY
+}
+
+__attribute__((target("avx2")))
+static unsigned digits_avx2(const char* s, uint64_t* val){
+  DIGITS_SIMD_BODY
+}
+#undef DIGITS_SIMD_BODY
+#endif
+
+/**
+ * Lines fp_sum_lines_i64 collects before handing them to a chunk kernel.
+ * Their numbers have at most eight digits, so the sum of a batch always
+ * fits and only its addition to the total needs an overflow check.
+ */
+#define SUM_BATCH 256
+
+/**
+ * A chunk kernel sums @e n numbers of eight digits, given as chunks
+ * like those of swar_convert with the leading zeros shifted in.
+ * @e negative holds all ones for negative numbers and zero otherwise.
+ */
+typedef int64_t (*chunks_fn)(const uint64_t* chunks, const uint64_t* negative,
+                             size_t n);
+
+static int64_t chunks_scalar(const uint64_t* chunks, const uint64_t* negative,
+                             size_t n){
+  int64_t sum = 0;
+  for(size_t i = 0; i < n; i++){
+    uint64_t val = 0;
+    for(unsigned b = 0; b < 8; b++){
+      val = 10*val + ((chunks[i] >> 8*b) & 0xffu);
+    }
+    // Two's complement negation, if the mask is all ones
+    sum += (int64_t) ((val ^ negative[i]) - negative[i]);
+  }
+  return sum;
+}
+
+static int64_t chunks_swar(const uint64_t* chunks, const uint64_t* negative,
+                           size_t n){
+  int64_t sum = 0;
+  for(size_t i = 0; i < n; i++){
+    uint64_t val = swar_convert(chunks[i], 8);
+    sum += (int64_t) ((val ^ negative[i]) - negative[i]);
+  }
+  return sum;
+}
+
+#ifdef FP_X86
+/**
+ * The SIMD chunk kernels convert a chunk per 64 bit lane like the digit
+ * kernels, then multiply the upper half of the digits by 10000 and add
+ * the lower one. The lanes accumulate the sum of their chunks.
+ */
+__attribute__((target("sse4.1")))
+static int64_t chunks_sse41(const uint64_t* chunks, const uint64_t* negative,
+                            size_t n){
+  const __m128i tens = _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1,
+                                     10, 1, 10, 1, 10, 1, 10, 1);
+  const __m128i hundreds = _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1);
+  const __m128i myriads = _mm_set1_epi64x(10000);
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+  for(; i + 2 <= n; i += 2){
+    __m128i digits = _mm_loadu_si128((const __m128i*) (chunks + i));
+    __m128i neg = _mm_loadu_si128((const __m128i*) (negative + i));
+    __m128i quads = _mm_madd_epi16(_mm_maddubs_epi16(digits, tens), hundreds);
+    __m128i vals = _mm_add_epi64(_mm_mul_epu32(quads, myriads),
+                                 _mm_srli_epi64(quads, 32));
+    acc = _mm_add_epi64(acc, _mm_sub_epi64(_mm_xor_si128(vals, neg), neg));
+  }
+  int64_t lanes[2];
+  _mm_storeu_si128((__m128i*) lanes, acc);
+  return lanes[0] + lanes[1] + chunks_swar(chunks + i, negative + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static int64_t chunks_avx2(const uint64_t* chunks, const uint64_t* negative,
+                           size_t n){
+  const __m256i tens = _mm256_setr_epi8(
+    10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1,
+    10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+  const __m256i hundreds = _mm256_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1,
+                                             100, 1, 100, 1, 100, 1, 100, 1);
+  const __m256i myriads = _mm256_set1_epi64x(10000);
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4){
+    __m256i digits = _mm256_loadu_si256((const __m256i*) (chunks + i));
+    __m256i neg = _mm256_loadu_si256((const __m256i*) (negative + i));
+    __m256i quads = _mm256_madd_epi16(_mm256_maddubs_epi16(digits, tens),
+                                      hundreds);
+    __m256i vals = _mm256_add_epi64(_mm256_mul_epu32(quads, myriads),
+                                    _mm256_srli_epi64(quads, 32));
+    acc = _mm256_add_epi64(acc,
+                           _mm256_sub_epi64(_mm256_xor_si256(vals, neg), neg));
+  }
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i*) lanes, acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+    + chunks_swar(chunks + i, negative + i, n - i);
+}
+#endif
+
+static bool impl_supported(fp_impl_t impl){
+  switch(impl){
+  case FP_IMPL_SCALAR:
+  case FP_IMPL_SWAR:
+    return true;
+#ifdef FP_X86
+  case FP_IMPL_SSE41:
+    return __builtin_cpu_supports("sse4.1");
+  case FP_IMPL_AVX2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+static unsigned digits_resolve(const char* s, uint64_t* val);
+
+static _Atomic(digits_fn) digits_kernel = digits_resolve;
+static _Atomic(chunks_fn) chunks_kernel = chunks_scalar;
+static _Atomic(fp_impl_t) kernel_impl = FP_IMPL_SCALAR;
+
+int fp_set_impl(fp_impl_t impl){
+  if(!impl_supported(impl)){
+    return -1;
+  }
+  digits_fn kernel;
+  chunks_fn chunks;
+  switch(impl){
+#ifdef FP_X86
+  case FP_IMPL_SSE41:
+    kernel = digits_sse41;
+    chunks = chunks_sse41;
+    break;
+  case FP_IMPL_AVX2:
+    kernel = digits_avx2;
+    chunks = chunks_avx2;
+    break;
+#endif
+  case FP_IMPL_SWAR:
+    kernel = digits_swar;
+    chunks = chunks_swar;
+    break;
+  default:
+    kernel = digits_scalar;
+    chunks = chunks_scalar;
+    break;
+  }
+  atomic_store_explicit(&kernel_impl, impl, memory_order_relaxed);
+  atomic_store_explicit(&chunks_kernel, chunks, memory_order_relaxed);
+  atomic_store_explicit(&digits_kernel, kernel, memory_order_relaxed);
+  return 0;
+}
+
+fp_impl_t fp_get_impl(void){
+  if(atomic_load_explicit(&digits_kernel, memory_order_relaxed)
+     == digits_resolve){
+    digits_resolve("", &(uint64_t){0});
+  }
+  return atomic_load_explicit(&kernel_impl, memory_order_relaxed);
+}
+
+/**
+ * Initial kernel, picks the best supported one on first use. Threads
+ * racing here all store the same choice.
+ */
+static unsigned digits_resolve(const char* s, uint64_t* val){
+  for(int impl = FP_IMPL_AVX2; impl > FP_IMPL_SCALAR; impl--){
+    if(fp_set_impl(impl) == 0){
+      break;
+    }
+  }
+  return digits_scalar(s, val);
+}
+
+/**
+ * Whether KERNEL_WIDTH bytes can be read from @e s. Reading past the end
+ * of a string is harmless as long as it stays within the same page.
+ */
+static inline bool kernel_readable(const char* s){
+  return ((uintptr_t) s & 4095u) <= 4096u - KERNEL_WIDTH;
+}
+
+__attribute__((no_sanitize_address))
+fp_status_t fp_parse_u64(const char* s, const char** end, uint64_t* val){
+  const char* p = s;
+  uint64_t res = 0;
+  unsigned d;
+  if(kernel_readable(s)){
+    digits_fn kernel = atomic_load_explicit(&digits_kernel,
+                                            memory_order_relaxed);
+    unsigned n = kernel(s, &res);
+    if(n < KERNEL_WIDTH){
+      if(end != NULL){
+        *end = s + n;
+      }
+      *val = res;
+      return n == 0 ? FP_NO_DIGITS : FP_OK;
+    }
+    p += n;
+  }
+  // Long numbers, or too close to a page end for the kernel
+  while((d = digit(*p)) < 10 && p - s < SAFE_DIGITS){
+    res = 10*res + d;
+    p++;
+  }
+  fp_status_t status = p == s ? FP_NO_DIGITS : FP_OK;
+  while((d = digit(*p)) < 10){
+    if(__builtin_mul_overflow(res, 10, &res)
+       || __builtin_add_overflow(res, d, &res)){
+      status = FP_OVERFLOW;
+    }
+    p++;
+  }
+  if(end != NULL){
+    *end = p;
+  }
+  *val = status == FP_OVERFLOW ? UINT64_MAX : res;
+  return status;
+}
+
+fp_status_t fp_parse_i64(const char* s, const char** end, int64_t* val){
+  bool negative = *s == '-';
+  const char* digits = s + (*s == '-' || *s == '+');
+  uint64_t mag;
+  const char* digits_end;
+  fp_status_t status = fp_parse_u64(digits, &digits_end, &mag);
+  if(status == FP_NO_DIGITS){
+    digits_end = s;
+    *val = 0;
+  }
+  else if(status == FP_OVERFLOW || mag > (uint64_t) INT64_MAX + negative){
+    status = FP_OVERFLOW;
+    *val = negative ? INT64_MIN : INT64_MAX;
+  }
+  else{
+    // Negating in unsigned arithmetic also covers INT64_MIN
+    *val = negative ? (int64_t) (0 - mag) : (int64_t) mag;
+  }
+  if(end != NULL){
+    *end = digits_end;
+  }
+  return status;
+}
+
+int fp_parse_all_u64(const char* s, const char** end, uint64_t* vals,
+                     int max){
+  int n = 0;
+  const char* p = s;
+  const char* after = s;
+  while(n < max){
+    while(*p != '\0' && digit(*p) >= 10){
+      p++;
+    }
+    if(*p == '\0'){
+      break;
+    }
+    const char* num = p;
+    if(fp_parse_u64(num, &p, &vals[n]) == FP_OVERFLOW){
+      after = num;
+      n = -1;
+      break;
+    }
+    after = p;
+    n++;
+  }
+  if(end != NULL){
+    *end = after;
+  }
+  return n;
+}
+
+int fp_parse_all_i64(const char* s, const char** end, int64_t* vals,
+                     int max){
+  int n = 0;
+  const char* p = s;
+  const char* after = s;
+  while(n < max){
+    while(*p != '\0' && digit(*p) >= 10
+          && !((*p == '-' || *p == '+') && digit(p[1]) < 10)){
+      p++;
+    }
+    if(*p == '\0'){
+      break;
+    }
+    const char* num = p;
+    if(fp_parse_i64(num, &p, &vals[n]) == FP_OVERFLOW){
+      after = num;
+      n = -1;
+      break;
+    }
+    after = p;
+    n++;
+  }
+  if(end != NULL){
+    *end = after;
+  }
+  return n;
+}
+
+/**
+ * Adds the sum of @e n collected numbers to @e total. Returns true if
+ * that overflows.
+ */
+static inline bool add_batch(chunks_fn kernel, const uint64_t* chunks,
+                             const uint64_t* negative, size_t n,
+                             int64_t* total){
+  return __builtin_add_overflow(*total, kernel(chunks, negative, n), total);
+}
+
+fp_status_t fp_sum_lines_i64(const char* s, size_t len, int64_t* sum,
+                             const char** bad){
+  // Picks the kernels on first use
+  fp_get_impl();
+  chunks_fn kernel = atomic_load_explicit(&chunks_kernel,
+                                          memory_order_relaxed);
+  delim_set_t newlines;
+  ds_init(&newlines, "\n");
+  uint64_t chunks[SUM_BATCH];
+  uint64_t negative[SUM_BATCH];
+  size_t batched = 0;
+  int64_t total = 0;
+  bool overflow = false;
+  fp_status_t status = FP_OK;
+  const char* end = s + len;
+  const char* line = s;
+  // The newlines are found a block at a time, so the lines don't depend
+  // on each other and their parsing overlaps
+  for(size_t block = 0; block <= len && status == FP_OK && !overflow;
+      block += 64){
+    uint64_t mask = 0;
+    if(len - block >= 64){
+      mask = ds_mask64(&newlines, s + block);
+    }
+    else{
+      for(size_t i = block; i < len; i++){
+        mask |= (uint64_t) (s[i] == '\n') << (i - block);
+      }
+      // The last line may end without a newline
+      mask |= 1ull << (len - block);
+    }
+    while(mask != 0){
+      const char* nl = s + block + __builtin_ctzll(mask);
+      mask &= mask - 1;
+      if(nl == line){
+        line++;
+        continue;
+      }
+      const char* digits = line + (*line == '-' || *line == '+');
+      uint64_t chunk = 0;
+      unsigned n = 0;
+      if(end - digits >= 8){
+        memcpy(&chunk, digits, 8);
+        chunk -= 0x3030303030303030u;
+        n = swar_count(chunk);
+      }
+      if(n == 0 || (n == 8 && digit(digits[8]) < 10)){
+        // No number, one too long for the chunk kernels or one too close
+        // to the end to load a chunk
+        int64_t val;
+        status = fp_parse_i64(line, NULL, &val);
+        if(status != FP_OK){
+          break;
+        }
+        overflow |= __builtin_add_overflow(total, val, &total);
+      }
+      else{
+        chunks[batched] = chunk << 8*(8 - n);
+        negative[batched] = *line == '-' ? UINT64_MAX : 0;
+        if(++batched == SUM_BATCH){
+          overflow |= add_batch(kernel, chunks, negative, batched, &total);
+          batched = 0;
+        }
+      }
+      line = nl + 1;
+    }
+  }
+  if(status == FP_OK && !overflow){
+    overflow = add_batch(kernel, chunks, negative, batched, &total);
+  }
+  if(bad != NULL){
+    *bad = status == FP_OK ? NULL : line;
+  }
+  if(status == FP_OK && overflow){
+    status = FP_OVERFLOW;
+  }
+  *sum = status == FP_OK ? total : 0;
+  return status;
+}
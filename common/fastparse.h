@@ -0,0 +1,119 @@
+/**
+ * @file fastparse.h
+ * @brief Locale independent decimal integer parsing
+ *
+ * Replacement for strtol and sscanf on the hot parsing paths of the days.
+ * The parsers only accept plain ASCII decimals and never skip leading
+ * whitespace, which keeps them short and free of libc's locale handling.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Digit conversion kernels, in order of preference. SWAR converts eight
+ * digits at a time in a 64 bit integer, the SIMD variants sixteen at a
+ * time in a vector register.
+ */
+typedef enum fp_impl{
+  FP_IMPL_SCALAR,
+  FP_IMPL_SWAR,
+  FP_IMPL_SSE41,
+  FP_IMPL_AVX2,
+} fp_impl_t;
+
+typedef enum fp_status{
+  FP_OK,        ///< A number was parsed
+  FP_NO_DIGITS, ///< There was no digit where a number was expected
+  FP_OVERFLOW,  ///< The number does not fit the result type
+} fp_status_t;
+
+/**
+ * @brief Parses the unsigned decimal at the start of @e s
+ *
+ * Converts up to sixteen digits at once with the fastest kernel the CPU
+ * supports. The kernel may read up to 16 bytes from @e s, but never
+ * across a page boundary, so this is safe for any null terminated or
+ * otherwise delimited string.
+ *
+ * @param s The string to parse, a number must start at its first byte
+ * @param end If not NULL, set to the first byte behind the digits, or to
+ *        @e s if there were none
+ * @param val Set to the parsed value, or UINT64_MAX on overflow
+ * @returns FP_OK, FP_NO_DIGITS or FP_OVERFLOW
+ */
+fp_status_t fp_parse_u64(const char* s, const char** end, uint64_t* val);
+
+/**
+ * @brief Parses the signed decimal at the start of @e s
+ *
+ * Like fp_parse_u64, but accepts a single leading '+' or '-'. On
+ * overflow, @e val is set to INT64_MAX or INT64_MIN.
+ */
+fp_status_t fp_parse_i64(const char* s, const char** end, int64_t* val);
+
+/**
+ * @brief Parses up to @e max unsigned decimals from @e s
+ *
+ * Every run of digits in @e s is a number, everything else separates
+ * them. Stops at the end of @e s or after @e max numbers.
+ *
+ * @param s The null terminated string to parse
+ * @param end If not NULL, set to the first byte behind the last number,
+ *        or to the overflowing number on error
+ * @param vals Storage for @e max numbers
+ * @param max Maximum number of numbers to parse
+ * @returns The number of numbers parsed, or -1 if one of them overflowed
+ */
+int fp_parse_all_u64(const char* s, const char** end, uint64_t* vals,
+                     int max);
+
+/**
+ * @brief Parses up to @e max signed decimals from @e s
+ *
+ * Like fp_parse_all_u64, but a '+' or '-' directly in front of a digit
+ * is the sign of the number.
+ */
+int fp_parse_all_i64(const char* s, const char** end, int64_t* vals,
+                     int max);
+
+/**
+ * @brief Sums the signed decimals starting the lines of @e s
+ *
+ * Every non-empty line of the @e len bytes at @e s must start with a
+ * number fp_parse_i64 accepts, the rest of the line is ignored. Lines
+ * end with '\n', the last one may also end with @e s. Numbers of up to
+ * eight digits are collected in batches and summed by the selected
+ * kernel in 64 bit lanes, so overflow of the sum is checked once per
+ * batch instead of once per line.
+ *
+ * @param s The lines to sum, @e s[len] must be readable and no digit,
+ *        e.g. a terminating '\0'
+ * @param len Number of bytes of @e s
+ * @param sum Set to the sum on success, else to 0
+ * @param bad If not NULL, set to the line without a number or with an
+ *        overflowing number, NULL if there's none
+ * @returns FP_OK, FP_NO_DIGITS if a line has no number or FP_OVERFLOW if
+ *          a number or the sum doesn't fit 64 bits
+ */
+fp_status_t fp_sum_lines_i64(const char* s, size_t len, int64_t* sum,
+                             const char** bad);
+
+/**
+ * @brief Selects the digit conversion kernel used by all parsers
+ *
+ * By default, the fastest kernel the CPU supports is picked on first
+ * use. Mostly useful for testing and benchmarking the kernels against
+ * each other.
+ *
+ * @param impl The kernel to use
+ * @returns 0 on success, -1 if the CPU does not support @e impl
+ */
+int fp_set_impl(fp_impl_t impl);
+
+/**
+ * @brief Returns the digit conversion kernel in use
+ */
+fp_impl_t fp_get_impl(void);
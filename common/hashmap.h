@@ -0,0 +1,200 @@
+/**
+ * @file hashmap.h
+ * @brief Open addressing hash sets and maps for integer keys
+ *
+ * The tables are specialized for a key and value type with a macro, so
+ * hashing and probing are inlined and the entries are stored by value.
+ * Collisions are resolved by linear probing. All entries live in a
+ * single allocation, which is only replaced when the table grows.
+ *
+ * HASHSET_DEFINE(iset, long) defines the type iset_t with
+ *   * void iset_init(iset_t* s): Initialize an empty set, does not allocate
+ *   * int iset_reserve(iset_t* s, size_t n): Make room for @e n keys, so
+ *     the set doesn't grow until it holds more. 0 on success, -1 on error
+ *   * int iset_insert(iset_t* s, long key): 1 if @e key was inserted, 0 if
+ *     it was present already, -1 on error
+ *   * bool iset_contains(const iset_t* s, long key)
+ *   * size_t iset_len(const iset_t* s)
+ *   * void iset_free(iset_t* s): Free the entries, @e s is empty afterwards
+ *
+ * HASHMAP_DEFINE(imap, unsigned, size_t) defines imap_t with the same
+ * init, reserve, len and free functions, plus
+ *   * size_t* imap_get(const imap_t* m, unsigned key): Pointer to the value
+ *     of @e key or NULL if it isn't present
+ *   * size_t* imap_put(imap_t* m, unsigned key, bool* inserted): Pointer to
+ *     the value of @e key, which is inserted with a zeroed value if it
+ *     isn't present. Sets @e inserted accordingly if it isn't NULL.
+ *     NULL on error
+ *
+ * Pointers to values stay valid until the next insertion. There is no
+ * removal, the tables are meant to be filled and then dropped as a whole.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Minimum number of slots of a table which holds any entries
+ */
+#define HASH_MIN_CAP 16
+
+/**
+ * Mixes all bits of @e x into the low bits, which pick the slot
+ */
+static inline uint64_t hash_int(uint64_t x){
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9u;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebu;
+  return x ^ (x >> 31);
+}
+
+/**
+ * Number of slots for @e n entries, keeping the load at most 3/4
+ */
+static inline size_t hash_cap_for(size_t n){
+  size_t cap = HASH_MIN_CAP;
+  while(cap - cap/4 < n){
+    if(cap > SIZE_MAX/2){
+      return 0;
+    }
+    cap *= 2;
+  }
+  return cap;
+}
+
+/**
+ * Defines the parts shared by sets and maps: the table type, init, free,
+ * len, lookup of a key's slot and growing. @e val_size is 0 for sets.
+ * The values are stored first in the allocation, then the keys and then
+ * one byte per slot marking it as used.
+ */
+#define HASH__CORE(name, key_t, val_size)                                 \
+  typedef struct name{                                                    \
+    size_t cap;                                                           \
+    size_t len;                                                           \
+    void* vals;                                                           \
+    key_t* keys;                                                          \
+    unsigned char* used;                                                  \
+  } name##_t;                                                             \
+                                                                          \
+  static inline void name##_init(name##_t* t){                            \
+    *t = (name##_t) {0};                                                  \
+  }                                                                       \
+                                                                          \
+  static inline void name##_free(name##_t* t){                            \
+    free(t->vals);                                                        \
+    *t = (name##_t) {0};                                                  \
+  }                                                                       \
+                                                                          \
+  static inline size_t name##_len(const name##_t* t){                     \
+    return t->len;                                                        \
+  }                                                                       \
+                                                                          \
+  /* Slot of key or the empty slot where it would go. Needs cap > 0. */   \
+  static inline size_t name##__slot(const name##_t* t, key_t key){        \
+    size_t mask = t->cap - 1;                                             \
+    size_t i = hash_int((uint64_t) key) & mask;                           \
+    while(t->used[i] && t->keys[i] != key){                               \
+      i = (i + 1) & mask;                                                 \
+    }                                                                     \
+    return i;                                                             \
+  }                                                                       \
+                                                                          \
+  static inline int name##__resize(name##_t* t, size_t cap){              \
+    size_t vals_bytes = cap*(val_size);                                   \
+    unsigned char* mem = malloc(vals_bytes + cap*sizeof(key_t) + cap);    \
+    if(mem == NULL){                                                      \
+      return -1;                                                          \
+    }                                                                     \
+    name##_t grown = {                                                    \
+      .cap = cap,                                                         \
+      .len = t->len,                                                      \
+      .vals = mem,                                                        \
+      .keys = (key_t*) (mem + vals_bytes),                                \
+      .used = mem + vals_bytes + cap*sizeof(key_t),                       \
+    };                                                                    \
+    memset(grown.used, 0, cap);                                           \
+    for(size_t i = 0; i < t->cap; i++){                                   \
+      if(t->used[i]){                                                     \
+        size_t j = name##__slot(&grown, t->keys[i]);                      \
+        grown.used[j] = 1;                                                \
+        grown.keys[j] = t->keys[i];                                       \
+        memcpy((unsigned char*) grown.vals + j*(val_size),                \
+               (unsigned char*) t->vals + i*(val_size), (val_size));      \
+      }                                                                   \
+    }                                                                     \
+    name##_free(t);                                                       \
+    *t = grown;                                                           \
+    return 0;                                                             \
+  }                                                                       \
+                                                                          \
+  static inline int name##_reserve(name##_t* t, size_t n){                \
+    size_t cap = hash_cap_for(n);                                         \
+    if(cap == 0){                                                         \
+      return -1;                                                          \
+    }                                                                     \
+    return cap <= t->cap ? 0 : name##__resize(t, cap);                    \
+  }                                                                       \
+                                                                          \
+  /* Slot of key, inserting it if needed. SIZE_MAX on error. */           \
+  static inline size_t name##__insert(name##_t* t, key_t key,             \
+                                      bool* inserted){                    \
+    *inserted = false;                                                    \
+    if(t->cap - t->cap/4 <= t->len && name##_reserve(t, t->len + 1) != 0){ \
+      return SIZE_MAX;                                                    \
+    }                                                                     \
+    size_t i = name##__slot(t, key);                                      \
+    *inserted = !t->used[i];                                              \
+    if(*inserted){                                                        \
+      t->used[i] = 1;                                                     \
+      t->keys[i] = key;                                                   \
+      memset((unsigned char*) t->vals + i*(val_size), 0, (val_size));     \
+      t->len++;                                                           \
+    }                                                                     \
+    return i;                                                             \
+  }
+
+/**
+ * Defines the hash set type name##_t for keys of the integer type @e key_t
+ */
+#define HASHSET_DEFINE(name, key_t)                                       \
+  HASH__CORE(name, key_t, 0)                                              \
+                                                                          \
+  static inline int name##_insert(name##_t* s, key_t key){                \
+    bool inserted;                                                        \
+    return name##__insert(s, key, &inserted) == SIZE_MAX ? -1 : inserted; \
+  }                                                                       \
+                                                                          \
+  static inline bool name##_contains(const name##_t* s, key_t key){       \
+    return s->cap > 0 && s->used[name##__slot(s, key)];                   \
+  }
+
+/**
+ * Defines the hash map type name##_t from the integer type @e key_t to
+ * @e val_t
+ */
+#define HASHMAP_DEFINE(name, key_t, val_t)                                \
+  HASH__CORE(name, key_t, sizeof(val_t))                                  \
+                                                                          \
+  static inline val_t* name##_get(const name##_t* m, key_t key){          \
+    if(m->cap == 0){                                                      \
+      return NULL;                                                        \
+    }                                                                     \
+    size_t i = name##__slot(m, key);                                      \
+    return m->used[i] ? (val_t*) m->vals + i : NULL;                      \
+  }                                                                       \
+                                                                          \
+  static inline val_t* name##_put(name##_t* m, key_t key, bool* inserted){ \
+    bool ins;                                                             \
+    size_t i = name##__insert(m, key, &ins);                              \
+    if(inserted != NULL){                                                 \
+      *inserted = ins;                                                    \
+    }                                                                     \
+    return i == SIZE_MAX ? NULL : (val_t*) m->vals + i;                   \
+  }
@@ -0,0 +1,43 @@
+/**
+ * @file idxlist.c
+ * @brief Implementation of the index based Double Linked List
+ */
+
+#include "idxlist.h"
+
+void idxlist_init_full(idxlist_t* l, idx_link_t* links, uint32_t n){
+  l->links = links;
+  l->len = n;
+  l->head = n == 0 ? IDXLIST_NIL : 0;
+  l->tail = n == 0 ? IDXLIST_NIL : n - 1;
+  for(uint32_t i = 0; i < n; i++){
+    links[i].prev = i == 0 ? IDXLIST_NIL : i - 1;
+    links[i].next = i == n - 1 ? IDXLIST_NIL : i + 1;
+  }
+}
+
+uint32_t idxlist_remove(idxlist_t* l, uint32_t i){
+  idx_link_t* link = &l->links[i];
+  uint32_t successor = link->next;
+  if(link->prev == IDXLIST_NIL){
+    l->head = successor;
+  }
+  else{
+    l->links[link->prev].next = successor;
+  }
+  if(successor == IDXLIST_NIL){
+    l->tail = link->prev;
+  }
+  else{
+    l->links[successor].prev = link->prev;
+  }
+  // A link pointing to itself marks a removed element
+  link->next = i;
+  link->prev = i;
+  l->len--;
+  return successor;
+}
+
+bool idxlist_contains(const idxlist_t* l, uint32_t i){
+  return l->links[i].next != i;
+}
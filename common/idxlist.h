@@ -0,0 +1,84 @@
+/**
+ * @file idxlist.h
+ * @brief Index based Double Linked List for AoC
+ *
+ * Links the elements of a user's array by their indices. The links are
+ * kept in a separate array of 32 bit indices, so they take half the
+ * memory of pointer links and the user's array stays untouched.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Index returned when there is no such element
+ */
+#define IDXLIST_NIL UINT32_MAX
+
+typedef struct idx_link{
+  uint32_t next;
+  uint32_t prev;
+} idx_link_t;
+
+typedef struct idxlist{
+  uint32_t head;
+  uint32_t tail;
+  uint32_t len;
+  idx_link_t* links;
+} idxlist_t;
+
+/**
+ * @brief Initialize @e l with all of the indices 0 to @e n - 1, in order
+ *
+ * This is the usual starting point for candidate elimination: every
+ * element is a candidate, and they get removed as they are ruled out.
+ *
+ * @param l The list to initialize
+ * @param links Storage for @e n links, owned by the caller
+ * @param n The number of elements, must be less than IDXLIST_NIL
+ */
+void idxlist_init_full(idxlist_t* l, idx_link_t* links, uint32_t n);
+
+/**
+ * @brief Removes element @e i from @e l
+ *
+ * @e i must still be part of @e l, see idxlist_contains.
+ *
+ * @returns The successor of @e i or IDXLIST_NIL if it was the last one
+ */
+uint32_t idxlist_remove(idxlist_t* l, uint32_t i);
+
+/**
+ * @brief Returns whether element @e i is still part of @e l
+ */
+bool idxlist_contains(const idxlist_t* l, uint32_t i);
+
+/**
+ * @returns The first element of @e l or IDXLIST_NIL if @e l is empty
+ */
+static inline uint32_t idxlist_head(const idxlist_t* l){
+  return l->head;
+}
+
+/**
+ * @returns The last element of @e l or IDXLIST_NIL if @e l is empty
+ */
+static inline uint32_t idxlist_tail(const idxlist_t* l){
+  return l->tail;
+}
+
+/**
+ * @returns The successor of @e i or IDXLIST_NIL if it is the last one
+ */
+static inline uint32_t idxlist_next(const idxlist_t* l, uint32_t i){
+  return l->links[i].next;
+}
+
+/**
+ * @returns The predecessor of @e i or IDXLIST_NIL if it is the first one
+ */
+static inline uint32_t idxlist_prev(const idxlist_t* l, uint32_t i){
+  return l->links[i].prev;
+}
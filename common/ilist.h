@@ -0,0 +1,108 @@
+/**
+ * @file ilist.h
+ * @brief Intrusive Double Linked List for AoC
+ *
+ * The links are embedded in the user's struct as an ilist_link_t member,
+ * so walking the list needs no separate node and no data pointer. The
+ * list is circular around a sentinel link in the ilist_t, which is why
+ * none of the operations need to check for an empty list.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct ilist_link{
+  struct ilist_link* next;
+  struct ilist_link* prev;
+} ilist_link_t;
+
+typedef struct ilist{
+  ilist_link_t sentinel;
+} ilist_t;
+
+/**
+ * @brief Returns the struct of type @e type containing the link @e link
+ *
+ * @param link Pointer to the embedded link
+ * @param type Type of the containing struct
+ * @param member Name of the link member in @e type
+ */
+#define ILIST_ENTRY(link, type, member) \
+  ((type*) ((char*) (link) - offsetof(type, member)))
+
+/**
+ * @brief Initialize @e l as an empty list
+ */
+static inline void ilist_init(ilist_t* l){
+  l->sentinel.next = &l->sentinel;
+  l->sentinel.prev = &l->sentinel;
+}
+
+static inline bool ilist_empty(const ilist_t* l){
+  return l->sentinel.next == &l->sentinel;
+}
+
+/**
+ * @brief Appends @e link to the end of @e l
+ *
+ * @e link must not be part of any list.
+ */
+static inline void ilist_append(ilist_t* l, ilist_link_t* link){
+  link->prev = l->sentinel.prev;
+  link->next = &l->sentinel;
+  l->sentinel.prev->next = link;
+  l->sentinel.prev = link;
+}
+
+/**
+ * @brief Removes @e link from @e l
+ *
+ * @returns The successor of @e link or NULL if it was the last one
+ */
+static inline ilist_link_t* ilist_remove(ilist_t* l, ilist_link_t* link){
+  ilist_link_t* successor = link->next;
+  link->prev->next = successor;
+  successor->prev = link->prev;
+  link->next = NULL;
+  link->prev = NULL;
+  return successor == &l->sentinel ? NULL : successor;
+}
+
+/**
+ * @brief Returns whether @e link is currently part of a list
+ *
+ * Only meaningful for links which were zeroed or removed before.
+ */
+static inline bool ilist_linked(const ilist_link_t* link){
+  return link->next != NULL;
+}
+
+/**
+ * @returns The first link of @e l or NULL if @e l is empty
+ */
+static inline ilist_link_t* ilist_head(ilist_t* l){
+  return ilist_empty(l) ? NULL : l->sentinel.next;
+}
+
+/**
+ * @returns The last link of @e l or NULL if @e l is empty
+ */
+static inline ilist_link_t* ilist_tail(ilist_t* l){
+  return ilist_empty(l) ? NULL : l->sentinel.prev;
+}
+
+/**
+ * @returns The successor of @e link in @e l or NULL if it is the last one
+ */
+static inline ilist_link_t* ilist_next(ilist_t* l, const ilist_link_t* link){
+  return link->next == &l->sentinel ? NULL : link->next;
+}
+
+/**
+ * @returns The predecessor of @e link in @e l or NULL if it is the first one
+ */
+static inline ilist_link_t* ilist_prev(ilist_t* l, const ilist_link_t* link){
+  return link->prev == &l->sentinel ? NULL : link->prev;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file line_stream.c
+ * @brief Implementation of the streaming line source
+ */
+
+#include "line_stream.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+struct lstream{
+  int fd;
+  int error;
+  bool eof;
+  bool is_delim[256];
+  char* buf;
+  size_t cap;
+  size_t start;
+  size_t scan;
+  size_t end;
+  off_t offset;
+};
+
+lstream_t* ls_open(const char* fpath, const char* delim, size_t chunk_size){
+  if(delim == NULL || *delim == '\0'){
+    errno = EINVAL;
+    return NULL;
+  }
+  int fd = open(fpath, O_RDONLY);
+  if(fd == -1){
+    return NULL;
+  }
+  lstream_t* ls = malloc(sizeof(lstream_t));
+  if(ls == NULL){
+    close(fd);
+    return NULL;
+  }
+  ls->cap = chunk_size == 0 ? LS_DEFAULT_CHUNK : chunk_size;
+  // One extra byte for the terminator of a last line without delimiter
+  ls->buf = malloc(ls->cap + 1);
+  if(ls->buf == NULL){
+    free(ls);
+    close(fd);
+    return NULL;
+  }
+  memset(ls->is_delim, 0, sizeof(ls->is_delim));
+  for(const char* c = delim; *c != '\0'; c++){
+    ls->is_delim[(unsigned char) *c] = true;
+  }
+  ls->fd = fd;
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  ls_reset(ls);
+  return ls;
+}
+
+/**
+ * Moves the unconsumed rest of the buffer to the front and reads the
+ * next chunk behind it. The buffer is only grown when a single line
+ * fills all of it.
+ */
+static int refill(lstream_t* ls){
+  size_t rest = ls->end - ls->start;
+  if(ls->start > 0){
+    memmove(ls->buf, ls->buf + ls->start, rest);
+    ls->scan -= ls->start;
+    ls->start = 0;
+    ls->end = rest;
+  }
+  if(ls->end == ls->cap){
+    char* grown = realloc(ls->buf, 2*ls->cap + 1);
+    if(grown == NULL){
+      return -1;
+    }
+    ls->buf = grown;
+    ls->cap *= 2;
+  }
+  ssize_t n;
+  do{
+    n = pread(ls->fd, ls->buf + ls->end, ls->cap - ls->end, ls->offset);
+  } while(n == -1 && errno == EINTR);
+  if(n == -1){
+    return -1;
+  }
+  if(n == 0){
+    ls->eof = true;
+  }
+  ls->offset += n;
+  ls->end += n;
+  return 0;
+}
+
+char* ls_next(lstream_t* ls, size_t* len){
+  if(ls == NULL || ls->error != 0){
+    return NULL;
+  }
+  while(true){
+    while(ls->start < ls->end && ls->is_delim[(unsigned char) ls->buf[ls->start]]){
+      ls->start++;
+    }
+    if(ls->scan < ls->start){
+      ls->scan = ls->start;
+    }
+    while(ls->scan < ls->end && !ls->is_delim[(unsigned char) ls->buf[ls->scan]]){
+      ls->scan++;
+    }
+    if(ls->scan < ls->end || (ls->eof && ls->start < ls->end)){
+      // Either found a delimiter or the last line is not terminated
+      char* line = ls->buf + ls->start;
+      ls->buf[ls->scan] = '\0';
+      if(len != NULL){
+        *len = ls->scan - ls->start;
+      }
+      ls->start = ls->scan < ls->end ? ls->scan + 1 : ls->end;
+      ls->scan = ls->start;
+      return line;
+    }
+    if(ls->eof){
+      return NULL;
+    }
+    if(refill(ls) != 0){
+      ls->error = errno;
+      return NULL;
+    }
+  }
+}
+
+void ls_reset(lstream_t* ls){
+  ls->error = 0;
+  ls->eof = false;
+  ls->start = 0;
+  ls->scan = 0;
+  ls->end = 0;
+  ls->offset = 0;
+}
+
+int ls_error(const lstream_t* ls){
+  return ls->error;
+}
+
+void ls_close(lstream_t* ls){
+  if(ls == NULL){
+    return;
+  }
+  close(ls->fd);
+  free(ls->buf);
+  free(ls);
+}
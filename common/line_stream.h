@@ -0,0 +1,73 @@
+/**
+ * @file line_stream.h
+ * @brief Streaming line source for inputs which do not fit into memory.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+struct lstream;
+typedef struct lstream lstream_t;
+
+/**
+ * Default size of the chunks read from the input file.
+ */
+#define LS_DEFAULT_CHUNK (1024u*1024u)
+
+/**
+ * @brief Opens the file at @e fpath as a stream of lines
+ *
+ * The file is read in chunks of @e chunk_size bytes with pread, so
+ * the memory used by the stream does not depend on the file size.
+ * Only lines longer than @e chunk_size grow the internal buffer.
+ *
+ * Lines are split at any of the characters in @e delim. Just like with
+ * the tokenizer, runs of delimiters are skipped, so no empty lines are
+ * produced.
+ *
+ * The function returns NULL upon error, with errno set accordingly.
+ *
+ * @param fpath null terminated path to the file to stream
+ * @param delim Delimiter characters, must not be empty
+ * @param chunk_size Number of bytes to read at once, 0 for LS_DEFAULT_CHUNK
+ * @returns The new stream or NULL on error
+ */
+lstream_t* ls_open(const char* fpath, const char* delim, size_t chunk_size);
+
+/**
+ * @brief Returns the next line of @e ls
+ *
+ * The returned line is null terminated and only valid until the next
+ * call to ls_next, ls_reset or ls_close on @e ls.
+ *
+ * NULL is returned at the end of the input and on read errors. Use
+ * ls_error to tell them apart.
+ *
+ * @param ls The stream to read from
+ * @param len If not NULL, receives the length of the line
+ * @returns The next line or NULL
+ */
+char* ls_next(lstream_t* ls, size_t* len);
+
+/**
+ * @brief Rewinds @e ls to the start of the input
+ *
+ * @param ls The stream to rewind
+ */
+void ls_reset(lstream_t* ls);
+
+/**
+ * @brief Returns the errno of the last failed read on @e ls
+ *
+ * @param ls The stream to check
+ * @returns 0 if no read failed, the errno of the failed read otherwise
+ */
+int ls_error(const lstream_t* ls);
+
+/**
+ * @brief Closes the input file and frees @e ls
+ *
+ * @param ls The stream to close, may be NULL
+ */
+void ls_close(lstream_t* ls);
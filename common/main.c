@@ -5,82 +5,1081 @@
 
 #include "main.h"
 
+#include "alloc_count.h"
 #include "aoc_err.h"
 #include "aoc_streams.h"
+#include "arena.h"
 #include "mm_files.h"
+#include "perf_counters.h"
+#include "thread_pool.h"
+#include "trace.h"
 
 #include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static const char* usage = "Usage: %s 1|2 INPUT_FILE\n";
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Minimum number of input bytes per tokenizer shard
+ */
+#define AOC_MIN_SHARD_BYTES (16u*1024u*1024u)
+
+/**
+ * Upper limit for --jobs
+ */
+#define AOC_MAX_JOBS 1024
+
+/**
+ * Bits for the parts requested on the command line
+ */
+#define AOC_PART1 AOC_STREAM_PART1
+#define AOC_PART2 AOC_STREAM_PART2
+
+static const char* usage = "Usage: %s [--bench N | --manifest FILE | --stats] [--perf] [--trace FILE] [--jobs N] 1|2|both INPUT_FILE...\n";
 static const char* parterr = "Part %s requested but no part %s function provided.\n";
+static const char* preperr = "A prepare hook was provided but no prepared part %s function.\n";
+
+/**
+ * Options given on the command line before the part
+ */
+struct aoc_opts{
+  int bench_runs;
+  const char* manifest;
+  unsigned jobs;
+  bool stats;
+  bool perf;
+  const char* trace;
+};
+
+/**
+ * Phases of a run, as reported by --stats
+ */
+enum phase{
+  PHASE_LOAD,
+  PHASE_TOKENIZE,
+  PHASE_SOLVE,
+  PHASE_OUTPUT,
+  PHASE_CLEANUP,
+  N_PHASES,
+};
+
+static const char* phase_names[N_PHASES] = {
+  "load", "tokenize", "solve", "output", "cleanup"
+};
+
+/**
+ * Time and allocations spent in each phase of a run. A phase can be
+ * entered several times, e.g. solve and output alternate for both parts.
+ * If @e perf is set, its counters only run during the solve phase.
+ */
+struct run_stats{
+  perf_counters_t* perf;
+  enum phase current;
+  uint64_t start_ns;
+  alloc_count_t start_allocs;
+  uint64_t ns[N_PHASES];
+  alloc_count_t allocs[N_PHASES];
+};
+
+static uint64_t now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * Starts the first phase of @e st
+ */
+static void stats_start(struct run_stats* st, perf_counters_t* perf){
+  *st = (struct run_stats) {.perf = perf, .current = PHASE_LOAD};
+  alloc_count_get(&st->start_allocs);
+  TRACE_BEGIN(phase_names[PHASE_LOAD]);
+  st->start_ns = now_ns();
+}
+
+/**
+ * Adds the time and allocations since the start of the current phase
+ * of @e st to it and restarts the measurement.
+ */
+static void stats_account(struct run_stats* st){
+  uint64_t end = now_ns();
+  alloc_count_t allocs;
+  alloc_count_get(&allocs);
+  alloc_count_t* acc = &st->allocs[st->current];
+  st->ns[st->current] += end - st->start_ns;
+  acc->allocs += allocs.allocs - st->start_allocs.allocs;
+  acc->reallocs += allocs.reallocs - st->start_allocs.reallocs;
+  acc->frees += allocs.frees - st->start_allocs.frees;
+  acc->bytes += allocs.bytes - st->start_allocs.bytes;
+  st->start_allocs = allocs;
+  st->start_ns = now_ns();
+}
+
+/**
+ * Ends the current phase of @e st and starts @e next. Does nothing if
+ * @e st is NULL or already in @e next, so the runner can call it
+ * unconditionally.
+ */
+static void stats_enter(struct run_stats* st, enum phase next){
+  if(st == NULL || st->current == next){
+    return;
+  }
+  bool counting = st->current == PHASE_SOLVE;
+  if(st->perf != NULL && counting && next != PHASE_SOLVE){
+    perf_stop(st->perf);
+  }
+  TRACE_END();
+  stats_account(st);
+  TRACE_BEGIN(phase_names[next]);
+  st->current = next;
+  if(st->perf != NULL && !counting && next == PHASE_SOLVE){
+    perf_start(st->perf);
+  }
+}
+
+/**
+ * Ends the last phase of @e st
+ */
+static void stats_finish(struct run_stats* st){
+  if(st == NULL){
+    return;
+  }
+  if(st->perf != NULL && st->current == PHASE_SOLVE){
+    perf_stop(st->perf);
+  }
+  TRACE_END();
+  stats_account(st);
+}
+
+/**
+ * Returns the number of shards to tokenize an input of @e len bytes in.
+ * Only inputs of several shards' worth of data are worth the threads.
+ */
+static unsigned tokenizer_shards(size_t len){
+  long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t shards = len / AOC_MIN_SHARD_BYTES;
+  if(n_cpus > 0 && shards > (size_t) n_cpus){
+    shards = n_cpus;
+  }
+  return shards > 1 ? shards : 1;
+}
+
+/**
+ * Prints the latest AoC error after a failed day function call on the
+ * input at @e fpath, which is left out of the message if NULL, to @e err.
+ */
+static void report_error(FILE* err, const char* fpath){
+  fprintf(err, "Error in AoC function call");
+  if(fpath != NULL){
+    fprintf(err, " on %s", fpath);
+  }
+  char* latest_error = get_latest_aoc_err_msg();
+  if(latest_error == NULL){
+    fprintf(err, ".\n");
+  }
+  else{
+    fprintf(err,":\n%s\n",latest_error);
+    free(latest_error);
+  }
+}
+
+/**
+ * Prints the result of a day function, or the latest AoC error if
+ * the day function failed.
+ */
+static int print_result(const char* res){
+  if(res == NULL){
+    report_error(STDERR_STREAM, NULL);
+    return EXIT_FAILURE;
+  }
+  fprintf(STDOUT_STREAM, "%s\n", res);
+  return EXIT_SUCCESS;
+}
 
-int exec_dayfunc(const char* fpath, char* (*dayfunc)(tok_t*)){
-  char* content = mm_file_read(fpath);
+/**
+ * Like print_result, for heap allocated results. Frees @e res.
+ */
+static int report_result(char* res){
+  int ret = print_result(res);
+  free(res);
+  return ret;
+}
+
+/**
+ * Maps the input at @e fpath. Prints an error and returns NULL on failure.
+ */
+static mm_file_t* map_input(const char* fpath){
+  mm_file_t* input = mm_file_open(fpath);
   int error = errno;
-  if(content == NULL){
+  if(input == NULL){
     fprintf(STDERR_STREAM, "Error loading input from %s: %s\n",
             fpath, strerror(error));
-    return EXIT_FAILURE;
   }
-  tok_t* tok = get_tokenizer(content, "\n");
+  return input;
+}
+
+/**
+ * Loads the input at @e fpath and returns a tokenizer for it, either
+ * streaming or over the mapped file. In the latter case, @e input
+ * receives the mapped file. Prints an error and returns NULL on failure.
+ * Enters the tokenize phase of @e st, if given, once the file is loaded.
+ */
+static tok_t* load_input(const char* fpath, bool stream, mm_file_t** input,
+                         struct run_stats* st){
+  *input = NULL;
+  if(stream){
+    tok_t* tok = get_stream_tokenizer(fpath, "\n");
+    int error = errno;
+    if(tok == NULL){
+      fprintf(STDERR_STREAM, "Error loading input from %s: %s\n",
+              fpath, strerror(error));
+    }
+    return tok;
+  }
+  *input = map_input(fpath);
+  if(*input == NULL){
+    return NULL;
+  }
+  stats_enter(st, PHASE_TOKENIZE);
+  size_t len = mm_file_len(*input);
+  tok_t* tok = get_tokenizer_parallel(mm_file_data(*input), len, "\n",
+                                      tokenizer_shards(len));
   if(tok == NULL){
-    free(content);
+    mm_file_close(*input);
+    *input = NULL;
     fprintf(STDERR_STREAM, "Error initializing input tokenizer.\n");
+  }
+  return tok;
+}
+
+/**
+ * Reports the result of a day function run on a streaming tokenizer.
+ * A failed read invalidates the result.
+ */
+static int report_stream_result(const char* fpath, tok_t* tok, char* res){
+  int error = tok_error(tok);
+  if(error != 0){
+    free(res);
+    fprintf(STDERR_STREAM, "Error reading input from %s: %s\n",
+            fpath, strerror(error));
     return EXIT_FAILURE;
   }
-  char* res = dayfunc(tok);
-  free_tok(tok);
-  free(content);
-  if(res == NULL){
-    fprintf(STDERR_STREAM, "Error in AoC function call");
-    char* latest_error = get_latest_aoc_err_msg();
-    if(latest_error == NULL){
-      fprintf(STDERR_STREAM, ".\n");
+  return report_result(res);
+}
+
+/**
+ * Prints @e s as a JSON string to @e out
+ */
+static void print_json_string(FILE* out, const char* s){
+  fputc('"', out);
+  for(; *s != '\0'; s++){
+    if(*s == '"' || *s == '\\'){
+      fprintf(out, "\\%c", *s);
+    }
+    else if((unsigned char) *s < 0x20){
+      fprintf(out, "\\u%04x", (unsigned char) *s);
+    }
+    else{
+      fputc(*s, out);
+    }
+  }
+  fputc('"', out);
+}
+
+/**
+ * Prints the phases of @e st for the input at @e fpath as a single JSON
+ * object to @e out.
+ */
+static void print_stats(FILE* out, const char* fpath,
+                        const struct run_stats* st){
+  bool counted = alloc_count_enabled();
+  uint64_t total = 0;
+  fprintf(out, "{\"input\":");
+  print_json_string(out, fpath);
+  fprintf(out, ",\"phases\":{");
+  for(int p = 0; p < N_PHASES; p++){
+    total += st->ns[p];
+    fprintf(out, "%s\"%s\":{\"ns\":%llu", p == 0 ? "" : ",",
+            phase_names[p], (unsigned long long) st->ns[p]);
+    if(counted){
+      fprintf(out, ",\"allocs\":%llu,\"reallocs\":%llu,\"frees\":%llu,"
+              "\"alloc_bytes\":%llu}",
+              (unsigned long long) st->allocs[p].allocs,
+              (unsigned long long) st->allocs[p].reallocs,
+              (unsigned long long) st->allocs[p].frees,
+              (unsigned long long) st->allocs[p].bytes);
+    }
+    else{
+      fprintf(out, ",\"allocs\":null,\"reallocs\":null,\"frees\":null,"
+              "\"alloc_bytes\":null}");
+    }
+  }
+  fprintf(out, "},\"total_ns\":%llu}\n", (unsigned long long) total);
+}
+
+/**
+ * Prints the hardware counters of @e pc for the input at @e fpath as a
+ * single JSON object to @e out. Events which weren't counted are null.
+ */
+static void print_perf(FILE* out, const char* fpath, const perf_counters_t* pc){
+  fprintf(out, "{\"input\":");
+  print_json_string(out, fpath);
+  fprintf(out, ",\"perf\":{");
+  for(int e = 0; e < PERF_N_EVENTS; e++){
+    uint64_t value;
+    fprintf(out, "%s\"%s\":", e == 0 ? "" : ",", perf_event_name(e));
+    if(perf_read(pc, e, &value) == 0){
+      fprintf(out, "%llu", (unsigned long long) value);
+    }
+    else{
+      fprintf(out, "null");
+    }
+  }
+  fprintf(out, "}}\n");
+}
+
+/**
+ * Whether all parts of @e day flagged in @e parts work on the raw input
+ */
+static bool raw_parts(const aoc_day_t* day, unsigned parts){
+  return (!(parts & AOC_PART1) || day->raw1 != NULL)
+    && (!(parts & AOC_PART2) || day->raw2 != NULL);
+}
+
+/**
+ * Runs the parts of @e day flagged in @e parts on the input at @e fpath,
+ * loading and tokenizing it only once, or not at all if the parts work
+ * on the raw input. With --stats in @e opts, the time and allocations of
+ * each phase are printed to stderr afterwards, with --perf the hardware
+ * counters of the solve phase.
+ */
+static int exec_day(const char* fpath, const aoc_day_t* day, unsigned parts,
+                    bool stream, const struct aoc_opts* opts){
+  perf_counters_t counters;
+  perf_counters_t* pc = NULL;
+  if(opts->perf){
+    if(perf_open(&counters) > 0){
+      pc = &counters;
     }
     else{
-      fprintf(STDERR_STREAM,":\n%s\n",latest_error);
-      free(latest_error);
+      fprintf(STDERR_STREAM, "Performance counters unavailable: %s. "
+              "Running without them.\n", strerror(counters.error));
+    }
+  }
+  struct run_stats run_stats;
+  struct run_stats* st = NULL;
+  if(opts->stats || pc != NULL || trace_enabled){
+    st = &run_stats;
+    stats_start(st, pc);
+  }
+  bool raw = raw_parts(day, parts);
+  mm_file_t* input = NULL;
+  tok_t* tok = NULL;
+  if(raw){
+    input = map_input(fpath);
+  }
+  else{
+    tok = load_input(fpath, stream, &input, st);
+  }
+  if(raw ? input == NULL : tok == NULL){
+    stats_finish(st);
+    if(pc != NULL){
+      perf_close(pc);
     }
     return EXIT_FAILURE;
   }
-  fprintf(STDOUT_STREAM, "%s\n", res);
-  free(res);
+  stats_enter(st, PHASE_SOLVE);
+  int ret = EXIT_SUCCESS;
+  if(raw){
+    char* (*rawfuncs[])(const char*, size_t) = {day->raw1, day->raw2};
+    for(unsigned part = 0; part < 2; part++){
+      if(!(parts & (1u << part))){
+        continue;
+      }
+      stats_enter(st, PHASE_SOLVE);
+      char* res = rawfuncs[part](mm_file_data(input), mm_file_len(input));
+      stats_enter(st, PHASE_OUTPUT);
+      if(report_result(res) != EXIT_SUCCESS){
+        ret = EXIT_FAILURE;
+      }
+    }
+  }
+  else if(day->prepare != NULL){
+    arena_t* arena = arena_create(0);
+    void* state = arena == NULL ? NULL : day->prepare(tok, arena);
+    if(arena == NULL){
+      fprintf(STDERR_STREAM, "Error creating the run arena.\n");
+      ret = EXIT_FAILURE;
+    }
+    else if(stream && tok_error(tok) != 0){
+      ret = report_stream_result(fpath, tok, NULL);
+    }
+    else if(state == NULL){
+      ret = print_result(NULL);
+    }
+    else{
+      char* (*prepared[])(void*, arena_t*) = {day->prepared1, day->prepared2};
+      for(unsigned part = 0; part < 2; part++){
+        if(!(parts & (1u << part))){
+          continue;
+        }
+        stats_enter(st, PHASE_SOLVE);
+        char* res = prepared[part](state, arena);
+        stats_enter(st, PHASE_OUTPUT);
+        if(print_result(res) != EXIT_SUCCESS){
+          ret = EXIT_FAILURE;
+        }
+      }
+    }
+    stats_enter(st, PHASE_CLEANUP);
+    if(state != NULL && day->free_prepared != NULL){
+      day->free_prepared(state);
+    }
+    arena_destroy(arena);
+  }
+  else{
+    char* (*dayfuncs[])(tok_t*) = {day->part1, day->part2};
+    bool first = true;
+    for(unsigned part = 0; part < 2; part++){
+      if(!(parts & (1u << part))){
+        continue;
+      }
+      stats_enter(st, PHASE_SOLVE);
+      if(!first){
+        reset_tok(tok);
+      }
+      first = false;
+      char* res = dayfuncs[part](tok);
+      stats_enter(st, PHASE_OUTPUT);
+      int part_ret = stream ? report_stream_result(fpath, tok, res)
+        : report_result(res);
+      if(part_ret != EXIT_SUCCESS){
+        ret = EXIT_FAILURE;
+      }
+    }
+  }
+  stats_enter(st, PHASE_CLEANUP);
+  if(tok != NULL){
+    free_tok(tok);
+  }
+  mm_file_close(input);
+  stats_finish(st);
+  if(opts->stats){
+    print_stats(STDERR_STREAM, fpath, st);
+  }
+  if(pc != NULL){
+    print_perf(STDERR_STREAM, fpath, pc);
+    perf_close(pc);
+  }
+  return ret;
+}
+
+static int cmp_u64(const void* a, const void* b){
+  uint64_t x = *(const uint64_t*) a;
+  uint64_t y = *(const uint64_t*) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Runs the parts of @e day flagged in @e parts once on @e tok, or on the
+ * raw content of @e input if they can, discarding the results. Returns
+ * false if one of them failed. Leaves @e arena reset.
+ */
+static bool bench_once(const aoc_day_t* day, unsigned parts, tok_t* tok,
+                       const mm_file_t* input, arena_t* arena){
+  bool ok = true;
+  if(raw_parts(day, parts)){
+    char* (*rawfuncs[])(const char*, size_t) = {day->raw1, day->raw2};
+    for(unsigned part = 0; part < 2 && ok; part++){
+      if(parts & (1u << part)){
+        char* res = rawfuncs[part](mm_file_data(input), mm_file_len(input));
+        ok = res != NULL;
+        free(res);
+      }
+    }
+    return ok;
+  }
+  if(day->prepare != NULL){
+    void* state = day->prepare(tok, arena);
+    if(state != NULL){
+      char* (*prepared[])(void*, arena_t*) = {day->prepared1, day->prepared2};
+      for(unsigned part = 0; part < 2 && ok; part++){
+        ok = !(parts & (1u << part)) || prepared[part](state, arena) != NULL;
+      }
+      if(day->free_prepared != NULL){
+        day->free_prepared(state);
+      }
+    }
+    arena_reset(arena);
+    return state != NULL && ok;
+  }
+  char* (*dayfuncs[])(tok_t*) = {day->part1, day->part2};
+  bool first = true;
+  for(unsigned part = 0; part < 2 && ok; part++){
+    if(!(parts & (1u << part))){
+      continue;
+    }
+    if(!first){
+      reset_tok(tok);
+    }
+    first = false;
+    char* res = dayfuncs[part](tok);
+    ok = res != NULL;
+    free(res);
+  }
+  return ok;
+}
+
+
+/**
+ * Runs the parts of @e day flagged in @e parts @e runs times on the input
+ * at @e fpath and prints timing and allocation statistics as a single
+ * JSON object. The input is loaded once up front, so file I/O is not
+ * part of the measurement. Throughput is computed from the median.
+ */
+static int bench_day(const char* fpath, const char* part,
+                     const aoc_day_t* day, unsigned parts, int runs){
+  uint64_t* times = malloc(runs*sizeof(uint64_t));
+  if(times == NULL){
+    fprintf(STDERR_STREAM, "Error allocating benchmark buffer.\n");
+    return EXIT_FAILURE;
+  }
+  arena_t* arena = arena_create(0);
+  if(arena == NULL){
+    free(times);
+    fprintf(STDERR_STREAM, "Error creating the run arena.\n");
+    return EXIT_FAILURE;
+  }
+  mm_file_t* input;
+  tok_t* tok = load_input(fpath, false, &input, NULL);
+  if(tok == NULL){
+    free(times);
+    arena_destroy(arena);
+    return EXIT_FAILURE;
+  }
+  size_t bytes = mm_file_len(input);
+  int lines = tok_count(tok);
+  alloc_count_t before, after;
+  alloc_count_get(&before);
+  for(int run = 0; run < runs; run++){
+    if(run > 0){
+      reset_tok(tok);
+    }
+    uint64_t start = now_ns();
+    bool ok = bench_once(day, parts, tok, input, arena);
+    times[run] = now_ns() - start;
+    if(!ok){
+      free(times);
+      free_tok(tok);
+      mm_file_close(input);
+      arena_destroy(arena);
+      return report_result(NULL);
+    }
+  }
+  alloc_count_get(&after);
+  free_tok(tok);
+  mm_file_close(input);
+  arena_destroy(arena);
+
+  qsort(times, runs, sizeof(uint64_t), cmp_u64);
+  uint64_t min = times[0];
+  uint64_t median = runs % 2 ? times[runs/2]
+    : (times[runs/2 - 1] + times[runs/2]) / 2;
+  // Nearest rank percentile
+  uint64_t p99 = times[(99*(size_t) runs + 99)/100 - 1];
+  double median_s = median > 0 ? median / 1e9 : 1e-9;
+  free(times);
+
+  fprintf(STDOUT_STREAM, "{\"input\":");
+  print_json_string(STDOUT_STREAM, fpath);
+  fprintf(STDOUT_STREAM, ",\"part\":");
+  print_json_string(STDOUT_STREAM, part);
+  fprintf(STDOUT_STREAM, ",\"runs\":%d,\"bytes\":%zu,\"lines\":%d", runs,
+          bytes, lines);
+  fprintf(STDOUT_STREAM, ",\"min_ns\":%llu,\"median_ns\":%llu,\"p99_ns\":%llu",
+          (unsigned long long) min, (unsigned long long) median,
+          (unsigned long long) p99);
+  fprintf(STDOUT_STREAM, ",\"mb_per_s\":%.3f,\"lines_per_s\":%.1f",
+          bytes / 1e6 / median_s, lines / median_s);
+  if(alloc_count_enabled()){
+    fprintf(STDOUT_STREAM, ",\"allocs_per_run\":%.1f,\"reallocs_per_run\":%.1f"
+            ",\"frees_per_run\":%.1f,\"alloc_bytes_per_run\":%.1f",
+            (double) (after.allocs - before.allocs) / runs,
+            (double) (after.reallocs - before.reallocs) / runs,
+            (double) (after.frees - before.frees) / runs,
+            (double) (after.bytes - before.bytes) / runs);
+  }
+  else{
+    fprintf(STDOUT_STREAM, ",\"allocs_per_run\":null,\"reallocs_per_run\":null"
+            ",\"frees_per_run\":null,\"alloc_bytes_per_run\":null");
+  }
+  fprintf(STDOUT_STREAM, "}\n");
   return EXIT_SUCCESS;
 }
 
+/**
+ * Runs the parts of @e day flagged in @e parts on the input at @e fpath
+ * and prints the results to @e out on one line, behind the file name and
+ * separated by tabs. Errors go to @e err. @e tok is the tokenizer shared
+ * by all inputs of a batch (or a batch worker). It's created on the first
+ * call and reloaded with the input afterwards, so its buffers are only
+ * allocated once. Inputs are tokenized in @e shards shards at most.
+ */
+static int batch_file(const char* fpath, const aoc_day_t* day, unsigned parts,
+                      tok_t** tok, arena_t* arena, unsigned shards, FILE* out,
+                      FILE* err){
+  mm_file_t* input = mm_file_open(fpath);
+  int error = errno;
+  if(input == NULL){
+    fprintf(err, "Error loading input from %s: %s\n",
+            fpath, strerror(error));
+    return EXIT_FAILURE;
+  }
+  size_t len = mm_file_len(input);
+  bool raw = raw_parts(day, parts);
+  if(shards > tokenizer_shards(len)){
+    shards = tokenizer_shards(len);
+  }
+  bool loaded = true;
+  if(!raw && *tok == NULL){
+    *tok = get_tokenizer_parallel(mm_file_data(input), len, "\n", shards);
+    loaded = *tok != NULL;
+  }
+  else if(!raw){
+    loaded = reload_tok(*tok, mm_file_data(input), len, "\n", shards) == 0;
+  }
+  if(!loaded){
+    mm_file_close(input);
+    fprintf(err, "Error initializing input tokenizer for %s.\n", fpath);
+    return EXIT_FAILURE;
+  }
+  char* res[2] = {NULL, NULL};
+  bool ok = true;
+  if(raw){
+    char* (*rawfuncs[])(const char*, size_t) = {day->raw1, day->raw2};
+    for(unsigned part = 0; part < 2 && ok; part++){
+      if(parts & (1u << part)){
+        res[part] = rawfuncs[part](mm_file_data(input), len);
+        ok = res[part] != NULL;
+      }
+    }
+  }
+  else if(day->prepare != NULL){
+    void* state = day->prepare(*tok, arena);
+    if(state == NULL){
+      ok = false;
+    }
+    else{
+      char* (*prepared[])(void*, arena_t*) = {day->prepared1, day->prepared2};
+      for(unsigned part = 0; part < 2 && ok; part++){
+        if(parts & (1u << part)){
+          // Copied, the arena is reset below
+          char* arena_res = prepared[part](state, arena);
+          res[part] = arena_res == NULL ? NULL : strdup(arena_res);
+          ok = res[part] != NULL;
+        }
+      }
+      if(day->free_prepared != NULL){
+        day->free_prepared(state);
+      }
+    }
+    arena_reset(arena);
+  }
+  else{
+    char* (*dayfuncs[])(tok_t*) = {day->part1, day->part2};
+    bool first = true;
+    for(unsigned part = 0; part < 2 && ok; part++){
+      if(!(parts & (1u << part))){
+        continue;
+      }
+      if(!first){
+        reset_tok(*tok);
+      }
+      first = false;
+      res[part] = dayfuncs[part](*tok);
+      ok = res[part] != NULL;
+    }
+  }
+  mm_file_close(input);
+  if(ok){
+    fprintf(out, "%s", fpath);
+    for(unsigned part = 0; part < 2; part++){
+      if(parts & (1u << part)){
+        fprintf(out, "\t%s", res[part]);
+      }
+    }
+    fprintf(out, "\n");
+  }
+  else{
+    report_error(err, fpath);
+  }
+  free(res[0]);
+  free(res[1]);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * A batch run on a thread pool. Every input gets its own output buffers,
+ * which are printed in input order once the whole batch is done.
+ */
+struct batch {
+  char** fpaths;
+  const aoc_day_t* day;
+  unsigned parts;
+  tok_t** toks;
+  arena_t** arenas;
+  char** outs;
+  size_t* out_lens;
+  char** errs;
+  size_t* err_lens;
+  int* rets;
+};
+
+static void batch_task(void* ctx, size_t i, unsigned worker){
+  struct batch* b = ctx;
+  FILE* out = open_memstream(&b->outs[i], &b->out_lens[i]);
+  FILE* err = open_memstream(&b->errs[i], &b->err_lens[i]);
+  if(out == NULL || err == NULL){
+    if(out != NULL){
+      fclose(out);
+    }
+    if(err != NULL){
+      fclose(err);
+    }
+    b->rets[i] = -1;
+    return;
+  }
+  // The inputs are the parallelism here, no need to shard them as well
+  b->rets[i] = batch_file(b->fpaths[i], b->day, b->parts, &b->toks[worker],
+                          b->arenas[worker], 1, out, err);
+  fclose(out);
+  fclose(err);
+}
+
+/**
+ * Runs the batch on a pool of @e jobs workers, each with its own
+ * tokenizer and arena.
+ */
+static int exec_batch_parallel(char** fpaths, int n_files, const aoc_day_t* day,
+                               unsigned parts, unsigned jobs){
+  tpool_t* pool = tpool_create(jobs);
+  struct batch b = {
+    .fpaths = fpaths,
+    .day = day,
+    .parts = parts,
+    .toks = calloc(jobs, sizeof(tok_t*)),
+    .arenas = calloc(jobs, sizeof(arena_t*)),
+    .outs = calloc(n_files, sizeof(char*)),
+    .out_lens = calloc(n_files, sizeof(size_t)),
+    .errs = calloc(n_files, sizeof(char*)),
+    .err_lens = calloc(n_files, sizeof(size_t)),
+    .rets = calloc(n_files, sizeof(int)),
+  };
+  int ret = EXIT_SUCCESS;
+  bool arenas = b.arenas != NULL;
+  for(unsigned i = 0; arenas && i < jobs; i++){
+    b.arenas[i] = arena_create(0);
+    arenas = b.arenas[i] != NULL;
+  }
+  if(pool == NULL || b.toks == NULL || !arenas || b.outs == NULL
+     || b.out_lens == NULL || b.errs == NULL || b.err_lens == NULL
+     || b.rets == NULL){
+    fprintf(STDERR_STREAM, "Error setting up the batch workers.\n");
+    ret = EXIT_FAILURE;
+  }
+  else{
+    tpool_run(pool, n_files, batch_task, &b);
+    for(int i = 0; i < n_files; i++){
+      if(b.rets[i] == -1){
+        fprintf(STDERR_STREAM, "Error buffering the output for %s.\n",
+                fpaths[i]);
+      }
+      else{
+        fwrite(b.outs[i], 1, b.out_lens[i], STDOUT_STREAM);
+        fwrite(b.errs[i], 1, b.err_lens[i], STDERR_STREAM);
+      }
+      if(b.rets[i] != EXIT_SUCCESS){
+        ret = EXIT_FAILURE;
+      }
+      free(b.outs[i]);
+      free(b.errs[i]);
+    }
+    for(unsigned i = 0; i < jobs; i++){
+      if(b.toks[i] != NULL){
+        free_tok(b.toks[i]);
+      }
+    }
+  }
+  tpool_destroy(pool);
+  for(unsigned i = 0; b.arenas != NULL && i < jobs; i++){
+    arena_destroy(b.arenas[i]);
+  }
+  free(b.arenas);
+  free(b.toks);
+  free(b.outs);
+  free(b.out_lens);
+  free(b.errs);
+  free(b.err_lens);
+  free(b.rets);
+  return ret;
+}
+
+/**
+ * Runs the parts of @e day flagged in @e parts on each of the @e n_files
+ * inputs in @e fpaths, on @e jobs threads. A failing input doesn't stop
+ * the batch, but makes the whole run fail.
+ */
+static int exec_batch(char** fpaths, int n_files, const aoc_day_t* day,
+                      unsigned parts, unsigned jobs){
+  if(jobs > (unsigned) n_files){
+    jobs = n_files;
+  }
+  if(jobs > 1){
+    return exec_batch_parallel(fpaths, n_files, day, parts, jobs);
+  }
+  arena_t* arena = arena_create(0);
+  if(arena == NULL){
+    fprintf(STDERR_STREAM, "Error creating the run arena.\n");
+    return EXIT_FAILURE;
+  }
+  tok_t* tok = NULL;
+  int ret = EXIT_SUCCESS;
+  for(int i = 0; i < n_files; i++){
+    if(batch_file(fpaths[i], day, parts, &tok, arena, UINT_MAX, STDOUT_STREAM,
+                  STDERR_STREAM) != EXIT_SUCCESS){
+      ret = EXIT_FAILURE;
+    }
+  }
+  if(tok != NULL){
+    free_tok(tok);
+  }
+  arena_destroy(arena);
+  return ret;
+}
+
+/**
+ * Runs a batch over the inputs listed in the manifest at @e mpath, one
+ * path per line, followed by the @e n_files inputs in @e fpaths.
+ */
+static int exec_manifest(const char* mpath, char** fpaths, int n_files,
+                         const aoc_day_t* day, unsigned parts, unsigned jobs){
+  mm_file_t* manifest = mm_file_open(mpath);
+  int error = errno;
+  if(manifest == NULL){
+    fprintf(STDERR_STREAM, "Error loading manifest from %s: %s\n",
+            mpath, strerror(error));
+    return EXIT_FAILURE;
+  }
+  tok_t* lines = get_tokenizer_n(mm_file_data(manifest),
+                                 mm_file_len(manifest), "\n");
+  int n_lines = lines == NULL ? 0 : tok_count(lines);
+  char** all = malloc((n_lines + n_files)*sizeof(char*));
+  if(lines == NULL || all == NULL){
+    free(all);
+    if(lines != NULL){
+      free_tok(lines);
+    }
+    mm_file_close(manifest);
+    fprintf(STDERR_STREAM, "Error reading manifest %s.\n", mpath);
+    return EXIT_FAILURE;
+  }
+  for(int i = 0; i < n_lines; i++){
+    all[i] = tok_at(lines, i);
+  }
+  for(int i = 0; i < n_files; i++){
+    all[n_lines + i] = fpaths[i];
+  }
+  int ret = exec_batch(all, n_lines + n_files, day, parts, jobs);
+  free(all);
+  free_tok(lines);
+  mm_file_close(manifest);
+  return ret;
+}
+
+/**
+ * Parses the options in front of the part into @e opts. Returns the
+ * index of the first positional argument, or -1 after printing an error.
+ */
+static int parse_opts(int argc, char** argv, struct aoc_opts* opts){
+  opts->bench_runs = 0;
+  opts->manifest = NULL;
+  opts->jobs = 1;
+  opts->stats = false;
+  opts->perf = false;
+  opts->trace = NULL;
+  int argi = 1;
+  while(argi < argc && strncmp(argv[argi], "--", 2) == 0){
+    if(strcmp(argv[argi], "--bench") == 0 && argi + 1 < argc){
+      char* end;
+      errno = 0;
+      long runs = strtol(argv[argi+1], &end, 10);
+      if(errno != 0 || end == argv[argi+1] || *end != '\0'
+         || runs < 1 || runs > INT_MAX){
+        fprintf(STDERR_STREAM, "\"%s\" is an invalid number of benchmark runs.\n",
+                argv[argi+1]);
+        return -1;
+      }
+      opts->bench_runs = runs;
+      argi += 2;
+    }
+    else if(strcmp(argv[argi], "--jobs") == 0 && argi + 1 < argc){
+      char* end;
+      errno = 0;
+      long jobs = strtol(argv[argi+1], &end, 10);
+      if(errno != 0 || end == argv[argi+1] || *end != '\0'
+         || jobs < 1 || jobs > AOC_MAX_JOBS){
+        fprintf(STDERR_STREAM, "\"%s\" is an invalid number of jobs.\n",
+                argv[argi+1]);
+        return -1;
+      }
+      opts->jobs = jobs;
+      argi += 2;
+    }
+    else if(strcmp(argv[argi], "--manifest") == 0 && argi + 1 < argc){
+      opts->manifest = argv[argi+1];
+      argi += 2;
+    }
+    else if(strcmp(argv[argi], "--stats") == 0){
+      opts->stats = true;
+      argi++;
+    }
+    else if(strcmp(argv[argi], "--trace") == 0 && argi + 1 < argc){
+      opts->trace = argv[argi+1];
+      argi += 2;
+    }
+    else if(strcmp(argv[argi], "--perf") == 0){
+      opts->perf = true;
+      argi++;
+    }
+    else{
+      fprintf(STDERR_STREAM, "Invalid option \"%s\".\n", argv[argi]);
+      fprintf(STDERR_STREAM, usage, argv[0]);
+      return -1;
+    }
+  }
+  return argi;
+}
+
+/**
+ * Runs @e day in the mode selected by @e opts, on already validated
+ * arguments.
+ */
+static int exec_mode(const struct aoc_opts* opts, const char* part,
+                     char** fpaths, int n_files, const aoc_day_t* day,
+                     unsigned parts){
+  if(opts->bench_runs > 0){
+    return bench_day(fpaths[0], part, day, parts, opts->bench_runs);
+  }
+  if(opts->manifest != NULL){
+    return exec_manifest(opts->manifest, fpaths, n_files, day, parts,
+                         opts->jobs);
+  }
+  if(n_files > 1){
+    return exec_batch(fpaths, n_files, day, parts, opts->jobs);
+  }
+  // Only stream if every requested part can handle it
+  bool stream = (day->stream_parts & parts) == parts;
+  return exec_day(fpaths[0], day, parts, stream, opts);
+}
+
 int aoc_main(int argc, char** argv, char* (*p1func)(tok_t*),
              char* (*p2func)(tok_t*)){
-  (void)(p2func);
-  if(argc < 3){
+  return aoc_main_streaming(argc, argv, p1func, p2func, 0u);
+}
+
+int aoc_main_streaming(int argc, char** argv, char* (*p1func)(tok_t*),
+                       char* (*p2func)(tok_t*), unsigned stream_parts){
+  aoc_day_t day = {
+    .part1 = p1func,
+    .part2 = p2func,
+    .stream_parts = stream_parts,
+  };
+  return aoc_run(argc, argv, &day);
+}
+
+int aoc_run(int argc, char** argv, const aoc_day_t* day){
+  struct aoc_opts opts;
+  int argi = parse_opts(argc, argv, &opts);
+  if(argi < 0){
+    return EXIT_FAILURE;
+  }
+  if(opts.bench_runs > 0 && opts.manifest != NULL){
+    fprintf(STDERR_STREAM, "--bench and --manifest can't be combined.\n");
+    return EXIT_FAILURE;
+  }
+  if((opts.stats || opts.perf)
+     && (opts.bench_runs > 0 || opts.manifest != NULL)){
+    fprintf(STDERR_STREAM, "--stats and --perf can't be combined with --bench or --manifest.\n");
+    return EXIT_FAILURE;
+  }
+  int min_args = opts.manifest == NULL ? 2 : 1;
+  if(argc - argi < min_args){
     fprintf(STDOUT_STREAM, "Too few arguments.\n");
     fprintf(STDOUT_STREAM, usage, argv[0]);
     return EXIT_FAILURE;
   }
-  else if(argc > 3){
+  else if(opts.bench_runs > 0 && argc - argi > 2){
     fprintf(STDOUT_STREAM, "Too many arguments.\n");
     fprintf(STDOUT_STREAM, usage, argv[0]);
     return EXIT_FAILURE;
   }
-  const char* part = argv[1];
-  const char* fpath = argv[2];
-  char* (*dayfunc)(tok_t*);
+  const char* part = argv[argi];
+  char** fpaths = argv + argi + 1;
+  int n_files = argc - argi - 1;
+  unsigned parts;
   if(strcmp("1", part) == 0){
-    dayfunc = p1func;
+    parts = AOC_PART1;
   }
   else if(strcmp("2", part) == 0){
-    dayfunc = p2func;
+    parts = AOC_PART2;
+  }
+  else if(strcmp("both", part) == 0){
+    parts = AOC_PART1 | AOC_PART2;
   }
   else{
-    fprintf(STDERR_STREAM, "\"%s\" is an invalid part number. Choose 1 or 2.\n",
+    fprintf(STDERR_STREAM, "\"%s\" is an invalid part number. Choose 1, 2 or both.\n",
             part);
     return EXIT_FAILURE;
   }
-  if(dayfunc == NULL){
-    fprintf(STDERR_STREAM, parterr, part, part);
+  if((parts & AOC_PART1) && day->part1 == NULL){
+    fprintf(STDERR_STREAM, parterr, "1", "1");
+    return EXIT_FAILURE;
+  }
+  if((parts & AOC_PART2) && day->part2 == NULL){
+    fprintf(STDERR_STREAM, parterr, "2", "2");
     return EXIT_FAILURE;
   }
-  return exec_dayfunc(fpath, dayfunc);
+  // The runner calls the prepared parts without checking them
+  if(day->prepare != NULL && day->prepared1 == NULL){
+    fprintf(STDERR_STREAM, preperr, "1");
+    return EXIT_FAILURE;
+  }
+  if(day->prepare != NULL && day->prepared2 == NULL){
+    fprintf(STDERR_STREAM, preperr, "2");
+    return EXIT_FAILURE;
+  }
+  if(n_files > 1 && (opts.stats || opts.perf)){
+    fprintf(STDERR_STREAM, "--stats and --perf take a single input file.\n");
+    return EXIT_FAILURE;
+  }
+  if(opts.trace != NULL){
+    trace_enable(true);
+  }
+  int ret = exec_mode(&opts, part, fpaths, n_files, day, parts);
+  if(opts.trace != NULL){
+    trace_enable(false);
+    if(trace_dump(opts.trace) != 0){
+      fprintf(STDERR_STREAM, "Error writing the trace to %s: %s\n",
+              opts.trace, strerror(errno));
+      ret = EXIT_FAILURE;
+    }
+    trace_clear();
+  }
+  return ret;
 }
@@ -5,7 +5,77 @@
 
 #pragma once
 
+#include "arena.h"
 #include "tokenizer.h"
 
+#include <stddef.h>
+
 int aoc_main(int argc, char** argv, char* (*p1func)(tok_t*),
              char* (*p2func)(tok_t*));
+
+/**
+ * Flags for aoc_main_streaming, marking which parts can consume their
+ * input from a streaming tokenizer.
+ */
+#define AOC_STREAM_PART1 1u
+#define AOC_STREAM_PART2 2u
+
+/**
+ * @brief aoc_main for days with streaming capable part functions
+ *
+ * Works like aoc_main, but the parts flagged in @e stream_parts get a
+ * tokenizer from get_stream_tokenizer instead of the mapped input file,
+ * so they run in constant memory regardless of the input size.
+ *
+ * Only flag a part if it never calls tok_count and never keeps a token
+ * past the next call to n_tok.
+ */
+int aoc_main_streaming(int argc, char** argv, char* (*p1func)(tok_t*),
+                       char* (*p2func)(tok_t*), unsigned stream_parts);
+
+/**
+ * @brief Description of a day's solver functions for aoc_run
+ *
+ * @e part1 and @e part2 work like the functions handed to aoc_main and
+ * @e stream_parts like the flags of aoc_main_streaming.
+ *
+ * Days which parse their input into the same state for both parts can
+ * additionally provide a @e prepare hook. It is then used instead of
+ * @e part1 and @e part2: @e prepare is called once per run, and
+ * @e prepared1 and @e prepared2 get its result for the requested parts.
+ * @e prepare returns NULL on error, after setting an AoC error message.
+ * A day with @e prepare must provide both @e prepared1 and @e prepared2,
+ * aoc_run refuses to run it otherwise.
+ *
+ * The state and the results are allocated from the run's arena, which
+ * the runner resets or destroys after the run, so neither needs to be
+ * freed. @e free_prepared is optional and only needed for resources
+ * outside the arena.
+ *
+ * Parts which can work on the raw input can additionally provide
+ * @e raw1 and @e raw2, called with the content of the mapped input file
+ * and its length. The content is null terminated. If all requested parts
+ * have one, the runner skips the tokenizer and calls them instead of the
+ * other functions. They take precedence over @e stream_parts as well, a
+ * part with a raw function never runs on a streaming tokenizer.
+ */
+typedef struct aoc_day{
+  char* (*part1)(tok_t* tok);
+  char* (*part2)(tok_t* tok);
+  unsigned stream_parts;
+  void* (*prepare)(tok_t* tok, arena_t* arena);
+  char* (*prepared1)(void* state, arena_t* arena);
+  char* (*prepared2)(void* state, arena_t* arena);
+  void (*free_prepared)(void* state);
+  char* (*raw1)(const char* input, size_t len);
+  char* (*raw2)(const char* input, size_t len);
+} aoc_day_t;
+
+/**
+ * @brief Runs the parts of @e day requested on the command line
+ *
+ * Accepts "1", "2" or "both" as the part. With "both", the input is
+ * loaded and tokenized only once and the results of both parts are
+ * printed on separate lines.
+ */
+int aoc_run(int argc, char** argv, const aoc_day_t* day);
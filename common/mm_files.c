@@ -5,6 +5,7 @@
 
 #include "mm_files.h"
 
+#include <errno.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,6 +15,12 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+struct mm_file{
+  char* map;
+  size_t len;
+  size_t map_len;
+};
+
 char* mm_file_read(const char* fpath){
   struct stat statbuf;
   if(stat(fpath,&statbuf) == -1){
@@ -40,3 +47,72 @@ char* mm_file_read(const char* fpath){
   close(fd);
   return resbuf;
 }
+
+mm_file_t* mm_file_open(const char* fpath){
+  int fd = open(fpath, O_RDONLY);
+  if(fd == -1){
+    return NULL;
+  }
+  struct stat statbuf;
+  if(fstat(fd, &statbuf) == -1){
+    close(fd);
+    return NULL;
+  }
+  if(statbuf.st_size == 0){
+    close(fd);
+    errno = EINVAL;
+    return NULL;
+  }
+  mm_file_t* f = malloc(sizeof(mm_file_t));
+  if(f == NULL){
+    close(fd);
+    return NULL;
+  }
+  f->len = statbuf.st_size;
+  // Reserve at least one byte more than the file size with an anonymous
+  // zero page mapping and map the file over it. The kernel zero fills
+  // the tail of the file's last page, and if the file ends exactly on a
+  // page boundary, the byte after it is in the anonymous page. Either way,
+  // the content ends up null terminated without copying it.
+  size_t pagesize = sysconf(_SC_PAGESIZE);
+  f->map_len = (f->len / pagesize + 1) * pagesize;
+  f->map = mmap(NULL, f->map_len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS,
+                -1, 0);
+  if(f->map == MAP_FAILED){
+    int error = errno;
+    free(f);
+    close(fd);
+    errno = error;
+    return NULL;
+  }
+  if(mmap(f->map, f->len, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0)
+     == MAP_FAILED){
+    int error = errno;
+    munmap(f->map, f->map_len);
+    free(f);
+    close(fd);
+    errno = error;
+    return NULL;
+  }
+  // The mapping stays valid after closing the descriptor
+  close(fd);
+  // Purely a hint, the inputs are read front to back
+  madvise(f->map, f->len, MADV_SEQUENTIAL);
+  return f;
+}
+
+const char* mm_file_data(const mm_file_t* f){
+  return f->map;
+}
+
+size_t mm_file_len(const mm_file_t* f){
+  return f->len;
+}
+
+void mm_file_close(mm_file_t* f){
+  if(f == NULL){
+    return;
+  }
+  munmap(f->map, f->map_len);
+  free(f);
+}
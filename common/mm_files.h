@@ -3,6 +3,13 @@
  * @brief Functions for memory mapping text files.
  */
 
+#pragma once
+
+#include <stddef.h>
+
+struct mm_file;
+typedef struct mm_file mm_file_t;
+
 /**
  * @brief Read text file into a string.
  *
@@ -22,3 +29,49 @@
  *          error.
  */
 char* mm_file_read(const char* fpath);
+
+/**
+ * @brief Map a text file into memory for reading.
+ *
+ * Maps the entire file at @e fpath read only into memory and returns
+ * a handle to the mapping. The content is not copied, it stays in the
+ * page cache and is only valid until mm_file_close is called on the
+ * handle.
+ *
+ * The mapped content is always followed by a '\0' byte, so it can be
+ * used as a null terminated string. Empty files are rejected with
+ * errno set to EINVAL, just like with mm_file_read.
+ *
+ * The function returns NULL upon error, with errno set accordingly.
+ *
+ * @param fpath null terminated path to the file to map
+ * @returns Handle to the mapped file or NULL on error.
+ */
+mm_file_t* mm_file_open(const char* fpath);
+
+/**
+ * @brief Returns the content of the mapped file @e f
+ *
+ * @param f The mapped file
+ * @returns Pointer to the null terminated, read only file content
+ */
+const char* mm_file_data(const mm_file_t* f);
+
+/**
+ * @brief Returns the size of the mapped file @e f in bytes
+ *
+ * The size does not include the terminating '\0'.
+ *
+ * @param f The mapped file
+ * @returns The number of bytes in the file
+ */
+size_t mm_file_len(const mm_file_t* f);
+
+/**
+ * @brief Unmaps the file @e f and frees the handle
+ *
+ * Invalidates all pointers returned by mm_file_data for @e f.
+ *
+ * @param f The mapped file to close, may be NULL
+ */
+void mm_file_close(mm_file_t* f);
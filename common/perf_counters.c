@@ -0,0 +1,154 @@
+/**
+ * @file perf_counters.c
+ * @brief Implementation of the hardware performance counters
+ */
+
+#include "perf_counters.h"
+
+#include <errno.h>
+#include <stddef.h>
+
+static const char* event_names[PERF_N_EVENTS] = {
+  "cycles", "instructions", "cache_misses", "branch_misses", "page_faults"
+};
+
+const char* perf_event_name(perf_event_t event){
+  return event_names[event];
+}
+
+bool perf_available(const perf_counters_t* pc, perf_event_t event){
+  return pc->fds[event] != -1;
+}
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const struct{
+  uint32_t type;
+  uint64_t config;
+} event_attrs[PERF_N_EVENTS] = {
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+int perf_open(perf_counters_t* pc){
+  int opened = 0;
+  pc->error = 0;
+  for(int e = 0; e < PERF_N_EVENTS; e++){
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event_attrs[e].type;
+    attr.config = event_attrs[e].config;
+    attr.disabled = 1;
+    // Count threads started later on too, e.g. the tokenizer's shards
+    attr.inherit = 1;
+    // Unprivileged users may only count user space by default
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+      | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // Each event on its own, so one the PMU lacks doesn't take the others
+    pc->fds[e] = syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                         PERF_FLAG_FD_CLOEXEC);
+    if(pc->fds[e] == -1){
+      if(pc->error == 0){
+        pc->error = errno;
+      }
+      continue;
+    }
+    ioctl(pc->fds[e], PERF_EVENT_IOC_RESET, 0);
+    opened++;
+  }
+  if(opened > 0){
+    pc->error = 0;
+  }
+  return opened;
+}
+
+void perf_start(perf_counters_t* pc){
+  for(int e = 0; e < PERF_N_EVENTS; e++){
+    if(pc->fds[e] != -1){
+      ioctl(pc->fds[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+}
+
+void perf_stop(perf_counters_t* pc){
+  for(int e = 0; e < PERF_N_EVENTS; e++){
+    if(pc->fds[e] != -1){
+      ioctl(pc->fds[e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+}
+
+int perf_read(const perf_counters_t* pc, perf_event_t event, uint64_t* value){
+  if(pc->fds[event] == -1){
+    return -1;
+  }
+  // Value, time enabled and time running, see read_format
+  uint64_t buf[3];
+  if(read(pc->fds[event], buf, sizeof(buf)) != sizeof(buf)){
+    return -1;
+  }
+  if(buf[2] == 0){
+    // Never got a hardware counter, e.g. all of them taken
+    *value = 0;
+    return buf[1] == 0 ? 0 : -1;
+  }
+  if(buf[2] < buf[1]){
+    *value = (uint64_t) ((double) buf[0] * buf[1] / buf[2]);
+  }
+  else{
+    *value = buf[0];
+  }
+  return 0;
+}
+
+void perf_close(perf_counters_t* pc){
+  for(int e = 0; e < PERF_N_EVENTS; e++){
+    if(pc->fds[e] != -1){
+      close(pc->fds[e]);
+      pc->fds[e] = -1;
+    }
+  }
+}
+
+#else
+
+int perf_open(perf_counters_t* pc){
+  for(int e = 0; e < PERF_N_EVENTS; e++){
+    pc->fds[e] = -1;
+  }
+  pc->error = ENOSYS;
+  return 0;
+}
+
+void perf_start(perf_counters_t* pc){
+  (void)(pc);
+}
+
+void perf_stop(perf_counters_t* pc){
+  (void)(pc);
+}
+
+int perf_read(const perf_counters_t* pc, perf_event_t event, uint64_t* value){
+  (void)(pc);
+  (void)(event);
+  (void)(value);
+  return -1;
+}
+
+void perf_close(perf_counters_t* pc){
+  (void)(pc);
+}
+
+#endif
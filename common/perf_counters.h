@@ -0,0 +1,78 @@
+/**
+ * @file perf_counters.h
+ * @brief Hardware performance counters via perf_event_open
+ *
+ * Counts CPU cycles, instructions, cache misses, branch misses and page
+ * faults of the calling thread and the threads it starts while enabled.
+ * Counters the kernel refuses (no PMU in a VM or container, a seccomp
+ * filter, a strict perf_event_paranoid) are left out, and on systems
+ * without perf_event_open none are available.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum perf_event{
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_CACHE_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_PAGE_FAULTS,
+  PERF_N_EVENTS,
+} perf_event_t;
+
+typedef struct perf_counters{
+  int fds[PERF_N_EVENTS];
+  int error;
+} perf_counters_t;
+
+/**
+ * @brief Returns the name of @e event as used in the runner's output
+ */
+const char* perf_event_name(perf_event_t event);
+
+/**
+ * @brief Opens the counters in @e pc, disabled
+ *
+ * Events which can't be counted are skipped. If none can, @e pc->error
+ * holds the errno of the first failed attempt.
+ *
+ * @param pc The counters to open
+ * @returns The number of events which are counted
+ */
+int perf_open(perf_counters_t* pc);
+
+/**
+ * @brief Returns whether @e event is counted by @e pc
+ */
+bool perf_available(const perf_counters_t* pc, perf_event_t event);
+
+/**
+ * @brief Resumes counting, the counts of earlier sections are kept
+ */
+void perf_start(perf_counters_t* pc);
+
+/**
+ * @brief Pauses counting
+ */
+void perf_stop(perf_counters_t* pc);
+
+/**
+ * @brief Reads the count of @e event into @e value
+ *
+ * If the kernel had to multiplex the counters, the count is scaled up
+ * to the full time counting was enabled.
+ *
+ * @param pc The counters
+ * @param event The event to read
+ * @param value Receives the count
+ * @returns 0 on success, -1 if @e event isn't counted or can't be read
+ */
+int perf_read(const perf_counters_t* pc, perf_event_t event, uint64_t* value);
+
+/**
+ * @brief Closes all counters of @e pc
+ */
+void perf_close(perf_counters_t* pc);
@@ -4,9 +4,12 @@
  */
 
 #include <unity.h>
+#include "alloc_count.h"
 #include "aoc_err.h"
 
 #include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -45,11 +48,102 @@ void test_get_latest_resets_error_msg(void){
   TEST_ASSERT_NULL(res);
 }
 
+void test_aoc_err_records_location(void){
+  aoc_err_clear();
+  int line = __LINE__ + 1;
+  AOC_ERR(AOC_ERR_PARSE, EINVAL, "Bad token \"%s\" at %d.", "foo", 3);
+  const aoc_err_rec_t* rec = aoc_err_get(0);
+  TEST_ASSERT_NOT_NULL(rec);
+  TEST_ASSERT_EQUAL_INT(AOC_ERR_PARSE, rec->code);
+  TEST_ASSERT_EQUAL_INT(EINVAL, rec->errnum);
+  TEST_ASSERT_EQUAL_STRING(__FILE__, rec->file);
+  TEST_ASSERT_EQUAL_INT(line, rec->line);
+  TEST_ASSERT_EQUAL_STRING("test_aoc_err_records_location", rec->func);
+  TEST_ASSERT_EQUAL_STRING("Bad token \"foo\" at 3.", rec->msg);
+  TEST_ASSERT_NULL(aoc_err_get(1));
+  free(get_latest_aoc_err_msg());
+}
+
+void test_aoc_err_message_is_retrieved(void){
+  char exp[1024];
+  sprintf(exp, "Bad number 42.\n%s", strerror(ERANGE));
+  AOC_ERR(AOC_ERR_RANGE, ERANGE, "Bad number %d.", 42);
+  char* res = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING(exp,res);
+  free(res);
+  TEST_ASSERT_NULL(get_latest_aoc_err_msg());
+}
+
+void test_aoc_err_ring_keeps_latest_records(void){
+  aoc_err_clear();
+  for(int i = 0; i < AOC_ERR_RING_SIZE + 3; i++){
+    AOC_ERR(AOC_ERR_PARSE, 0, "Error %d", i);
+  }
+  for(unsigned age = 0; age < AOC_ERR_RING_SIZE; age++){
+    char exp[32];
+    sprintf(exp, "Error %u", AOC_ERR_RING_SIZE + 2 - age);
+    TEST_ASSERT_EQUAL_STRING(exp, aoc_err_get(age)->msg);
+  }
+  TEST_ASSERT_NULL(aoc_err_get(AOC_ERR_RING_SIZE));
+  aoc_err_clear();
+  TEST_ASSERT_NULL(aoc_err_get(0));
+  TEST_ASSERT_NULL(get_latest_aoc_err_msg());
+}
+
+void test_aoc_err_truncates_long_messages(void){
+  char in[2*AOC_ERR_MSG_LEN];
+  memset(in, 'x', sizeof(in) - 1);
+  in[sizeof(in) - 1] = '\0';
+  AOC_ERR(AOC_ERR_PARSE, 0, "%s", in);
+  TEST_ASSERT_EQUAL_size_t(AOC_ERR_MSG_LEN - 1, strlen(aoc_err_get(0)->msg));
+  free(get_latest_aoc_err_msg());
+}
+
+void test_aoc_err_does_not_allocate(void){
+  alloc_count_t before, after;
+  alloc_count_get(&before);
+  for(int i = 0; i < 100; i++){
+    AOC_ERR(AOC_ERR_PARSE, 0, "Failed to parse \"%s\" in line %d.", "abc", i);
+  }
+  set_aoc_err_msg("Plain message.", ENOENT);
+  alloc_count_get(&after);
+  TEST_ASSERT_EQUAL_size_t(before.allocs, after.allocs);
+  free(get_latest_aoc_err_msg());
+}
+
+static void* set_error_thread(void* arg){
+  (void)(arg);
+  AOC_ERR(AOC_ERR_PARSE, 0, "Thread error");
+  char* res = get_latest_aoc_err_msg();
+  bool ok = res != NULL && strcmp(res, "Thread error") == 0;
+  free(res);
+  return ok ? arg : NULL;
+}
+
+void test_errors_are_per_thread(void){
+  int marker;
+  void* thread_res;
+  set_aoc_err_msg("Main error", 0);
+  pthread_t thread;
+  TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, set_error_thread, &marker));
+  pthread_join(thread, &thread_res);
+  TEST_ASSERT_EQUAL_PTR(&marker, thread_res);
+  char* res = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Main error", res);
+  free(res);
+}
+
 int main(void){
   UNITY_BEGIN();
   RUN_TEST(test_errmsg_with_errcode_is_shown);
   RUN_TEST(test_errmsg_without_errcode_is_shown);
   RUN_TEST(test_errmsg_null_leaves_aoc_err_msg_unchanged);
   RUN_TEST(test_get_latest_resets_error_msg);
+  RUN_TEST(test_aoc_err_records_location);
+  RUN_TEST(test_aoc_err_message_is_retrieved);
+  RUN_TEST(test_aoc_err_ring_keeps_latest_records);
+  RUN_TEST(test_aoc_err_truncates_long_messages);
+  RUN_TEST(test_aoc_err_does_not_allocate);
+  RUN_TEST(test_errors_are_per_thread);
   return UNITY_END();
 }
@@ -0,0 +1,144 @@
+/**
+ * @file test_arena.c
+ * @brief UTs for the arena allocator
+ */
+
+#include "arena.h"
+
+#include <unity.h>
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+
+void test_create_default_block_size(void){
+  arena_t* arena = arena_create(0);
+  TEST_ASSERT_NOT_NULL(arena);
+  TEST_ASSERT_EQUAL_size_t(ARENA_DEFAULT_BLOCK, arena_capacity(arena));
+  arena_destroy(arena);
+}
+
+void test_alloc_is_aligned(void){
+  arena_t* arena = arena_create(0);
+  for(size_t size = 1; size < 40; size++){
+    void* mem = arena_alloc(arena, size);
+    TEST_ASSERT_NOT_NULL(mem);
+    TEST_ASSERT_EQUAL_size_t(0, (uintptr_t) mem % alignof(max_align_t));
+  }
+  arena_destroy(arena);
+}
+
+void test_allocations_do_not_overlap(void){
+  arena_t* arena = arena_create(64);
+  char* a = arena_alloc(arena, 24);
+  char* b = arena_alloc(arena, 24);
+  char* c = arena_alloc(arena, 24);
+  TEST_ASSERT_TRUE(b >= a + 24 || a >= b + 24);
+  TEST_ASSERT_TRUE(c >= b + 24 || b >= c + 24);
+  TEST_ASSERT_TRUE(c >= a + 24 || a >= c + 24);
+  arena_destroy(arena);
+}
+
+void test_oversize_alloc_gets_own_block(void){
+  arena_t* arena = arena_create(64);
+  char* mem = arena_alloc(arena, 1000);
+  TEST_ASSERT_NOT_NULL(mem);
+  mem[999] = 'x';
+  TEST_ASSERT_TRUE(arena_capacity(arena) >= 64 + 1000);
+  arena_destroy(arena);
+}
+
+void test_reset_reuses_blocks(void){
+  arena_t* arena = arena_create(64);
+  for(int i = 0; i < 10; i++){
+    arena_alloc(arena, 48);
+  }
+  size_t capacity = arena_capacity(arena);
+  arena_reset(arena);
+  for(int i = 0; i < 10; i++){
+    arena_alloc(arena, 48);
+  }
+  TEST_ASSERT_EQUAL_size_t(capacity, arena_capacity(arena));
+  arena_destroy(arena);
+}
+
+void test_calloc_zeroes_memory(void){
+  arena_t* arena = arena_create(0);
+  unsigned char* dirty = arena_alloc(arena, 128);
+  for(int i = 0; i < 128; i++){
+    dirty[i] = 0xff;
+  }
+  arena_reset(arena);
+  unsigned char* clean = arena_calloc(arena, 32, 4);
+  for(int i = 0; i < 128; i++){
+    TEST_ASSERT_EQUAL_INT(0, clean[i]);
+  }
+  arena_destroy(arena);
+}
+
+void test_calloc_overflow_returns_null(void){
+  arena_t* arena = arena_create(0);
+  TEST_ASSERT_NULL(arena_calloc(arena, SIZE_MAX/2, 4));
+  arena_destroy(arena);
+}
+
+void test_sprintf_formats_into_arena(void){
+  arena_t* arena = arena_create(16);
+  char* s = arena_sprintf(arena, "%s %d and some more text", "number", 42);
+  TEST_ASSERT_EQUAL_STRING("number 42 and some more text", s);
+  arena_destroy(arena);
+}
+
+static int defer_order[3];
+static int defer_count = 0;
+
+static void record(void* arg){
+  defer_order[defer_count++] = *(int*) arg;
+}
+
+void test_reset_runs_deferred_in_reverse_order(void){
+  int args[] = {1, 2, 3};
+  arena_t* arena = arena_create(0);
+  defer_count = 0;
+  for(int i = 0; i < 3; i++){
+    TEST_ASSERT_EQUAL_INT(0, arena_defer(arena, record, &args[i]));
+  }
+  arena_reset(arena);
+  TEST_ASSERT_EQUAL_INT(3, defer_count);
+  TEST_ASSERT_EQUAL_INT(3, defer_order[0]);
+  TEST_ASSERT_EQUAL_INT(2, defer_order[1]);
+  TEST_ASSERT_EQUAL_INT(1, defer_order[2]);
+  arena_reset(arena);
+  TEST_ASSERT_EQUAL_INT(3, defer_count);
+  arena_destroy(arena);
+}
+
+void test_destroy_runs_deferred(void){
+  int arg = 7;
+  arena_t* arena = arena_create(0);
+  defer_count = 0;
+  arena_defer(arena, record, &arg);
+  arena_destroy(arena);
+  TEST_ASSERT_EQUAL_INT(1, defer_count);
+  TEST_ASSERT_EQUAL_INT(7, defer_order[0]);
+}
+
+void test_destroy_null_is_noop(void){
+  arena_destroy(NULL);
+}
+
+int main(void){
+  UNITY_BEGIN();
+  RUN_TEST(test_create_default_block_size);
+  RUN_TEST(test_alloc_is_aligned);
+  RUN_TEST(test_allocations_do_not_overlap);
+  RUN_TEST(test_oversize_alloc_gets_own_block);
+  RUN_TEST(test_reset_reuses_blocks);
+  RUN_TEST(test_calloc_zeroes_memory);
+  RUN_TEST(test_calloc_overflow_returns_null);
+  RUN_TEST(test_sprintf_formats_into_arena);
+  RUN_TEST(test_reset_runs_deferred_in_reverse_order);
+  RUN_TEST(test_destroy_runs_deferred);
+  RUN_TEST(test_destroy_null_is_noop);
+  return UNITY_END();
+}
@@ -0,0 +1,82 @@
+/**
+ * @file test_delim_scan.c
+ * @brief UTs for delim_scan.c
+ */
+
+#include <unity.h>
+#include "delim_scan.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+void test_empty_delim_rejected(void){
+  delim_set_t set;
+  TEST_ASSERT_EQUAL_INT(-1, ds_init(&set, ""));
+  TEST_ASSERT_EQUAL_INT(-1, ds_init(&set, NULL));
+}
+
+void test_scalar_always_supported(void){
+  delim_set_t set;
+  TEST_ASSERT_EQUAL_INT(0, ds_init_impl(&set, "\n", DS_SCALAR));
+  TEST_ASSERT_EQUAL_INT(DS_SCALAR, set.impl);
+}
+
+void test_mask_marks_delims(void){
+  char in[64];
+  memset(in, 'a', 64);
+  in[0] = '\n';
+  in[17] = '\n';
+  in[63] = ',';
+  uint64_t exp_nl = 1ull | 1ull << 17;
+  uint64_t exp_both = exp_nl | 1ull << 63;
+  for(int impl = DS_SCALAR; impl <= DS_AVX2; impl++){
+    delim_set_t set;
+    if(ds_init_impl(&set, "\n", impl) != 0){
+      continue;
+    }
+    TEST_ASSERT_EQUAL_UINT64(exp_nl, ds_mask64(&set, in));
+    ds_init_impl(&set, "\n,", impl);
+    TEST_ASSERT_EQUAL_UINT64(exp_both, ds_mask64(&set, in));
+  }
+}
+
+void test_impls_agree_on_random_input(void){
+  char in[64*64];
+  srand(42);
+  for(size_t i = 0; i < sizeof(in); i++){
+    in[i] = "ab\n ,+-1"[rand() % 8];
+  }
+  delim_set_t scalar;
+  ds_init_impl(&scalar, "\n ,", DS_SCALAR);
+  for(int impl = DS_SSE2; impl <= DS_AVX2; impl++){
+    delim_set_t set;
+    if(ds_init_impl(&set, "\n ,", impl) != 0){
+      continue;
+    }
+    for(size_t block = 0; block < sizeof(in); block += 64){
+      TEST_ASSERT_EQUAL_UINT64(ds_mask64(&scalar, in + block),
+                               ds_mask64(&set, in + block));
+    }
+  }
+}
+
+void test_large_delim_set_falls_back_to_scalar(void){
+  delim_set_t set;
+  ds_init(&set, " ,;:\n\t");
+  TEST_ASSERT_EQUAL_INT(DS_SCALAR, set.impl);
+  char in[64];
+  memset(in, 'x', 64);
+  in[5] = '\t';
+  TEST_ASSERT_EQUAL_UINT64(1ull << 5, ds_mask64(&set, in));
+}
+
+int main(void){
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_delim_rejected);
+  RUN_TEST(test_scalar_always_supported);
+  RUN_TEST(test_mask_marks_delims);
+  RUN_TEST(test_impls_agree_on_random_input);
+  RUN_TEST(test_large_delim_set_falls_back_to_scalar);
+  return UNITY_END();
+}
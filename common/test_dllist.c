@@ -235,6 +235,67 @@ void test_data_returns_pointer_to_content(void){
   free_dllist(l);
 }
 
+void test_init_list_with_capacity_reserves_nodes(void){
+  dllist_t* l = init_list_with_capacity(100);
+  TEST_ASSERT_NOT_NULL(l);
+  TEST_ASSERT_EQUAL_size_t(100, capacity(l));
+  TEST_ASSERT_EQUAL_PTR(NULL, head(l));
+  free_dllist(l);
+}
+
+void test_init_list_reserves_nothing(void){
+  dllist_t* l = init_list();
+  TEST_ASSERT_EQUAL_size_t(0, capacity(l));
+  free_dllist(l);
+}
+
+void test_append_within_capacity_is_contiguous(void){
+  int content[10];
+  dllist_t* l = init_list_with_capacity(10);
+  node_t* nodes[10];
+  for(int i = 0; i < 10; i++){
+    nodes[i] = append(l, &content[i]);
+  }
+  ptrdiff_t stride = (char*)nodes[1] - (char*)nodes[0];
+  TEST_ASSERT_TRUE(stride > 0);
+  for(int i = 2; i < 10; i++){
+    TEST_ASSERT_EQUAL_INT(stride, (char*)nodes[i] - (char*)nodes[i-1]);
+  }
+  TEST_ASSERT_EQUAL_size_t(10, capacity(l));
+  free_dllist(l);
+}
+
+void test_append_beyond_capacity_grows_list(void){
+  int content[300];
+  dllist_t* l = init_list_with_capacity(3);
+  for(int i = 0; i < 300; i++){
+    append(l, &content[i]);
+  }
+  TEST_ASSERT_TRUE(capacity(l) >= 300);
+  node_t* curr = head(l);
+  for(int i = 0; i < 300; i++){
+    TEST_ASSERT_EQUAL_PTR(&content[i], data(curr));
+    curr = next(curr);
+  }
+  TEST_ASSERT_EQUAL_PTR(NULL, curr);
+  free_dllist(l);
+}
+
+void test_removed_node_is_reused_by_append(void){
+  int content[3];
+  dllist_t* l = init_list_with_capacity(3);
+  append(l, &content[0]);
+  node_t* middle = append(l, &content[1]);
+  append(l, &content[2]);
+  remove_node(l, middle);
+  node_t* reused = append(l, &content[1]);
+  TEST_ASSERT_EQUAL_PTR(middle, reused);
+  TEST_ASSERT_EQUAL_PTR(reused, tail(l));
+  TEST_ASSERT_EQUAL_PTR(&content[1], data(reused));
+  TEST_ASSERT_EQUAL_size_t(3, capacity(l));
+  free_dllist(l);
+}
+
 int main(void){
   UNITY_BEGIN();
   RUN_TEST(test_init_list_returns_non_null);
@@ -259,5 +320,10 @@ int main(void){
   RUN_TEST(test_multi_remove_tail_returns_null);
   RUN_TEST(test_multi_remove_middle_returns_next_node);
   RUN_TEST(test_multi_remove_middle_relinks_next_and_prev);
+  RUN_TEST(test_init_list_with_capacity_reserves_nodes);
+  RUN_TEST(test_init_list_reserves_nothing);
+  RUN_TEST(test_append_within_capacity_is_contiguous);
+  RUN_TEST(test_append_beyond_capacity_grows_list);
+  RUN_TEST(test_removed_node_is_reused_by_append);
   return UNITY_END();
 }
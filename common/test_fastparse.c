@@ -0,0 +1,369 @@
+/**
+ * @file test_fastparse.c
+ * @brief UTs for the decimal integer parsers
+ */
+
+#include "fastparse.h"
+
+#include <unity.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void test_parse_u64_single_digit(void){
+  const char in[] = "7";
+  const char* end;
+  uint64_t val;
+  TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_u64(in, &end, &val));
+  TEST_ASSERT_EQUAL_UINT64(7, val);
+  TEST_ASSERT_EQUAL_PTR(in + 1, end);
+}
+
+void test_parse_u64_stops_at_non_digit(void){
+  const char in[] = "1234x5";
+  const char* end;
+  uint64_t val;
+  TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_u64(in, &end, &val));
+  TEST_ASSERT_EQUAL_UINT64(1234, val);
+  TEST_ASSERT_EQUAL_PTR(in + 4, end);
+}
+
+void test_parse_u64_no_digits(void){
+  const char in[] = " 12";
+  const char* end;
+  uint64_t val;
+  TEST_ASSERT_EQUAL_INT(FP_NO_DIGITS, fp_parse_u64(in, &end, &val));
+  TEST_ASSERT_EQUAL_PTR(in, end);
+}
+
+void test_parse_u64_max(void){
+  const char in[] = "18446744073709551615";
+  uint64_t val;
+  TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_u64(in, NULL, &val));
+  TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, val);
+}
+
+void test_parse_u64_leading_zeros_do_not_overflow(void){
+  const char in[] = "000000000000000000000000042";
+  uint64_t val;
+  TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_u64(in, NULL, &val));
+  TEST_ASSERT_EQUAL_UINT64(42, val);
+}
+
+void test_parse_u64_overflow_consumes_digits(void){
+  const char in[] = "18446744073709551616,";
+  const char* end;
+  uint64_t val;
+  TEST_ASSERT_EQUAL_INT(FP_OVERFLOW, fp_parse_u64(in, &end, &val));
+  TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, val);
+  TEST_ASSERT_EQUAL_PTR(in + 20, end);
+}
+
+void test_parse_i64_signs(void){
+  int64_t val;
+  TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_i64("+15", NULL, &val));
+  TEST_ASSERT_EQUAL_INT64(15, val);
+  TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_i64("-15", NULL, &val));
+  TEST_ASSERT_EQUAL_INT64(-15, val);
+  TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_i64("15", NULL, &val));
+  TEST_ASSERT_EQUAL_INT64(15, val);
+}
+
+void test_parse_i64_sign_without_digits(void){
+  const char in[] = "-x";
+  const char* end;
+  int64_t val;
+  TEST_ASSERT_EQUAL_INT(FP_NO_DIGITS, fp_parse_i64(in, &end, &val));
+  TEST_ASSERT_EQUAL_PTR(in, end);
+}
+
+void test_parse_i64_limits(void){
+  int64_t val;
+  TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_i64("9223372036854775807", NULL, &val));
+  TEST_ASSERT_EQUAL_INT64(INT64_MAX, val);
+  TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_i64("-9223372036854775808", NULL, &val));
+  TEST_ASSERT_EQUAL_INT64(INT64_MIN, val);
+}
+
+void test_parse_i64_overflow_saturates(void){
+  int64_t val;
+  TEST_ASSERT_EQUAL_INT(FP_OVERFLOW,
+                        fp_parse_i64("9223372036854775808", NULL, &val));
+  TEST_ASSERT_EQUAL_INT64(INT64_MAX, val);
+  TEST_ASSERT_EQUAL_INT(FP_OVERFLOW,
+                        fp_parse_i64("-9223372036854775809", NULL, &val));
+  TEST_ASSERT_EQUAL_INT64(INT64_MIN, val);
+}
+
+void test_parse_all_u64_claim(void){
+  const char in[] = "#123 @ 3,2: 5x4";
+  const char* end;
+  uint64_t vals[5];
+  TEST_ASSERT_EQUAL_INT(5, fp_parse_all_u64(in, &end, vals, 5));
+  uint64_t exp[] = {123, 3, 2, 5, 4};
+  TEST_ASSERT_EQUAL_INT_ARRAY(exp, vals, 5);
+  TEST_ASSERT_EQUAL_PTR(in + sizeof(in) - 1, end);
+}
+
+void test_parse_all_u64_stops_at_max(void){
+  const char in[] = "1 2 3 4";
+  const char* end;
+  uint64_t vals[2];
+  TEST_ASSERT_EQUAL_INT(2, fp_parse_all_u64(in, &end, vals, 2));
+  TEST_ASSERT_EQUAL_UINT64(2, vals[1]);
+  TEST_ASSERT_EQUAL_PTR(in + 3, end);
+}
+
+void test_parse_all_u64_end_behind_last_number(void){
+  const char in[] = "a1b ";
+  const char* end;
+  uint64_t vals[4];
+  TEST_ASSERT_EQUAL_INT(1, fp_parse_all_u64(in, &end, vals, 4));
+  TEST_ASSERT_EQUAL_PTR(in + 2, end);
+}
+
+void test_parse_all_u64_ignores_signs(void){
+  const char in[] = "[1518-11-01 00:05]";
+  uint64_t vals[5];
+  TEST_ASSERT_EQUAL_INT(5, fp_parse_all_u64(in, NULL, vals, 5));
+  uint64_t exp[] = {1518, 11, 1, 0, 5};
+  TEST_ASSERT_EQUAL_INT_ARRAY(exp, vals, 5);
+}
+
+void test_parse_all_i64_signs(void){
+  const char in[] = "+3, -4 - 5";
+  int64_t vals[3];
+  TEST_ASSERT_EQUAL_INT(3, fp_parse_all_i64(in, NULL, vals, 3));
+  int64_t exp[] = {3, -4, 5};
+  TEST_ASSERT_EQUAL_INT_ARRAY(exp, vals, 3);
+}
+
+void test_parse_all_overflow_returns_error(void){
+  const char in[] = "1 99999999999999999999 2";
+  const char* end;
+  uint64_t vals[3];
+  TEST_ASSERT_EQUAL_INT(-1, fp_parse_all_u64(in, &end, vals, 3));
+  TEST_ASSERT_EQUAL_PTR(in + 2, end);
+}
+
+void test_parse_all_empty_string(void){
+  int64_t vals[1];
+  TEST_ASSERT_EQUAL_INT(0, fp_parse_all_i64("", NULL, vals, 1));
+}
+
+void test_scalar_and_swar_always_supported(void){
+  TEST_ASSERT_EQUAL_INT(0, fp_set_impl(FP_IMPL_SCALAR));
+  TEST_ASSERT_EQUAL_INT(FP_IMPL_SCALAR, fp_get_impl());
+  TEST_ASSERT_EQUAL_INT(0, fp_set_impl(FP_IMPL_SWAR));
+  TEST_ASSERT_EQUAL_INT(FP_IMPL_SWAR, fp_get_impl());
+}
+
+// Longest number of the test pattern which fits into 64 bits
+#define SAFE_LEN 19
+
+void test_impls_agree_on_all_lengths(void){
+  char in[64];
+  for(int impl = FP_IMPL_SCALAR; impl <= FP_IMPL_AVX2; impl++){
+    if(fp_set_impl(impl) != 0){
+      continue;
+    }
+    for(int len = 0; len <= SAFE_LEN; len++){
+      uint64_t exp = 0;
+      for(int i = 0; i < len; i++){
+        in[i] = '1' + (i*7) % 9;
+        exp = 10*exp + (uint64_t) (in[i] - '0');
+      }
+      strcpy(in + len, ",123456789012345678");
+      const char* end;
+      uint64_t val;
+      TEST_ASSERT_EQUAL_INT(len == 0 ? FP_NO_DIGITS : FP_OK,
+                            fp_parse_u64(in, &end, &val));
+      TEST_ASSERT_EQUAL_UINT64(exp, val);
+      TEST_ASSERT_EQUAL_PTR(in + len, end);
+    }
+  }
+}
+
+void test_impls_agree_on_random_input(void){
+  char in[4096];
+  srand(16);
+  for(size_t i = 0; i < sizeof(in) - 1; i++){
+    in[i] = "0123456789012345678901234567890123456789 ,x:-"[rand() % 45];
+  }
+  in[sizeof(in) - 1] = '\0';
+  uint64_t exp[sizeof(in)];
+  fp_set_impl(FP_IMPL_SCALAR);
+  for(size_t i = 0; i < sizeof(in); i++){
+    fp_parse_u64(in + i, NULL, &exp[i]);
+  }
+  for(int impl = FP_IMPL_SWAR; impl <= FP_IMPL_AVX2; impl++){
+    if(fp_set_impl(impl) != 0){
+      continue;
+    }
+    for(size_t i = 0; i < sizeof(in); i++){
+      uint64_t val;
+      fp_parse_u64(in + i, NULL, &val);
+      TEST_ASSERT_EQUAL_UINT64(exp[i], val);
+    }
+  }
+}
+
+void test_number_at_page_end(void){
+  char* pages = aligned_alloc(4096, 2*4096);
+  memset(pages, 'x', 2*4096);
+  char* num = pages + 4096 - 6;
+  memcpy(num, "12345", 6);
+  for(int impl = FP_IMPL_SCALAR; impl <= FP_IMPL_AVX2; impl++){
+    if(fp_set_impl(impl) != 0){
+      continue;
+    }
+    const char* end;
+    uint64_t val;
+    TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_u64(num, &end, &val));
+    TEST_ASSERT_EQUAL_UINT64(12345, val);
+    TEST_ASSERT_EQUAL_PTR(num + 5, end);
+  }
+  free(pages);
+}
+
+void test_sum_lines_signs_and_empty_lines(void){
+  const char in[] = "+1\n-20\n\n+300x\n4000\n\n-5";
+  for(int impl = FP_IMPL_SCALAR; impl <= FP_IMPL_AVX2; impl++){
+    if(fp_set_impl(impl) != 0){
+      continue;
+    }
+    int64_t sum;
+    const char* bad;
+    TEST_ASSERT_EQUAL_INT(FP_OK, fp_sum_lines_i64(in, strlen(in), &sum, &bad));
+    TEST_ASSERT_EQUAL_INT64(4276, sum);
+    TEST_ASSERT_NULL(bad);
+  }
+}
+
+void test_sum_lines_long_numbers(void){
+  const char in[] = "+12345678\n-123456789\n+9223372036854775807\n"
+    "-00000000000000000000000000042\n";
+  for(int impl = FP_IMPL_SCALAR; impl <= FP_IMPL_AVX2; impl++){
+    if(fp_set_impl(impl) != 0){
+      continue;
+    }
+    int64_t sum;
+    TEST_ASSERT_EQUAL_INT(FP_OK, fp_sum_lines_i64(in, strlen(in), &sum, NULL));
+    TEST_ASSERT_EQUAL_INT64(INT64_MAX - 111111153, sum);
+  }
+}
+
+void test_sum_lines_no_digits(void){
+  const char in[] = "+1\n+\n-2\n";
+  int64_t sum;
+  const char* bad;
+  TEST_ASSERT_EQUAL_INT(FP_NO_DIGITS,
+                        fp_sum_lines_i64(in, strlen(in), &sum, &bad));
+  TEST_ASSERT_EQUAL_PTR(in + 3, bad);
+  TEST_ASSERT_EQUAL_INT64(0, sum);
+}
+
+void test_sum_lines_number_overflow(void){
+  const char in[] = "+1\n-9223372036854775809\n";
+  int64_t sum;
+  const char* bad;
+  TEST_ASSERT_EQUAL_INT(FP_OVERFLOW,
+                        fp_sum_lines_i64(in, strlen(in), &sum, &bad));
+  TEST_ASSERT_EQUAL_PTR(in + 3, bad);
+}
+
+void test_sum_lines_sum_overflow(void){
+  // The overflow only shows once a batch of short numbers is added
+  size_t n = 1000;
+  char* in = malloc(32 + 10*n);
+  TEST_ASSERT_NOT_NULL(in);
+  char* p = in + sprintf(in, "+9223372036854775000\n");
+  for(size_t i = 0; i < n; i++){
+    p += sprintf(p, "+99999999\n");
+  }
+  for(int impl = FP_IMPL_SCALAR; impl <= FP_IMPL_AVX2; impl++){
+    if(fp_set_impl(impl) != 0){
+      continue;
+    }
+    int64_t sum;
+    const char* bad = in;
+    TEST_ASSERT_EQUAL_INT(FP_OVERFLOW,
+                          fp_sum_lines_i64(in, p - in, &sum, &bad));
+    TEST_ASSERT_NULL(bad);
+  }
+  free(in);
+}
+
+void test_sum_lines_impls_agree_on_random_lines(void){
+  size_t n = 5000;
+  char* in = malloc(32*n + 1);
+  TEST_ASSERT_NOT_NULL(in);
+  srand(18);
+  char* p = in;
+  int64_t exp = 0;
+  for(size_t i = 0; i < n; i++){
+    char* line = p;
+    if(rand() % 3 > 0){
+      *p++ = rand() % 2 ? '+' : '-';
+    }
+    for(int d = rand() % 14; d >= 0; d--){
+      *p++ = '0' + rand() % 10;
+    }
+    if(rand() % 8 == 0){
+      *p++ = 'x';
+    }
+    int64_t val;
+    TEST_ASSERT_EQUAL_INT(FP_OK, fp_parse_i64(line, NULL, &val));
+    exp += val;
+    *p++ = '\n';
+  }
+  *p = '\0';
+  for(int impl = FP_IMPL_SCALAR; impl <= FP_IMPL_AVX2; impl++){
+    if(fp_set_impl(impl) != 0){
+      continue;
+    }
+    // Without the last newline, too
+    for(size_t cut = 0; cut < 2; cut++){
+      int64_t sum;
+      TEST_ASSERT_EQUAL_INT(FP_OK,
+                            fp_sum_lines_i64(in, p - in - cut, &sum, NULL));
+      TEST_ASSERT_EQUAL_INT64(exp, sum);
+    }
+  }
+  free(in);
+}
+
+int main(void){
+  UNITY_BEGIN();
+  RUN_TEST(test_parse_u64_single_digit);
+  RUN_TEST(test_parse_u64_stops_at_non_digit);
+  RUN_TEST(test_parse_u64_no_digits);
+  RUN_TEST(test_parse_u64_max);
+  RUN_TEST(test_parse_u64_leading_zeros_do_not_overflow);
+  RUN_TEST(test_parse_u64_overflow_consumes_digits);
+  RUN_TEST(test_parse_i64_signs);
+  RUN_TEST(test_parse_i64_sign_without_digits);
+  RUN_TEST(test_parse_i64_limits);
+  RUN_TEST(test_parse_i64_overflow_saturates);
+  RUN_TEST(test_parse_all_u64_claim);
+  RUN_TEST(test_parse_all_u64_stops_at_max);
+  RUN_TEST(test_parse_all_u64_end_behind_last_number);
+  RUN_TEST(test_parse_all_u64_ignores_signs);
+  RUN_TEST(test_parse_all_i64_signs);
+  RUN_TEST(test_parse_all_overflow_returns_error);
+  RUN_TEST(test_parse_all_empty_string);
+  RUN_TEST(test_scalar_and_swar_always_supported);
+  RUN_TEST(test_impls_agree_on_all_lengths);
+  RUN_TEST(test_impls_agree_on_random_input);
+  RUN_TEST(test_number_at_page_end);
+  RUN_TEST(test_sum_lines_signs_and_empty_lines);
+  RUN_TEST(test_sum_lines_long_numbers);
+  RUN_TEST(test_sum_lines_no_digits);
+  RUN_TEST(test_sum_lines_number_overflow);
+  RUN_TEST(test_sum_lines_sum_overflow);
+  RUN_TEST(test_sum_lines_impls_agree_on_random_lines);
+  return UNITY_END();
+}
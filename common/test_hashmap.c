@@ -0,0 +1,141 @@
+/**
+ * @file test_hashmap.c
+ * @brief UTs for the open addressing hash sets and maps
+ */
+
+#include "hashmap.h"
+
+#include <unity.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+HASHSET_DEFINE(lset, long)
+HASHMAP_DEFINE(umap, unsigned, size_t)
+
+void test_empty_set_contains_nothing(void){
+  lset_t s;
+  lset_init(&s);
+  TEST_ASSERT_FALSE(lset_contains(&s, 0));
+  TEST_ASSERT_EQUAL_size_t(0, lset_len(&s));
+  lset_free(&s);
+}
+
+void test_set_insert_reports_new_keys(void){
+  lset_t s;
+  lset_init(&s);
+  TEST_ASSERT_EQUAL_INT(1, lset_insert(&s, 5));
+  TEST_ASSERT_EQUAL_INT(1, lset_insert(&s, -5));
+  TEST_ASSERT_EQUAL_INT(0, lset_insert(&s, 5));
+  TEST_ASSERT_TRUE(lset_contains(&s, 5));
+  TEST_ASSERT_TRUE(lset_contains(&s, -5));
+  TEST_ASSERT_FALSE(lset_contains(&s, 6));
+  TEST_ASSERT_EQUAL_size_t(2, lset_len(&s));
+  lset_free(&s);
+}
+
+void test_set_grows_and_keeps_keys(void){
+  lset_t s;
+  lset_init(&s);
+  for(long i = -5000; i < 5000; i++){
+    TEST_ASSERT_EQUAL_INT(1, lset_insert(&s, 3*i));
+  }
+  TEST_ASSERT_EQUAL_size_t(10000, lset_len(&s));
+  for(long i = -15000; i < 15000; i++){
+    TEST_ASSERT_EQUAL_INT(i % 3 == 0, lset_contains(&s, i));
+  }
+  lset_free(&s);
+}
+
+void test_reserve_avoids_growing(void){
+  lset_t s;
+  lset_init(&s);
+  TEST_ASSERT_EQUAL_INT(0, lset_reserve(&s, 1000));
+  size_t cap = s.cap;
+  TEST_ASSERT_TRUE(cap >= 1000);
+  for(long i = 0; i < 1000; i++){
+    lset_insert(&s, i);
+  }
+  TEST_ASSERT_EQUAL_size_t(cap, s.cap);
+  TEST_ASSERT_EQUAL_INT(0, lset_reserve(&s, 10));
+  TEST_ASSERT_EQUAL_size_t(cap, s.cap);
+  lset_free(&s);
+}
+
+void test_colliding_keys_are_kept_apart(void){
+  lset_t s;
+  lset_init(&s);
+  lset_reserve(&s, 4);
+  // Keys which only differ in their high bits
+  for(long i = 0; i < 12; i++){
+    lset_insert(&s, i << 40);
+  }
+  for(long i = 0; i < 12; i++){
+    TEST_ASSERT_TRUE(lset_contains(&s, i << 40));
+  }
+  TEST_ASSERT_FALSE(lset_contains(&s, 12l << 40));
+  lset_free(&s);
+}
+
+void test_map_get_missing_returns_null(void){
+  umap_t m;
+  umap_init(&m);
+  TEST_ASSERT_NULL(umap_get(&m, 7));
+  umap_put(&m, 8, NULL);
+  TEST_ASSERT_NULL(umap_get(&m, 7));
+  umap_free(&m);
+}
+
+void test_map_put_zeroes_new_values(void){
+  umap_t m;
+  umap_init(&m);
+  bool inserted;
+  size_t* val = umap_put(&m, 3, &inserted);
+  TEST_ASSERT_TRUE(inserted);
+  TEST_ASSERT_EQUAL_size_t(0, *val);
+  *val = 42;
+  val = umap_put(&m, 3, &inserted);
+  TEST_ASSERT_FALSE(inserted);
+  TEST_ASSERT_EQUAL_size_t(42, *val);
+  umap_free(&m);
+}
+
+void test_map_values_survive_growing(void){
+  umap_t m;
+  umap_init(&m);
+  for(unsigned i = 0; i < 1000; i++){
+    *umap_put(&m, i*7919u, NULL) = i;
+  }
+  for(unsigned i = 0; i < 1000; i++){
+    size_t* val = umap_get(&m, i*7919u);
+    TEST_ASSERT_NOT_NULL(val);
+    TEST_ASSERT_EQUAL_size_t(i, *val);
+  }
+  TEST_ASSERT_EQUAL_size_t(1000, umap_len(&m));
+  umap_free(&m);
+}
+
+void test_free_leaves_empty_table(void){
+  umap_t m;
+  umap_init(&m);
+  umap_put(&m, 1, NULL);
+  umap_free(&m);
+  TEST_ASSERT_EQUAL_size_t(0, umap_len(&m));
+  TEST_ASSERT_NULL(umap_get(&m, 1));
+  umap_free(&m);
+}
+
+int main(void){
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_set_contains_nothing);
+  RUN_TEST(test_set_insert_reports_new_keys);
+  RUN_TEST(test_set_grows_and_keeps_keys);
+  RUN_TEST(test_reserve_avoids_growing);
+  RUN_TEST(test_colliding_keys_are_kept_apart);
+  RUN_TEST(test_map_get_missing_returns_null);
+  RUN_TEST(test_map_put_zeroes_new_values);
+  RUN_TEST(test_map_values_survive_growing);
+  RUN_TEST(test_free_leaves_empty_table);
+  return UNITY_END();
+}
@@ -0,0 +1,80 @@
+/**
+ * @file test_idxlist.c
+ * @brief UTs for the index based Double Linked List
+ */
+
+#include "idxlist.h"
+
+#include <unity.h>
+
+#include <stddef.h>
+
+void test_init_empty_list(void){
+  idxlist_t l;
+  idxlist_init_full(&l, NULL, 0);
+  TEST_ASSERT_EQUAL_UINT32(IDXLIST_NIL, idxlist_head(&l));
+  TEST_ASSERT_EQUAL_UINT32(IDXLIST_NIL, idxlist_tail(&l));
+  TEST_ASSERT_EQUAL_UINT32(0, l.len);
+}
+
+void test_init_full_links_all_in_order(void){
+  idx_link_t links[5];
+  idxlist_t l;
+  idxlist_init_full(&l, links, 5);
+  uint32_t expected = 0;
+  for(uint32_t i = idxlist_head(&l); i != IDXLIST_NIL; i = idxlist_next(&l, i)){
+    TEST_ASSERT_EQUAL_UINT32(expected++, i);
+    TEST_ASSERT_TRUE(idxlist_contains(&l, i));
+  }
+  TEST_ASSERT_EQUAL_UINT32(5, expected);
+  for(uint32_t i = idxlist_tail(&l); i != IDXLIST_NIL; i = idxlist_prev(&l, i)){
+    TEST_ASSERT_EQUAL_UINT32(--expected, i);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, expected);
+}
+
+void test_remove_middle_relinks_and_returns_next(void){
+  idx_link_t links[3];
+  idxlist_t l;
+  idxlist_init_full(&l, links, 3);
+  TEST_ASSERT_EQUAL_UINT32(2, idxlist_remove(&l, 1));
+  TEST_ASSERT_EQUAL_UINT32(2, idxlist_next(&l, 0));
+  TEST_ASSERT_EQUAL_UINT32(0, idxlist_prev(&l, 2));
+  TEST_ASSERT_FALSE(idxlist_contains(&l, 1));
+  TEST_ASSERT_EQUAL_UINT32(2, l.len);
+}
+
+void test_remove_head_and_tail_update_ends(void){
+  idx_link_t links[3];
+  idxlist_t l;
+  idxlist_init_full(&l, links, 3);
+  TEST_ASSERT_EQUAL_UINT32(1, idxlist_remove(&l, 0));
+  TEST_ASSERT_EQUAL_UINT32(IDXLIST_NIL, idxlist_remove(&l, 2));
+  TEST_ASSERT_EQUAL_UINT32(1, idxlist_head(&l));
+  TEST_ASSERT_EQUAL_UINT32(1, idxlist_tail(&l));
+  TEST_ASSERT_EQUAL_UINT32(IDXLIST_NIL, idxlist_prev(&l, 1));
+  TEST_ASSERT_EQUAL_UINT32(IDXLIST_NIL, idxlist_next(&l, 1));
+}
+
+void test_remove_all_leaves_empty_list(void){
+  idx_link_t links[4];
+  idxlist_t l;
+  idxlist_init_full(&l, links, 4);
+  uint32_t i = idxlist_head(&l);
+  while(i != IDXLIST_NIL){
+    i = idxlist_remove(&l, i);
+  }
+  TEST_ASSERT_EQUAL_UINT32(IDXLIST_NIL, idxlist_head(&l));
+  TEST_ASSERT_EQUAL_UINT32(IDXLIST_NIL, idxlist_tail(&l));
+  TEST_ASSERT_EQUAL_UINT32(0, l.len);
+}
+
+int main(void){
+  UNITY_BEGIN();
+  RUN_TEST(test_init_empty_list);
+  RUN_TEST(test_init_full_links_all_in_order);
+  RUN_TEST(test_remove_middle_relinks_and_returns_next);
+  RUN_TEST(test_remove_head_and_tail_update_ends);
+  RUN_TEST(test_remove_all_leaves_empty_list);
+  return UNITY_END();
+}
@@ -0,0 +1,99 @@
+/**
+ * @file test_ilist.c
+ * @brief UTs for the intrusive Double Linked List
+ */
+
+#include "ilist.h"
+
+#include <unity.h>
+
+#include <stddef.h>
+
+struct item{
+  int value;
+  ilist_link_t link;
+};
+
+static int value_of(ilist_link_t* link){
+  return ILIST_ENTRY(link, struct item, link)->value;
+}
+
+void test_init_list_is_empty(void){
+  ilist_t l;
+  ilist_init(&l);
+  TEST_ASSERT_TRUE(ilist_empty(&l));
+  TEST_ASSERT_NULL(ilist_head(&l));
+  TEST_ASSERT_NULL(ilist_tail(&l));
+}
+
+void test_entry_returns_containing_struct(void){
+  struct item it = {.value = 7};
+  TEST_ASSERT_EQUAL_PTR(&it, ILIST_ENTRY(&it.link, struct item, link));
+}
+
+void test_append_keeps_order(void){
+  struct item items[4] = {{.value = 0}, {.value = 1}, {.value = 2}, {.value = 3}};
+  ilist_t l;
+  ilist_init(&l);
+  for(int i = 0; i < 4; i++){
+    ilist_append(&l, &items[i].link);
+  }
+  int expected = 0;
+  for(ilist_link_t* it = ilist_head(&l); it != NULL; it = ilist_next(&l, it)){
+    TEST_ASSERT_EQUAL_INT(expected++, value_of(it));
+  }
+  TEST_ASSERT_EQUAL_INT(4, expected);
+  for(ilist_link_t* it = ilist_tail(&l); it != NULL; it = ilist_prev(&l, it)){
+    TEST_ASSERT_EQUAL_INT(--expected, value_of(it));
+  }
+  TEST_ASSERT_EQUAL_INT(0, expected);
+}
+
+void test_remove_middle_relinks_and_returns_next(void){
+  struct item items[3] = {{.value = 0}, {.value = 1}, {.value = 2}};
+  ilist_t l;
+  ilist_init(&l);
+  for(int i = 0; i < 3; i++){
+    ilist_append(&l, &items[i].link);
+  }
+  ilist_link_t* succ = ilist_remove(&l, &items[1].link);
+  TEST_ASSERT_EQUAL_PTR(&items[2].link, succ);
+  TEST_ASSERT_EQUAL_PTR(&items[2].link, ilist_next(&l, &items[0].link));
+  TEST_ASSERT_EQUAL_PTR(&items[0].link, ilist_prev(&l, &items[2].link));
+  TEST_ASSERT_FALSE(ilist_linked(&items[1].link));
+  TEST_ASSERT_TRUE(ilist_linked(&items[0].link));
+}
+
+void test_remove_tail_returns_null(void){
+  struct item items[2] = {{.value = 0}, {.value = 1}};
+  ilist_t l;
+  ilist_init(&l);
+  ilist_append(&l, &items[0].link);
+  ilist_append(&l, &items[1].link);
+  TEST_ASSERT_NULL(ilist_remove(&l, &items[1].link));
+  TEST_ASSERT_EQUAL_PTR(&items[0].link, ilist_tail(&l));
+}
+
+void test_remove_all_leaves_empty_list(void){
+  struct item items[2] = {{.value = 0}, {.value = 1}};
+  ilist_t l;
+  ilist_init(&l);
+  ilist_append(&l, &items[0].link);
+  ilist_append(&l, &items[1].link);
+  ilist_link_t* it = ilist_head(&l);
+  while(it != NULL){
+    it = ilist_remove(&l, it);
+  }
+  TEST_ASSERT_TRUE(ilist_empty(&l));
+}
+
+int main(void){
+  UNITY_BEGIN();
+  RUN_TEST(test_init_list_is_empty);
+  RUN_TEST(test_entry_returns_containing_struct);
+  RUN_TEST(test_append_keeps_order);
+  RUN_TEST(test_remove_middle_relinks_and_returns_next);
+  RUN_TEST(test_remove_tail_returns_null);
+  RUN_TEST(test_remove_all_leaves_empty_list);
+  return UNITY_END();
+}
@@ -0,0 +1,134 @@
+/**
+ * @file test_line_stream.c
+ * @brief UTs for line_stream.c
+ */
+
+#include <unity.h>
+#include "line_stream.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+
+static char fpath[] = "/tmp/line_stream_ut_XXXXXX";
+
+void write_input(const char* content){
+  strcpy(fpath, "/tmp/line_stream_ut_XXXXXX");
+  int fd = mkstemp(fpath);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  size_t len = strlen(content);
+  TEST_ASSERT_EQUAL_INT(len, write(fd, content, len));
+  close(fd);
+}
+
+void tearDown(void){
+  unlink(fpath);
+}
+
+void test_open_missing_file_returns_null(void){
+  errno = 0;
+  lstream_t* ls = ls_open("/tmp/does/not/exist.txt", "\n", 0);
+  TEST_ASSERT_NULL(ls);
+  TEST_ASSERT_EQUAL_INT(ENOENT, errno);
+}
+
+void test_open_empty_delim_returns_null(void){
+  write_input("foo\n");
+  errno = 0;
+  lstream_t* ls = ls_open(fpath, "", 0);
+  TEST_ASSERT_NULL(ls);
+  TEST_ASSERT_EQUAL_INT(EINVAL, errno);
+}
+
+void test_empty_file_has_no_lines(void){
+  write_input("");
+  lstream_t* ls = ls_open(fpath, "\n", 0);
+  TEST_ASSERT_NOT_NULL(ls);
+  TEST_ASSERT_NULL(ls_next(ls, NULL));
+  TEST_ASSERT_EQUAL_INT(0, ls_error(ls));
+  ls_close(ls);
+}
+
+void test_lines_and_lengths(void){
+  write_input("Hello,\nWorld.\n");
+  size_t len;
+  lstream_t* ls = ls_open(fpath, "\n", 0);
+  TEST_ASSERT_EQUAL_STRING("Hello,", ls_next(ls, &len));
+  TEST_ASSERT_EQUAL_UINT(6, len);
+  TEST_ASSERT_EQUAL_STRING("World.", ls_next(ls, &len));
+  TEST_ASSERT_EQUAL_UINT(6, len);
+  TEST_ASSERT_NULL(ls_next(ls, &len));
+  ls_close(ls);
+}
+
+void test_last_line_without_delim(void){
+  write_input("foo\nbar");
+  lstream_t* ls = ls_open(fpath, "\n", 0);
+  TEST_ASSERT_EQUAL_STRING("foo", ls_next(ls, NULL));
+  TEST_ASSERT_EQUAL_STRING("bar", ls_next(ls, NULL));
+  TEST_ASSERT_NULL(ls_next(ls, NULL));
+  ls_close(ls);
+}
+
+void test_repeated_delims_skipped(void){
+  write_input("\n\nfoo\n\n\nbar\n\n");
+  lstream_t* ls = ls_open(fpath, "\n", 0);
+  TEST_ASSERT_EQUAL_STRING("foo", ls_next(ls, NULL));
+  TEST_ASSERT_EQUAL_STRING("bar", ls_next(ls, NULL));
+  TEST_ASSERT_NULL(ls_next(ls, NULL));
+  ls_close(ls);
+}
+
+void test_lines_straddling_chunks(void){
+  write_input("+12\n-345\n+6\n+7890\n-1\n");
+  const char* exp[] = {"+12", "-345", "+6", "+7890", "-1"};
+  // Chunk sizes smaller than, equal to and larger than the lines
+  for(size_t chunk = 1; chunk < 8; chunk++){
+    lstream_t* ls = ls_open(fpath, "\n", chunk);
+    for(size_t i = 0; i < 5; i++){
+      TEST_ASSERT_EQUAL_STRING(exp[i], ls_next(ls, NULL));
+    }
+    TEST_ASSERT_NULL(ls_next(ls, NULL));
+    ls_close(ls);
+  }
+}
+
+void test_reset_restarts_stream(void){
+  write_input("foo\nbar\nbaz");
+  lstream_t* ls = ls_open(fpath, "\n", 2);
+  TEST_ASSERT_EQUAL_STRING("foo", ls_next(ls, NULL));
+  TEST_ASSERT_EQUAL_STRING("bar", ls_next(ls, NULL));
+  ls_reset(ls);
+  TEST_ASSERT_EQUAL_STRING("foo", ls_next(ls, NULL));
+  TEST_ASSERT_EQUAL_STRING("bar", ls_next(ls, NULL));
+  TEST_ASSERT_EQUAL_STRING("baz", ls_next(ls, NULL));
+  TEST_ASSERT_NULL(ls_next(ls, NULL));
+  ls_close(ls);
+}
+
+void test_multiple_delims(void){
+  write_input("a,b\nc");
+  lstream_t* ls = ls_open(fpath, ",\n", 0);
+  TEST_ASSERT_EQUAL_STRING("a", ls_next(ls, NULL));
+  TEST_ASSERT_EQUAL_STRING("b", ls_next(ls, NULL));
+  TEST_ASSERT_EQUAL_STRING("c", ls_next(ls, NULL));
+  TEST_ASSERT_NULL(ls_next(ls, NULL));
+  ls_close(ls);
+}
+
+int main(void){
+  UNITY_BEGIN();
+  RUN_TEST(test_open_missing_file_returns_null);
+  RUN_TEST(test_open_empty_delim_returns_null);
+  RUN_TEST(test_empty_file_has_no_lines);
+  RUN_TEST(test_lines_and_lengths);
+  RUN_TEST(test_last_line_without_delim);
+  RUN_TEST(test_repeated_delims_skipped);
+  RUN_TEST(test_lines_straddling_chunks);
+  RUN_TEST(test_reset_restarts_stream);
+  RUN_TEST(test_multiple_delims);
+  return UNITY_END();
+}
@@ -3,6 +3,7 @@
  * @brief Tests for main.c
  */
 
+#include "alloc_count.h"
 #include "aoc_err.h"
 #include "common_mocks.h"
 #include "main.h"
@@ -14,6 +15,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <unistd.h>
+
 FILE* stdout_ut = NULL;
 FILE* stderr_ut = NULL;
 
@@ -35,6 +38,7 @@ char* empty_func(tok_t* tok){
 void setUp(void){
   func_callcount = 0;
   func_param = NULL;
+  func_retval = NULL;
 
   // Output streams for main.c message checking
   stdout_ut = open_memstream(&stdout_data.streambuff, &stdout_data.streamsize);
@@ -43,11 +47,14 @@ void setUp(void){
   fflush(stderr_ut);
 
   // Set up common function mocks
-  mock_mm_file_read = malloc(sizeof(struct mock_mm_file_read_t));
-  mock_mm_file_read->callcount = 0;
-  mock_mm_file_read->param_1 = NULL;
-  mock_mm_file_read->retval = NULL;
-  mock_mm_file_read->set_errno_to = 0;
+  mock_mm_file_open = malloc(sizeof(struct mock_mm_file_open_t));
+  mock_mm_file_open->callcount = 0;
+  mock_mm_file_open->param_1 = NULL;
+  mock_mm_file_open->retval = NULL;
+  mock_mm_file_open->set_errno_to = 0;
+
+  mock_mm_file_close = malloc(sizeof(struct mock_mm_file_close_t));
+  mock_mm_file_close->callcount = 0;
 
   mock_get_tokenizer = malloc(sizeof(struct mock_get_tokenizer_t));
   mock_get_tokenizer->callcount = 0;
@@ -55,15 +62,38 @@ void setUp(void){
   mock_get_tokenizer->param_2 = NULL;
   mock_get_tokenizer->retval = NULL;
 
+  mock_get_stream_tokenizer = malloc(sizeof(struct mock_get_stream_tokenizer_t));
+  mock_get_stream_tokenizer->callcount = 0;
+  mock_get_stream_tokenizer->param_1 = NULL;
+  mock_get_stream_tokenizer->retval = NULL;
+  mock_get_stream_tokenizer->set_errno_to = 0;
+
+  mock_tok_error = malloc(sizeof(struct mock_tok_error_t));
+  mock_tok_error->callcount = 0;
+  mock_tok_error->retval = 0;
+
+  mock_tok_count = malloc(sizeof(struct mock_tok_count_t));
+  mock_tok_count->callcount = 0;
+  mock_tok_count->retval = 0;
+
   mock_n_tok = malloc(sizeof(struct mock_n_tok_t));
   mock_n_tok->callcount = 0;
   mock_n_tok->param_1 = NULL;
   mock_n_tok->retval = NULL;
 
+  mock_reset_tok = malloc(sizeof(struct mock_reset_tok_t));
+  mock_reset_tok->callcount = 0;
+  mock_reset_tok->param_1 = NULL;
+
   mock_free_tok = malloc(sizeof(struct mock_free_tok_t));
   mock_free_tok->callcount = 0;
   mock_free_tok->param_1 = NULL;
 
+  mock_reload_tok = malloc(sizeof(struct mock_reload_tok_t));
+  mock_reload_tok->callcount = 0;
+  mock_reload_tok->param_1 = NULL;
+  mock_reload_tok->retval = 0;
+
   mock_get_latest_aoc_err_msg = malloc(sizeof(struct mock_get_latest_aoc_err_msg_t));
   mock_get_latest_aoc_err_msg->callcount = 0;
   mock_get_latest_aoc_err_msg->retval = NULL;
@@ -79,24 +109,33 @@ void tearDown(void){
   free(stderr_data.streambuff);
 
   // Free function mocks
-  free(mock_mm_file_read->param_1);
-  free(mock_mm_file_read);
+  free(mock_mm_file_open->param_1);
+  free(mock_mm_file_open);
+  free(mock_mm_file_close);
 
   free(mock_get_tokenizer->param_1);
   free(mock_get_tokenizer->param_2);
   free(mock_get_tokenizer);
 
+  free(mock_get_stream_tokenizer->param_1);
+  free(mock_get_stream_tokenizer);
+  free(mock_tok_error);
+  free(mock_tok_count);
+
   free(mock_n_tok->param_1);
   free(mock_n_tok);
 
+  free(mock_reset_tok);
   free(mock_free_tok);
+  free(mock_reload_tok);
   free(mock_get_latest_aoc_err_msg);
 }
 
 void test_too_few_cli_args_prints_usage(void){
   char* argv[] = {"main"};
   int argc = 1;
-  const char* exp = "Too few arguments.\nUsage: main 1|2 INPUT_FILE\n";
+  const char* exp = "Too few arguments.\n"
+    "Usage: main [--bench N | --manifest FILE | --stats] [--perf] [--trace FILE] [--jobs N] 1|2|both INPUT_FILE...\n";
   int res = aoc_main(argc, argv, empty_func, NULL);
   fflush(stdout_ut);
   TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
@@ -104,9 +143,10 @@ void test_too_few_cli_args_prints_usage(void){
 }
 
 void test_too_many_cli_args_prints_usage(void){
-  char* argv[] = {"main","1","foo","bar"};
-  int argc = 4;
-  const char* exp = "Too many arguments.\nUsage: main 1|2 INPUT_FILE\n";
+  char* argv[] = {"main","--bench","2","1","foo","bar"};
+  int argc = 6;
+  const char* exp = "Too many arguments.\n"
+    "Usage: main [--bench N | --manifest FILE | --stats] [--perf] [--trace FILE] [--jobs N] 1|2|both INPUT_FILE...\n";
   int res = aoc_main(argc, argv, empty_func, NULL);
   fflush(stdout_ut);
   TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
@@ -147,7 +187,7 @@ void test_both_part_funcs_null_prints_error(void){
 void test_invalid_part_number_supplied(void){
   char* argv[] = {"main","3","file.txt"};
   int argc = 3;
-  const char* exp = "\"3\" is an invalid part number. Choose 1 or 2.\n";
+  const char* exp = "\"3\" is an invalid part number. Choose 1, 2 or both.\n";
   int res = aoc_main(argc, argv, NULL, NULL);
   fflush(stderr_ut);
   TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
@@ -159,10 +199,10 @@ void test_file_read_gets_unchanged_path(void){
   int argc = 3;
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   aoc_main(argc, argv, empty_func, NULL);
-  TEST_ASSERT_EQUAL_STRING("missing.txt",mock_mm_file_read->param_1);
-  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_read->callcount);
+  TEST_ASSERT_EQUAL_STRING("missing.txt",mock_mm_file_open->param_1);
+  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_open->callcount);
 }
 
 void test_file_missing_error_printed(void){
@@ -171,22 +211,22 @@ void test_file_missing_error_printed(void){
   char exp[1024] = "Error loading input: ";
   snprintf(exp, 1024, "Error loading input from missing.txt: %s\n",
            strerror(ENOENT));
-  mock_mm_file_read->retval = NULL;
-  mock_mm_file_read->set_errno_to = ENOENT;
+  mock_mm_file_open->retval = NULL;
+  mock_mm_file_open->set_errno_to = ENOENT;
   aoc_main(argc, argv, empty_func, NULL);
   fflush(stderr_ut);
   TEST_ASSERT_EQUAL_STRING(exp,stderr_data.streambuff);
-  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_read->callcount);
+  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_open->callcount);
 }
 
 void test_file_loading_error_aborts(void){
   char* argv[] = {"main", "1", "missing.txt"};
   int argc = 3;
-  mock_mm_file_read->retval = NULL;
-  mock_mm_file_read->set_errno_to = ENOENT;
+  mock_mm_file_open->retval = NULL;
+  mock_mm_file_open->set_errno_to = ENOENT;
   int res = aoc_main(argc, argv, empty_func, NULL);
   TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, res);
-  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_read->callcount);
+  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_open->callcount);
   TEST_ASSERT_EQUAL_INT(0,mock_get_tokenizer->callcount);
   TEST_ASSERT_EQUAL_INT(0,mock_free_tok->callcount);
   TEST_ASSERT_EQUAL_INT(0,func_callcount);
@@ -198,7 +238,7 @@ void test_tokenizer_gets_string_from_file(void){
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
   tok_t tok;
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   mock_get_tokenizer->retval = &tok;
   aoc_main(argc, argv, empty_func, NULL);
   TEST_ASSERT_EQUAL_INT(1,mock_get_tokenizer->callcount);
@@ -212,7 +252,7 @@ void test_tokenizer_failure_error_printed(void){
   char exp[] = "Error initializing input tokenizer.\n";
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   mock_get_tokenizer->retval = NULL;
   aoc_main(argc, argv, empty_func, NULL);
   fflush(stderr_ut);
@@ -225,7 +265,7 @@ void test_tokenizer_failure_aborts(void){
   int argc = 3;
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   mock_get_tokenizer->retval = NULL;
   int res = aoc_main(argc, argv, empty_func, NULL);
   TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, res);
@@ -239,7 +279,7 @@ void test_tokenizer_handed_to_func(void){
   int argc = 3;
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   tok_t tok;
   tok.id = 15;
   mock_get_tokenizer->retval = &tok;
@@ -254,7 +294,7 @@ void test_tokenizer_freed(void){
   int argc = 3;
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   tok_t tok;
   tok.id = 15;
   mock_get_tokenizer->retval = &tok;
@@ -269,7 +309,7 @@ void test_func_result_printed(void){
   int argc = 3;
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   tok_t tok;
   tok.id = 15;
   mock_get_tokenizer->retval = &tok;
@@ -282,6 +322,20 @@ void test_func_result_printed(void){
   TEST_ASSERT_EQUAL_STRING("Foo, Bar!\n",stdout_data.streambuff);
 }
 
+void test_input_file_closed(void){
+  char* argv[] = {"main", "1", "missing.txt"};
+  int argc = 3;
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  aoc_main(argc, argv, empty_func, NULL);
+  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_close->callcount);
+  TEST_ASSERT_EQUAL_INT(1,mock_free_tok->callcount);
+}
+
 char* part1_mock(tok_t* tok){
   (void)(tok);
   char* res = strdup("This is part 1.");
@@ -299,7 +353,7 @@ void test_part_1_requested_executes_part_1_func(void){
   int argc = 3;
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   tok_t tok;
   tok.id = 15;
   mock_get_tokenizer->retval = &tok;
@@ -314,7 +368,7 @@ void test_part_2_requested_executes_part_2_func(void){
   int argc = 3;
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   tok_t tok;
   tok.id = 15;
   mock_get_tokenizer->retval = &tok;
@@ -329,7 +383,7 @@ void test_func_returns_null_error_printed(void){
   int argc = 3;
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   tok_t tok;
   tok.id = 15;
   mock_get_tokenizer->retval = &tok;
@@ -349,7 +403,7 @@ void test_func_returns_null_no_error_msg_aborts(void){
   int argc = 3;
   char* content = malloc(64);
   strcpy(content, "Hello, World!\n");
-  mock_mm_file_read->retval = content;
+  mock_mm_file_open->retval = content;
   tok_t tok;
   tok.id = 15;
   mock_get_tokenizer->retval = &tok;
@@ -363,6 +417,424 @@ void test_func_returns_null_no_error_msg_aborts(void){
   TEST_ASSERT_EQUAL_STRING(exp,stderr_data.streambuff);
 }
 
+void test_streaming_part_gets_stream_tokenizer(void){
+  char* argv[] = {"main", "2", "input.txt"};
+  int argc = 3;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_stream_tokenizer->retval = &tok;
+  func_retval = strdup("Streamed.");
+  int res = aoc_main_streaming(argc, argv, NULL, empty_func, AOC_STREAM_PART2);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_INT(0,mock_mm_file_open->callcount);
+  TEST_ASSERT_EQUAL_INT(1,mock_get_stream_tokenizer->callcount);
+  TEST_ASSERT_EQUAL_STRING("input.txt",mock_get_stream_tokenizer->param_1);
+  TEST_ASSERT_EQUAL_PTR(&tok,func_param);
+  TEST_ASSERT_EQUAL_PTR(&tok,mock_free_tok->param_1);
+  TEST_ASSERT_EQUAL_STRING("Streamed.\n",stdout_data.streambuff);
+}
+
+void test_non_streaming_part_gets_mapped_input(void){
+  char* argv[] = {"main", "1", "input.txt"};
+  int argc = 3;
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  aoc_main_streaming(argc, argv, empty_func, NULL, AOC_STREAM_PART2);
+  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_open->callcount);
+  TEST_ASSERT_EQUAL_INT(0,mock_get_stream_tokenizer->callcount);
+  TEST_ASSERT_EQUAL_INT(1,func_callcount);
+}
+
+void test_stream_read_error_printed(void){
+  char* argv[] = {"main", "1", "input.txt"};
+  int argc = 3;
+  char exp[1024];
+  snprintf(exp, 1024, "Error reading input from input.txt: %s\n",
+           strerror(EIO));
+  tok_t tok;
+  tok.id = 15;
+  mock_get_stream_tokenizer->retval = &tok;
+  mock_tok_error->retval = EIO;
+  func_retval = strdup("Partial.");
+  int res = aoc_main_streaming(argc, argv, empty_func, NULL, AOC_STREAM_PART1);
+  fflush(stderr_ut);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_STRING(exp,stderr_data.streambuff);
+  TEST_ASSERT_EQUAL_STRING("",stdout_data.streambuff);
+}
+
+void test_both_parts_share_input(void){
+  char* argv[] = {"main", "both", "input.txt"};
+  int argc = 3;
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  int res = aoc_main(argc, argv, part1_mock, part2_mock);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING("This is part 1.\nThis is part 2.\n",
+                           stdout_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_open->callcount);
+  TEST_ASSERT_EQUAL_INT(1,mock_get_tokenizer->callcount);
+  TEST_ASSERT_EQUAL_INT(1,mock_reset_tok->callcount);
+  TEST_ASSERT_EQUAL_PTR(&tok,mock_reset_tok->param_1);
+  TEST_ASSERT_EQUAL_INT(1,mock_free_tok->callcount);
+}
+
+void test_both_parts_missing_part_prints_error(void){
+  char* argv[] = {"main", "both", "input.txt"};
+  int argc = 3;
+  const char* exp = "Part 2 requested but no part 2 function provided.\n";
+  int res = aoc_main(argc, argv, part1_mock, NULL);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_STRING(exp,stderr_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(0,mock_mm_file_open->callcount);
+}
+
+static int prepare_callcount = 0;
+static int free_prepared_callcount = 0;
+static int prepared_state = 42;
+
+void* prepare_mock(tok_t* tok, arena_t* arena){
+  (void)(tok);
+  prepare_callcount++;
+  int* state = arena_alloc(arena, sizeof(int));
+  *state = prepared_state;
+  return state;
+}
+
+char* prepared1_mock(void* state, arena_t* arena){
+  return arena_sprintf(arena, "Part 1 of %d.", *(int*)state);
+}
+
+char* prepared2_mock(void* state, arena_t* arena){
+  return arena_sprintf(arena, "Part 2 of %d.", *(int*)state);
+}
+
+void free_prepared_mock(void* state){
+  TEST_ASSERT_EQUAL_INT(prepared_state, *(int*)state);
+  free_prepared_callcount++;
+}
+
+void test_both_parts_use_prepared_state(void){
+  char* argv[] = {"main", "both", "input.txt"};
+  int argc = 3;
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  prepare_callcount = 0;
+  free_prepared_callcount = 0;
+  aoc_day_t day = {
+    .part1 = part1_mock,
+    .part2 = part2_mock,
+    .prepare = prepare_mock,
+    .prepared1 = prepared1_mock,
+    .prepared2 = prepared2_mock,
+    .free_prepared = free_prepared_mock,
+  };
+  int res = aoc_run(argc, argv, &day);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING("Part 1 of 42.\nPart 2 of 42.\n",
+                           stdout_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(1,prepare_callcount);
+  TEST_ASSERT_EQUAL_INT(1,free_prepared_callcount);
+  TEST_ASSERT_EQUAL_INT(0,mock_reset_tok->callcount);
+}
+
+void test_prepare_without_prepared_part_prints_error(void){
+  char* argv[] = {"main", "1", "input.txt"};
+  int argc = 3;
+  aoc_day_t day = {
+    .part1 = part1_mock,
+    .part2 = part2_mock,
+    .prepare = prepare_mock,
+    .prepared1 = prepared1_mock,
+  };
+  int res = aoc_run(argc, argv, &day);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_STRING("A prepare hook was provided but no prepared part 2 function.\n",
+                           stderr_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(0,mock_mm_file_open->callcount);
+}
+
+void test_single_part_uses_prepared_state(void){
+  char* argv[] = {"main", "2", "input.txt"};
+  int argc = 3;
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  prepare_callcount = 0;
+  aoc_day_t day = {
+    .part1 = part1_mock,
+    .part2 = part2_mock,
+    .prepare = prepare_mock,
+    .prepared1 = prepared1_mock,
+    .prepared2 = prepared2_mock,
+  };
+  int res = aoc_run(argc, argv, &day);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING("Part 2 of 42.\n",stdout_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(1,prepare_callcount);
+}
+
+char* raw1_mock(const char* input, size_t len){
+  return strndup(input, len - 1);
+}
+
+void test_raw_part_skips_tokenizer(void){
+  char* argv[] = {"main", "1", "input.txt"};
+  int argc = 3;
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  aoc_day_t day = {
+    .part1 = part1_mock,
+    .part2 = part2_mock,
+    .raw1 = raw1_mock,
+  };
+  int res = aoc_run(argc, argv, &day);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING("Hello, World!\n",stdout_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(0,mock_get_tokenizer->callcount);
+  TEST_ASSERT_EQUAL_INT(0,mock_free_tok->callcount);
+  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_close->callcount);
+}
+
+void test_raw_part_needs_all_parts_raw(void){
+  char* argv[] = {"main", "both", "input.txt"};
+  int argc = 3;
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  aoc_day_t day = {
+    .part1 = part1_mock,
+    .part2 = part2_mock,
+    .raw1 = raw1_mock,
+  };
+  int res = aoc_run(argc, argv, &day);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING("This is part 1.\nThis is part 2.\n",
+                           stdout_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(1,mock_get_tokenizer->callcount);
+}
+
+void test_bench_runs_part_repeatedly(void){
+  char* argv[] = {"main", "--bench", "3", "1", "input.txt"};
+  int argc = 5;
+  const char* exp = "{\"input\":\"input.txt\",\"part\":\"1\",\"runs\":3,"
+    "\"bytes\":14,\"lines\":1,";
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  mock_tok_count->retval = 1;
+  int res = aoc_main(argc, argv, part1_mock, part2_mock);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_open->callcount);
+  TEST_ASSERT_EQUAL_INT(2,mock_reset_tok->callcount);
+  TEST_ASSERT_EQUAL_INT(1,mock_free_tok->callcount);
+  TEST_ASSERT_EQUAL_INT(1,mock_mm_file_close->callcount);
+  TEST_ASSERT_EQUAL_STRING_LEN(exp,stdout_data.streambuff,strlen(exp));
+  TEST_ASSERT_NOT_NULL(strstr(stdout_data.streambuff, "\"median_ns\":"));
+  const char* allocs = strstr(stdout_data.streambuff, "\"allocs_per_run\":");
+  TEST_ASSERT_NOT_NULL(allocs);
+  // Only counted in builds with AOC_COUNT_ALLOCS
+  TEST_ASSERT_EQUAL_INT(!alloc_count_enabled(),
+                        strncmp(allocs + 17, "null", 4) == 0);
+  TEST_ASSERT_EQUAL_STRING("}\n",
+                           stdout_data.streambuff + stdout_data.streamsize - 2);
+}
+
+void test_bench_failing_part_prints_error(void){
+  char* argv[] = {"main", "--bench", "3", "1", "input.txt"};
+  int argc = 5;
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  int res = aoc_main(argc, argv, empty_func, NULL);
+  fflush(stdout_ut);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_INT(1,func_callcount);
+  TEST_ASSERT_EQUAL_STRING("Error in AoC function call.\n",stderr_data.streambuff);
+  TEST_ASSERT_EQUAL_STRING("",stdout_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(1,mock_free_tok->callcount);
+}
+
+void test_bench_invalid_runs_prints_error(void){
+  char* argv[] = {"main", "--bench", "0", "1", "input.txt"};
+  int argc = 5;
+  int res = aoc_main(argc, argv, part1_mock, NULL);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_STRING("\"0\" is an invalid number of benchmark runs.\n",
+                           stderr_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(0,mock_mm_file_open->callcount);
+}
+
+void test_unknown_option_prints_usage(void){
+  char* argv[] = {"main", "--foo", "1", "input.txt"};
+  int argc = 4;
+  int res = aoc_main(argc, argv, part1_mock, NULL);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_STRING("Invalid option \"--foo\".\n"
+                           "Usage: main [--bench N | --manifest FILE | --stats] [--perf] [--trace FILE] [--jobs N] 1|2|both INPUT_FILE...\n",
+                           stderr_data.streambuff);
+}
+
+void test_stats_printed_per_phase(void){
+  char* argv[] = {"main", "--stats", "both", "input.txt"};
+  int argc = 4;
+  const char* exp = "{\"input\":\"input.txt\",\"phases\":{\"load\":{\"ns\":";
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  int res = aoc_main(argc, argv, part1_mock, part2_mock);
+  fflush(stdout_ut);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING("This is part 1.\nThis is part 2.\n",
+                           stdout_data.streambuff);
+  TEST_ASSERT_EQUAL_STRING_LEN(exp,stderr_data.streambuff,strlen(exp));
+  const char* phases[] = {"\"tokenize\":", "\"solve\":", "\"output\":",
+                          "\"cleanup\":", "\"allocs\":", "\"total_ns\":"};
+  for(size_t i = 0; i < sizeof(phases)/sizeof(phases[0]); i++){
+    TEST_ASSERT_NOT_NULL(strstr(stderr_data.streambuff, phases[i]));
+  }
+  TEST_ASSERT_EQUAL_INT(!alloc_count_enabled(),
+                        strstr(stderr_data.streambuff, "\"allocs\":null") != NULL);
+  TEST_ASSERT_EQUAL_STRING("}\n",
+                           stderr_data.streambuff + stderr_data.streamsize - 2);
+}
+
+void test_stats_with_bench_prints_error(void){
+  char* argv[] = {"main", "--stats", "--bench", "3", "1", "input.txt"};
+  int argc = 6;
+  int res = aoc_main(argc, argv, part1_mock, NULL);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_STRING("--stats and --perf can't be combined with --bench or --manifest.\n",
+                           stderr_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(0,mock_mm_file_open->callcount);
+}
+
+void test_stats_with_several_inputs_prints_error(void){
+  char* argv[] = {"main", "--stats", "1", "a.txt", "b.txt"};
+  int argc = 5;
+  int res = aoc_main(argc, argv, part1_mock, NULL);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_STRING("--stats and --perf take a single input file.\n",
+                           stderr_data.streambuff);
+  TEST_ASSERT_EQUAL_INT(0,mock_mm_file_open->callcount);
+}
+
+void test_perf_printed_or_unavailable(void){
+  char* argv[] = {"main", "--perf", "1", "input.txt"};
+  int argc = 4;
+  const char* exp = "{\"input\":\"input.txt\",\"perf\":{\"cycles\":";
+  const char* unavailable = "Performance counters unavailable: ";
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  int res = aoc_main(argc, argv, part1_mock, NULL);
+  fflush(stdout_ut);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING("This is part 1.\n",stdout_data.streambuff);
+  // Depends on the machine, but the run must go through either way
+  if(strncmp(stderr_data.streambuff, unavailable, strlen(unavailable)) != 0){
+    TEST_ASSERT_EQUAL_STRING_LEN(exp,stderr_data.streambuff,strlen(exp));
+    TEST_ASSERT_NOT_NULL(strstr(stderr_data.streambuff, "\"page_faults\":"));
+  }
+  TEST_ASSERT_EQUAL_INT(1,mock_free_tok->callcount);
+}
+
+void test_trace_written_with_phases(void){
+  char tpath[] = "/tmp/main_ut_trace_XXXXXX";
+  int fd = mkstemp(tpath);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  char* argv[] = {"main", "--trace", tpath, "1", "input.txt"};
+  int argc = 5;
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  int res = aoc_main(argc, argv, part1_mock, NULL);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING("This is part 1.\n",stdout_data.streambuff);
+  char trace[4096];
+  ssize_t len = read(fd, trace, sizeof(trace) - 1);
+  close(fd);
+  unlink(tpath);
+  TEST_ASSERT_GREATER_THAN(0, len);
+  trace[len] = '\0';
+  const char* spans[] = {"\"load\"", "\"tokenize\"", "\"solve\"",
+                         "\"output\"", "\"cleanup\""};
+  for(size_t i = 0; i < sizeof(spans)/sizeof(spans[0]); i++){
+    TEST_ASSERT_NOT_NULL(strstr(trace, spans[i]));
+  }
+}
+
+void test_trace_unwritable_prints_error(void){
+  char* argv[] = {"main", "--trace", "/tmp/does/not/exist.json", "1", "input.txt"};
+  int argc = 5;
+  const char* exp = "Error writing the trace to /tmp/does/not/exist.json: "
+    "No such file or directory\n";
+  char* content = malloc(64);
+  strcpy(content, "Hello, World!\n");
+  mock_mm_file_open->retval = content;
+  tok_t tok;
+  tok.id = 15;
+  mock_get_tokenizer->retval = &tok;
+  int res = aoc_main(argc, argv, part1_mock, NULL);
+  fflush(stdout_ut);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_STRING("This is part 1.\n",stdout_data.streambuff);
+  TEST_ASSERT_EQUAL_STRING(exp,stderr_data.streambuff);
+}
+
 int main(void){
   UNITY_BEGIN();
   RUN_TEST(test_too_few_cli_args_prints_usage);
@@ -379,10 +851,31 @@ int main(void){
   RUN_TEST(test_tokenizer_failure_aborts);
   RUN_TEST(test_tokenizer_handed_to_func);
   RUN_TEST(test_tokenizer_freed);
+  RUN_TEST(test_input_file_closed);
   RUN_TEST(test_func_result_printed);
   RUN_TEST(test_part_1_requested_executes_part_1_func);
   RUN_TEST(test_part_2_requested_executes_part_2_func);
   RUN_TEST(test_func_returns_null_no_error_msg_aborts);
   RUN_TEST(test_func_returns_null_error_printed);
+  RUN_TEST(test_streaming_part_gets_stream_tokenizer);
+  RUN_TEST(test_non_streaming_part_gets_mapped_input);
+  RUN_TEST(test_stream_read_error_printed);
+  RUN_TEST(test_both_parts_share_input);
+  RUN_TEST(test_both_parts_missing_part_prints_error);
+  RUN_TEST(test_both_parts_use_prepared_state);
+  RUN_TEST(test_prepare_without_prepared_part_prints_error);
+  RUN_TEST(test_single_part_uses_prepared_state);
+  RUN_TEST(test_raw_part_skips_tokenizer);
+  RUN_TEST(test_raw_part_needs_all_parts_raw);
+  RUN_TEST(test_bench_runs_part_repeatedly);
+  RUN_TEST(test_bench_failing_part_prints_error);
+  RUN_TEST(test_bench_invalid_runs_prints_error);
+  RUN_TEST(test_unknown_option_prints_usage);
+  RUN_TEST(test_stats_printed_per_phase);
+  RUN_TEST(test_stats_with_bench_prints_error);
+  RUN_TEST(test_stats_with_several_inputs_prints_error);
+  RUN_TEST(test_perf_printed_or_unavailable);
+  RUN_TEST(test_trace_written_with_phases);
+  RUN_TEST(test_trace_unwritable_prints_error);
   return UNITY_END();
 }
@@ -14,6 +14,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <unistd.h>
+
 static char* testdir = NULL;
 
 FILE* stdout_ut = NULL;
@@ -94,6 +96,103 @@ void test_output_erroneous_func(void){
   free(fpath);
 }
 
+void test_batch_prints_result_per_file(void){
+  char* fpath = get_file_path(testdir, "four_lines.txt");
+  char* fpath2 = get_file_path(testdir, "five_lines.txt");
+  int argc = 5;
+  char* argv[] = {"main", "1", fpath, fpath2, fpath};
+  char exp[4096];
+  snprintf(exp, 4096, "%s\tHello, World!\n%s\tThird line\n%s\tHello, World!\n",
+           fpath, fpath2, fpath);
+  int res = aoc_main(argc, argv, third_line_func, NULL);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING(exp,stdout_data.streambuff);
+  free(fpath);
+  free(fpath2);
+}
+
+void test_batch_continues_after_failing_file(void){
+  char* fpath = get_file_path(testdir, "four_lines.txt");
+  char* missing = get_file_path(testdir, "missing.txt");
+  int argc = 4;
+  char* argv[] = {"main", "1", missing, fpath};
+  char exp[4096];
+  snprintf(exp, 4096, "%s\tHello, World!\n", fpath);
+  char exp_err[4096];
+  snprintf(exp_err, 4096, "Error loading input from %s: %s\n", missing,
+           strerror(ENOENT));
+  int res = aoc_main(argc, argv, third_line_func, NULL);
+  fflush(stdout_ut);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_STRING(exp,stdout_data.streambuff);
+  TEST_ASSERT_EQUAL_STRING(exp_err,stderr_data.streambuff);
+  free(fpath);
+  free(missing);
+}
+
+void test_parallel_batch_keeps_input_order(void){
+  char* fpath = get_file_path(testdir, "four_lines.txt");
+  char* fpath2 = get_file_path(testdir, "five_lines.txt");
+  char* argv[64] = {"main", "--jobs", "4", "1"};
+  int argc = 4;
+  char exp[8192] = "";
+  for(int i = 0; i < 40; i++){
+    char* curr = i % 3 == 0 ? fpath2 : fpath;
+    argv[argc++] = curr;
+    snprintf(exp + strlen(exp), sizeof(exp) - strlen(exp), "%s\t%s\n", curr,
+             i % 3 == 0 ? "Third line" : "Hello, World!");
+  }
+  int res = aoc_main(argc, argv, third_line_func, NULL);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING(exp,stdout_data.streambuff);
+  free(fpath);
+  free(fpath2);
+}
+
+void test_parallel_batch_reports_errors_per_input(void){
+  char* fpath = get_file_path(testdir, "four_lines.txt");
+  char* fpath2 = get_file_path(testdir, "five_lines.txt");
+  int argc = 6;
+  char* argv[] = {"main", "--jobs", "2", "1", fpath, fpath2};
+  char exp[4096];
+  snprintf(exp, 4096, "Error in AoC function call on %s:\nFoo!\n%s\n"
+           "Error in AoC function call on %s:\nFoo!\n%s\n",
+           fpath, strerror(EINVAL), fpath2, strerror(EINVAL));
+  int res = aoc_main(argc, argv, erroneous_func, NULL);
+  fflush(stdout_ut);
+  fflush(stderr_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,res);
+  TEST_ASSERT_EQUAL_STRING("",stdout_data.streambuff);
+  TEST_ASSERT_EQUAL_STRING(exp,stderr_data.streambuff);
+  free(fpath);
+  free(fpath2);
+}
+
+void test_batch_reads_manifest(void){
+  char* fpath = get_file_path(testdir, "four_lines.txt");
+  char* fpath2 = get_file_path(testdir, "five_lines.txt");
+  char mpath[] = "/tmp/main_integration_ut_XXXXXX";
+  int fd = mkstemp(mpath);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  FILE* manifest = fdopen(fd, "w");
+  fprintf(manifest, "%s\n\n%s\n", fpath2, fpath);
+  fclose(manifest);
+  int argc = 4;
+  char* argv[] = {"main", "--manifest", mpath, "1"};
+  char exp[4096];
+  snprintf(exp, 4096, "%s\tThird line\n%s\tHello, World!\n", fpath2, fpath);
+  int res = aoc_main(argc, argv, third_line_func, NULL);
+  fflush(stdout_ut);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,res);
+  TEST_ASSERT_EQUAL_STRING(exp,stdout_data.streambuff);
+  unlink(mpath);
+  free(fpath);
+  free(fpath2);
+}
+
 int main(int argc, char** argv){
   if( argc != 2 ){
     fprintf( stderr, "usage: %s TESTFILE_DIR", argv[0] );
@@ -103,5 +202,10 @@ int main(int argc, char** argv){
   UNITY_BEGIN();
   RUN_TEST(test_output_third_input_line);
   RUN_TEST(test_output_erroneous_func);
+  RUN_TEST(test_batch_prints_result_per_file);
+  RUN_TEST(test_batch_continues_after_failing_file);
+  RUN_TEST(test_batch_reads_manifest);
+  RUN_TEST(test_parallel_batch_keeps_input_order);
+  RUN_TEST(test_parallel_batch_reports_errors_per_input);
   return UNITY_END();
 }
@@ -11,6 +11,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <unistd.h>
+
 static char* testdir = NULL;
 
 char* get_file_path(const char* dir, const char* filename){
@@ -102,6 +104,80 @@ void test_path_empty(void){
   TEST_ASSERT_NULL(res);
 }
 
+void test_open_missing_file(void){
+  char* fpath = get_file_path(testdir, "missing.txt");
+  errno = 0;
+  mm_file_t* res = mm_file_open( fpath );
+  int res_err = errno;
+  free(fpath);
+  TEST_ASSERT_NULL(res);
+  TEST_ASSERT_EQUAL_INT(ENOENT,res_err);
+}
+
+void test_open_empty_file(void){
+  char* fpath = get_file_path(testdir, "empty.txt");
+  errno = 0;
+  mm_file_t* res = mm_file_open( fpath );
+  int res_err = errno;
+  free(fpath);
+  TEST_ASSERT_NULL(res);
+  TEST_ASSERT_EQUAL_INT(EINVAL,res_err);
+}
+
+void test_open_single_char_file(void){
+  char* fpath = get_file_path(testdir, "single_char.txt");
+  errno = 0;
+  mm_file_t* res = mm_file_open( fpath );
+  int res_err = errno;
+  free(fpath);
+  TEST_ASSERT_EQUAL_INT(0,res_err);
+  TEST_ASSERT_NOT_NULL(res);
+  TEST_ASSERT_EQUAL_UINT(2,mm_file_len(res));
+  TEST_ASSERT_EQUAL('\0',mm_file_data(res)[2]);
+  TEST_ASSERT_EQUAL_STRING("y\n",mm_file_data(res));
+  mm_file_close(res);
+}
+
+void test_open_multi_line_file(void){
+  char* fpath = get_file_path(testdir, "multi_line.txt");
+  errno = 0;
+  mm_file_t* res = mm_file_open( fpath );
+  int res_err = errno;
+  free(fpath);
+  TEST_ASSERT_EQUAL_INT(0,res_err);
+  TEST_ASSERT_NOT_NULL(res);
+  TEST_ASSERT_EQUAL_UINT(22,mm_file_len(res));
+  TEST_ASSERT_EQUAL_STRING("Foo\nBar\nHello, World!\n",mm_file_data(res));
+  mm_file_close(res);
+}
+
+void test_open_page_sized_file_is_terminated(void){
+  char fpath[] = "/tmp/mm_files_ut_XXXXXX";
+  int fd = mkstemp(fpath);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  size_t len = sysconf(_SC_PAGESIZE);
+  char* content = malloc(len);
+  memset(content, 'a', len);
+  TEST_ASSERT_EQUAL_INT(len, write(fd, content, len));
+  close(fd);
+  mm_file_t* res = mm_file_open(fpath);
+  unlink(fpath);
+  TEST_ASSERT_NOT_NULL(res);
+  TEST_ASSERT_EQUAL_UINT(len,mm_file_len(res));
+  TEST_ASSERT_EQUAL('\0',mm_file_data(res)[len]);
+  TEST_ASSERT_EQUAL_INT(0,memcmp(content, mm_file_data(res), len));
+  mm_file_close(res);
+  free(content);
+}
+
+void test_open_path_null(void){
+  errno = 0;
+  mm_file_t* res = mm_file_open( NULL );
+  int res_err = errno;
+  TEST_ASSERT_EQUAL_INT(EFAULT,res_err);
+  TEST_ASSERT_NULL(res);
+}
+
 int main( int argc, char** argv ){
   if( argc != 2 ){
     fprintf( stderr, "usage: %s TESTFILE_DIR", argv[0] );
@@ -116,5 +192,11 @@ int main( int argc, char** argv ){
   RUN_TEST(test_content_multi_line_file);
   RUN_TEST(test_path_null);
   RUN_TEST(test_path_empty);
+  RUN_TEST(test_open_missing_file);
+  RUN_TEST(test_open_empty_file);
+  RUN_TEST(test_open_single_char_file);
+  RUN_TEST(test_open_multi_line_file);
+  RUN_TEST(test_open_page_sized_file_is_terminated);
+  RUN_TEST(test_open_path_null);
   return UNITY_END();
 }
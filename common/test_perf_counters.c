@@ -0,0 +1,131 @@
+/**
+ * @file test_perf_counters.c
+ * @brief UTs for the hardware performance counters
+ *
+ * Which counters are available depends on the machine running the
+ * tests, so most checks only apply to the counters which opened.
+ */
+
+#include "perf_counters.h"
+
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+static perf_counters_t pc;
+static int opened;
+
+void setUp(void){
+  opened = perf_open(&pc);
+}
+
+void tearDown(void){
+  perf_close(&pc);
+}
+
+static volatile unsigned long sink;
+
+static void busy_work(void){
+  for(unsigned long i = 0; i < 1000000; i++){
+    sink += i;
+  }
+}
+
+void test_open_reports_available_events(void){
+  int available = 0;
+  for(int e = 0; e < PERF_N_EVENTS; e++){
+    available += perf_available(&pc, e);
+  }
+  TEST_ASSERT_EQUAL_INT(opened, available);
+  if(opened == 0){
+    TEST_ASSERT_NOT_EQUAL(0, pc.error);
+  }
+  else{
+    TEST_ASSERT_EQUAL_INT(0, pc.error);
+  }
+}
+
+void test_unavailable_events_cant_be_read(void){
+  for(int e = 0; e < PERF_N_EVENTS; e++){
+    uint64_t value;
+    if(!perf_available(&pc, e)){
+      TEST_ASSERT_EQUAL_INT(-1, perf_read(&pc, e, &value));
+    }
+  }
+}
+
+void test_disabled_counters_stay_at_zero(void){
+  busy_work();
+  for(int e = 0; e < PERF_N_EVENTS; e++){
+    uint64_t value = 1;
+    if(perf_available(&pc, e)){
+      TEST_ASSERT_EQUAL_INT(0, perf_read(&pc, e, &value));
+      TEST_ASSERT_EQUAL_UINT64(0, value);
+    }
+  }
+}
+
+void test_instructions_counted_while_started(void){
+  if(!perf_available(&pc, PERF_INSTRUCTIONS)){
+    return;
+  }
+  uint64_t first, second;
+  perf_start(&pc);
+  busy_work();
+  perf_stop(&pc);
+  TEST_ASSERT_EQUAL_INT(0, perf_read(&pc, PERF_INSTRUCTIONS, &first));
+  TEST_ASSERT_GREATER_OR_EQUAL(1000000, first);
+  // Stopped counters don't move, restarted ones add to the count
+  busy_work();
+  TEST_ASSERT_EQUAL_INT(0, perf_read(&pc, PERF_INSTRUCTIONS, &second));
+  TEST_ASSERT_EQUAL_UINT64(first, second);
+  perf_start(&pc);
+  busy_work();
+  perf_stop(&pc);
+  TEST_ASSERT_EQUAL_INT(0, perf_read(&pc, PERF_INSTRUCTIONS, &second));
+  TEST_ASSERT_GREATER_THAN(first, second);
+}
+
+void test_page_faults_counted(void){
+  if(!perf_available(&pc, PERF_PAGE_FAULTS)){
+    return;
+  }
+  uint64_t faults;
+  size_t len = 64 << 20;
+  perf_start(&pc);
+  char* mem = malloc(len);
+  TEST_ASSERT_NOT_NULL(mem);
+  memset(mem, 1, len);
+  perf_stop(&pc);
+  free(mem);
+  TEST_ASSERT_EQUAL_INT(0, perf_read(&pc, PERF_PAGE_FAULTS, &faults));
+  TEST_ASSERT_GREATER_THAN(0, faults);
+}
+
+void test_event_names(void){
+  TEST_ASSERT_EQUAL_STRING("cycles", perf_event_name(PERF_CYCLES));
+  TEST_ASSERT_EQUAL_STRING("instructions", perf_event_name(PERF_INSTRUCTIONS));
+  TEST_ASSERT_EQUAL_STRING("cache_misses", perf_event_name(PERF_CACHE_MISSES));
+  TEST_ASSERT_EQUAL_STRING("branch_misses", perf_event_name(PERF_BRANCH_MISSES));
+  TEST_ASSERT_EQUAL_STRING("page_faults", perf_event_name(PERF_PAGE_FAULTS));
+}
+
+void test_close_marks_events_unavailable(void){
+  perf_close(&pc);
+  for(int e = 0; e < PERF_N_EVENTS; e++){
+    TEST_ASSERT_FALSE(perf_available(&pc, e));
+  }
+}
+
+int main(void){
+  UNITY_BEGIN();
+  RUN_TEST(test_open_reports_available_events);
+  RUN_TEST(test_unavailable_events_cant_be_read);
+  RUN_TEST(test_disabled_counters_stay_at_zero);
+  RUN_TEST(test_instructions_counted_while_started);
+  RUN_TEST(test_page_faults_counted);
+  RUN_TEST(test_event_names);
+  RUN_TEST(test_close_marks_events_unavailable);
+  return UNITY_END();
+}
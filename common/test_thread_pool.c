@@ -0,0 +1,124 @@
+/**
+ * @file test_thread_pool.c
+ * @brief UTs for the work stealing thread pool
+ */
+
+#include "thread_pool.h"
+
+#include <unity.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define N_TASKS 1000
+
+struct counts {
+  int runs[N_TASKS];
+  unsigned workers[N_TASKS];
+};
+
+static void count_task(void* ctx, size_t task, unsigned worker){
+  struct counts* c = ctx;
+  __atomic_fetch_add(&c->runs[task], 1, __ATOMIC_RELAXED);
+  c->workers[task] = worker;
+}
+
+void test_create_returns_non_null(void){
+  tpool_t* pool = tpool_create(4);
+  TEST_ASSERT_NOT_NULL(pool);
+  TEST_ASSERT_EQUAL_UINT(4, tpool_workers(pool));
+  tpool_destroy(pool);
+}
+
+void test_zero_workers_is_one_worker(void){
+  tpool_t* pool = tpool_create(0);
+  TEST_ASSERT_EQUAL_UINT(1, tpool_workers(pool));
+  tpool_destroy(pool);
+}
+
+void test_every_task_runs_once(void){
+  struct counts* c = calloc(1, sizeof(struct counts));
+  tpool_t* pool = tpool_create(8);
+  tpool_run(pool, N_TASKS, count_task, c);
+  for(size_t i = 0; i < N_TASKS; i++){
+    TEST_ASSERT_EQUAL_INT(1, c->runs[i]);
+    TEST_ASSERT_TRUE(c->workers[i] < 8);
+  }
+  tpool_destroy(pool);
+  free(c);
+}
+
+void test_pool_runs_several_batches(void){
+  struct counts* c = calloc(1, sizeof(struct counts));
+  tpool_t* pool = tpool_create(3);
+  tpool_run(pool, N_TASKS, count_task, c);
+  tpool_run(pool, 10, count_task, c);
+  tpool_run(pool, 0, count_task, c);
+  for(size_t i = 0; i < N_TASKS; i++){
+    TEST_ASSERT_EQUAL_INT(i < 10 ? 2 : 1, c->runs[i]);
+  }
+  tpool_destroy(pool);
+  free(c);
+}
+
+void test_single_worker_runs_in_order(void){
+  struct counts* c = calloc(1, sizeof(struct counts));
+  tpool_t* pool = tpool_create(1);
+  tpool_run(pool, N_TASKS, count_task, c);
+  for(size_t i = 0; i < N_TASKS; i++){
+    TEST_ASSERT_EQUAL_INT(1, c->runs[i]);
+    TEST_ASSERT_EQUAL_UINT(0, c->workers[i]);
+  }
+  tpool_destroy(pool);
+  free(c);
+}
+
+struct blocking {
+  bool done[8];
+  bool timed_out;
+};
+
+/**
+ * Task 0 blocks until tasks 1 to 3 are done. All of these start out on
+ * the same worker, so they only get done if another worker steals them.
+ */
+static void blocking_task(void* ctx, size_t task, unsigned worker){
+  (void)(worker);
+  struct blocking* b = ctx;
+  if(task == 0){
+    time_t deadline = time(NULL) + 5;
+    while(!(__atomic_load_n(&b->done[1], __ATOMIC_ACQUIRE)
+            && __atomic_load_n(&b->done[2], __ATOMIC_ACQUIRE)
+            && __atomic_load_n(&b->done[3], __ATOMIC_ACQUIRE))){
+      if(time(NULL) > deadline){
+        b->timed_out = true;
+        break;
+      }
+    }
+  }
+  __atomic_store_n(&b->done[task], true, __ATOMIC_RELEASE);
+}
+
+void test_idle_worker_steals_tasks(void){
+  struct blocking b = {0};
+  tpool_t* pool = tpool_create(2);
+  tpool_run(pool, 8, blocking_task, &b);
+  TEST_ASSERT_FALSE(b.timed_out);
+  for(size_t i = 0; i < 8; i++){
+    TEST_ASSERT_TRUE(b.done[i]);
+  }
+  tpool_destroy(pool);
+}
+
+int main(void){
+  UNITY_BEGIN();
+  RUN_TEST(test_create_returns_non_null);
+  RUN_TEST(test_zero_workers_is_one_worker);
+  RUN_TEST(test_every_task_runs_once);
+  RUN_TEST(test_pool_runs_several_batches);
+  RUN_TEST(test_single_worker_runs_in_order);
+  RUN_TEST(test_idle_worker_steals_tasks);
+  return UNITY_END();
+}
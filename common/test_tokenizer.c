@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <unistd.h>
+
 void test_create_empty_str_returns_null(void){
   tok_t* res = get_tokenizer("", "\n");
   TEST_ASSERT_NULL(res);
@@ -197,6 +199,240 @@ void test_tok_reset_resets_tok_count(void){
   free(tok);
 }
 
+void test_tokens_stay_valid_after_reset(void){
+  char in[] = "Hello,\nWorld.";
+  tok_t* tok = get_tokenizer(in, "\n");
+  char* first = n_tok(tok);
+  reset_tok(tok);
+  TEST_ASSERT_EQUAL_PTR(first, n_tok(tok));
+  TEST_ASSERT_EQUAL_STRING("Hello,", first);
+  free_tok(tok);
+}
+
+void test_input_unchanged(void){
+  char in[] = "Hello,\nWorld.\n";
+  tok_t* tok = get_tokenizer(in, "\n");
+  while(n_tok(tok) != NULL){}
+  TEST_ASSERT_EQUAL_STRING("Hello,\nWorld.\n", in);
+  free_tok(tok);
+}
+
+void test_tokenizer_n_stops_at_len(void){
+  char in[] = "foo\nbar\nbaz";
+  tok_t* tok = get_tokenizer_n(in, 6, "\n");
+  TEST_ASSERT_EQUAL_INT(2, tok_count(tok));
+  TEST_ASSERT_EQUAL_STRING("foo", n_tok(tok));
+  TEST_ASSERT_EQUAL_STRING("ba", n_tok(tok));
+  TEST_ASSERT_NULL(n_tok(tok));
+  free_tok(tok);
+}
+
+void test_multiple_delims(void){
+  char in[] = "a, b,c\n";
+  tok_t* tok = get_tokenizer(in, ", \n");
+  TEST_ASSERT_EQUAL_INT(3, tok_count(tok));
+  TEST_ASSERT_EQUAL_STRING("a", n_tok(tok));
+  TEST_ASSERT_EQUAL_STRING("b", n_tok(tok));
+  TEST_ASSERT_EQUAL_STRING("c", n_tok(tok));
+  free_tok(tok);
+}
+
+void test_tokens_across_block_boundaries(void){
+  // Token lengths chosen so token and delimiter runs cross the
+  // 64 byte scanning blocks at different offsets
+  char in[512] = "";
+  char exp[64][16];
+  int n = 0;
+  size_t len = 0;
+  while(len < 400){
+    int toklen = 1 + n % 13;
+    for(int i = 0; i < toklen; i++){
+      exp[n][i] = 'a' + (n + i) % 26;
+    }
+    exp[n][toklen] = '\0';
+    strcat(in, exp[n]);
+    strcat(in, n % 3 == 0 ? "\n\n" : "\n");
+    len = strlen(in);
+    n++;
+  }
+  for(size_t cut = len - 70; cut <= len; cut++){
+    // Also cover inputs ending exactly on a block within a token
+    tok_t* tok = get_tokenizer_n(in, cut, "\n");
+    int count = tok_count(tok);
+    for(int i = 0; i < count; i++){
+      char* res = n_tok(tok);
+      if(i < count - 1){
+        TEST_ASSERT_EQUAL_STRING(exp[i], res);
+      }
+      else{
+        TEST_ASSERT_EQUAL_INT(0, strncmp(exp[i], res, strlen(res)));
+      }
+    }
+    TEST_ASSERT_NULL(n_tok(tok));
+    free_tok(tok);
+  }
+  tok_t* tok = get_tokenizer(in, "\n");
+  TEST_ASSERT_EQUAL_INT(n, tok_count(tok));
+  free_tok(tok);
+}
+
+void test_tok_at_returns_tokens_by_index(void){
+  char in[] = "\nHello,\n\nWorld.\nfoo";
+  tok_t* tok = get_tokenizer(in, "\n");
+  TEST_ASSERT_EQUAL_STRING("Hello,", tok_at(tok, 0));
+  TEST_ASSERT_EQUAL_STRING("World.", tok_at(tok, 1));
+  TEST_ASSERT_EQUAL_STRING("foo", tok_at(tok, 2));
+  TEST_ASSERT_NULL(tok_at(tok, 3));
+  TEST_ASSERT_NULL(tok_at(tok, -1));
+  free_tok(tok);
+}
+
+void test_tok_at_independent_of_n_tok(void){
+  char in[] = "Hello,\nWorld.";
+  tok_t* tok = get_tokenizer(in, "\n");
+  char* first = n_tok(tok);
+  TEST_ASSERT_EQUAL_PTR(first, tok_at(tok, 0));
+  TEST_ASSERT_EQUAL_INT(1, tok_count(tok));
+  TEST_ASSERT_EQUAL_STRING("World.", n_tok(tok));
+  free_tok(tok);
+}
+
+void test_tok_view_points_into_input(void){
+  char in[] = "\nHello,\n\nWorld.\nfoo";
+  tok_t* tok = get_tokenizer(in, "\n");
+  TEST_ASSERT_EQUAL_PTR(in + 1, tok_view(tok, 0));
+  TEST_ASSERT_EQUAL_PTR(in + 9, tok_view(tok, 1));
+  TEST_ASSERT_EQUAL_PTR(in + 16, tok_view(tok, 2));
+  TEST_ASSERT_NULL(tok_view(tok, 3));
+  TEST_ASSERT_NULL(tok_view(tok, -1));
+  // The input is left as is, copies are only made for tok_at
+  TEST_ASSERT_EQUAL_STRING("World.", tok_at(tok, 1));
+  TEST_ASSERT_EQUAL_MEMORY("\nHello,\n\nWorld.\nfoo", in, sizeof(in));
+  TEST_ASSERT_NOT_EQUAL(in + 9, tok_at(tok, 1));
+  TEST_ASSERT_EQUAL_INT(0, tok_error(tok));
+  free_tok(tok);
+}
+
+void test_tok_len_returns_token_lengths(void){
+  char in[] = "a\nbcd\n\nefghij\n";
+  tok_t* tok = get_tokenizer(in, "\n");
+  TEST_ASSERT_EQUAL_UINT(1, tok_len(tok, 0));
+  TEST_ASSERT_EQUAL_UINT(3, tok_len(tok, 1));
+  TEST_ASSERT_EQUAL_UINT(6, tok_len(tok, 2));
+  TEST_ASSERT_EQUAL_UINT(0, tok_len(tok, 3));
+  free_tok(tok);
+}
+
+void test_parallel_matches_sequential(void){
+  char in[4096];
+  size_t len = 0;
+  srand(7);
+  while(len < sizeof(in) - 32){
+    int toklen = rand() % 20;
+    for(int i = 0; i < toklen; i++){
+      in[len++] = 'a' + rand() % 26;
+    }
+    in[len++] = '\n';
+  }
+  in[len] = '\0';
+  tok_t* seq = get_tokenizer_n(in, len, "\n");
+  for(unsigned shards = 1; shards < 40; shards += 3){
+    tok_t* par = get_tokenizer_parallel(in, len, "\n", shards);
+    TEST_ASSERT_NOT_NULL(par);
+    TEST_ASSERT_EQUAL_INT(shards, tok_shards(par));
+    TEST_ASSERT_EQUAL_INT(tok_count(seq), tok_count(par));
+    for(int i = 0; i < tok_count(seq); i++){
+      TEST_ASSERT_EQUAL_STRING(tok_at(seq, i), tok_at(par, i));
+      TEST_ASSERT_EQUAL_UINT(tok_len(seq, i), tok_len(par, i));
+    }
+    free_tok(par);
+  }
+  free_tok(seq);
+}
+
+void test_shard_ranges_cover_all_tokens(void){
+  char in[] = "aaaa\nbbbb\ncccc\ndddd\neeee\nffff\ngggg\nhhhh";
+  tok_t* tok = get_tokenizer_parallel(in, strlen(in), "\n", 3);
+  TEST_ASSERT_EQUAL_INT(3, tok_shards(tok));
+  int expected_first = 0;
+  for(int shard = 0; shard < tok_shards(tok); shard++){
+    TEST_ASSERT_EQUAL_INT(expected_first, tok_shard_first(tok, shard));
+    expected_first += tok_shard_count(tok, shard);
+  }
+  TEST_ASSERT_EQUAL_INT(8, expected_first);
+  TEST_ASSERT_EQUAL_INT(-1, tok_shard_first(tok, 3));
+  TEST_ASSERT_EQUAL_INT(0, tok_shard_count(tok, 3));
+  free_tok(tok);
+}
+
+void test_more_shards_than_tokens(void){
+  char in[] = "foo\nbar";
+  tok_t* tok = get_tokenizer_parallel(in, strlen(in), "\n", 16);
+  TEST_ASSERT_EQUAL_INT(2, tok_count(tok));
+  TEST_ASSERT_EQUAL_STRING("foo", n_tok(tok));
+  TEST_ASSERT_EQUAL_STRING("bar", n_tok(tok));
+  TEST_ASSERT_NULL(n_tok(tok));
+  free_tok(tok);
+}
+
+void test_sequential_tokenizer_has_single_shard(void){
+  char in[] = "foo\nbar";
+  tok_t* tok = get_tokenizer(in, "\n");
+  TEST_ASSERT_EQUAL_INT(1, tok_shards(tok));
+  TEST_ASSERT_EQUAL_INT(0, tok_shard_first(tok, 0));
+  TEST_ASSERT_EQUAL_INT(2, tok_shard_count(tok, 0));
+  free_tok(tok);
+}
+
+void test_stream_tokenizer_reads_file(void){
+  char fpath[] = "/tmp/tokenizer_ut_XXXXXX";
+  int fd = mkstemp(fpath);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  TEST_ASSERT_EQUAL_INT(14, write(fd, "\nHello,\nWorld.", 14));
+  close(fd);
+  tok_t* tok = get_stream_tokenizer(fpath, "\n");
+  TEST_ASSERT_NOT_NULL(tok);
+  TEST_ASSERT_EQUAL_INT(-1, tok_count(tok));
+  TEST_ASSERT_NULL(tok_at(tok, 0));
+  TEST_ASSERT_EQUAL_STRING("Hello,", n_tok(tok));
+  reset_tok(tok);
+  TEST_ASSERT_EQUAL_STRING("Hello,", n_tok(tok));
+  TEST_ASSERT_EQUAL_STRING("World.", n_tok(tok));
+  TEST_ASSERT_NULL(n_tok(tok));
+  TEST_ASSERT_EQUAL_INT(0, tok_error(tok));
+  free_tok(tok);
+  unlink(fpath);
+}
+
+void test_reload_replaces_input(void){
+  char in[] = "foo\nbar";
+  char next[] = "a\nlonger\ninput\n";
+  tok_t* tok = get_tokenizer(in, "\n");
+  TEST_ASSERT_EQUAL_STRING("foo", n_tok(tok));
+  TEST_ASSERT_EQUAL_INT(0, reload_tok(tok, next, strlen(next), "\n", 1));
+  TEST_ASSERT_EQUAL_INT(3, tok_count(tok));
+  TEST_ASSERT_EQUAL_STRING("a", n_tok(tok));
+  TEST_ASSERT_EQUAL_STRING("longer", n_tok(tok));
+  TEST_ASSERT_EQUAL_STRING("input", n_tok(tok));
+  TEST_ASSERT_NULL(n_tok(tok));
+  TEST_ASSERT_EQUAL_INT(0, reload_tok(tok, in, 3, "\n", 2));
+  TEST_ASSERT_EQUAL_INT(1, tok_count(tok));
+  TEST_ASSERT_EQUAL_INT(2, tok_shards(tok));
+  TEST_ASSERT_EQUAL_STRING("foo", tok_at(tok, 0));
+  free_tok(tok);
+}
+
+void test_reload_invalid_input_leaves_empty_tokenizer(void){
+  char in[] = "foo\nbar";
+  tok_t* tok = get_tokenizer(in, "\n");
+  TEST_ASSERT_EQUAL_INT(-1, reload_tok(tok, in, 0, "\n", 1));
+  TEST_ASSERT_EQUAL_INT(0, tok_count(tok));
+  TEST_ASSERT_NULL(n_tok(tok));
+  TEST_ASSERT_EQUAL_INT(0, reload_tok(tok, in, strlen(in), "\n", 1));
+  TEST_ASSERT_EQUAL_INT(2, tok_count(tok));
+  free_tok(tok);
+}
+
 int main(void){
   UNITY_BEGIN();
   RUN_TEST(test_create_empty_str_returns_null);
@@ -216,5 +452,21 @@ int main(void){
   RUN_TEST(test_count_leading_and_trailing_delims_not_counted);
   RUN_TEST(test_count_running_count_correct);
   RUN_TEST(test_tok_reset_resets_tok_count);
+  RUN_TEST(test_tokens_stay_valid_after_reset);
+  RUN_TEST(test_input_unchanged);
+  RUN_TEST(test_tokenizer_n_stops_at_len);
+  RUN_TEST(test_multiple_delims);
+  RUN_TEST(test_tokens_across_block_boundaries);
+  RUN_TEST(test_tok_at_returns_tokens_by_index);
+  RUN_TEST(test_tok_at_independent_of_n_tok);
+  RUN_TEST(test_tok_view_points_into_input);
+  RUN_TEST(test_tok_len_returns_token_lengths);
+  RUN_TEST(test_parallel_matches_sequential);
+  RUN_TEST(test_shard_ranges_cover_all_tokens);
+  RUN_TEST(test_more_shards_than_tokens);
+  RUN_TEST(test_reload_replaces_input);
+  RUN_TEST(test_reload_invalid_input_leaves_empty_tokenizer);
+  RUN_TEST(test_sequential_tokenizer_has_single_shard);
+  RUN_TEST(test_stream_tokenizer_reads_file);
   return UNITY_END();
 }
@@ -0,0 +1,188 @@
+/**
+ * @file test_trace.c
+ * @brief UTs for the trace spans
+ */
+
+#include "trace.h"
+
+#include <unity.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+
+static char fpath[] = "/tmp/trace_ut_XXXXXX";
+static char* dumped = NULL;
+
+void setUp(void){
+  trace_clear();
+  trace_enable(true);
+}
+
+void tearDown(void){
+  trace_enable(false);
+  trace_clear();
+  free(dumped);
+  dumped = NULL;
+}
+
+/**
+ * Dumps the trace to a temporary file and returns its content
+ */
+static const char* dump(void){
+  strcpy(fpath, "/tmp/trace_ut_XXXXXX");
+  int fd = mkstemp(fpath);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  close(fd);
+  TEST_ASSERT_EQUAL_INT(0, trace_dump(fpath));
+  FILE* f = fopen(fpath, "r");
+  TEST_ASSERT_NOT_NULL(f);
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  rewind(f);
+  dumped = malloc(len + 1);
+  TEST_ASSERT_EQUAL_INT(len, fread(dumped, 1, len, f));
+  dumped[len] = '\0';
+  fclose(f);
+  unlink(fpath);
+  return dumped;
+}
+
+static size_t count_str(const char* s, const char* needle){
+  size_t count = 0;
+  while((s = strstr(s, needle)) != NULL){
+    count++;
+    s++;
+  }
+  return count;
+}
+
+void test_disabled_records_nothing(void){
+  trace_enable(false);
+  TRACE_BEGIN("outer");
+  TRACE_END();
+  TEST_ASSERT_EQUAL_size_t(0, trace_count());
+}
+
+void test_span_recorded_on_end(void){
+  TRACE_BEGIN("outer");
+  TEST_ASSERT_EQUAL_size_t(0, trace_count());
+  TRACE_END();
+  TEST_ASSERT_EQUAL_size_t(1, trace_count());
+}
+
+void test_unbalanced_end_ignored(void){
+  TRACE_END();
+  TEST_ASSERT_EQUAL_size_t(0, trace_count());
+}
+
+static int scoped(bool early){
+  TRACE_SCOPE("scoped");
+  if(early){
+    return 1;
+  }
+  TRACE_BEGIN("inner");
+  TRACE_END();
+  return 0;
+}
+
+void test_scope_closed_on_every_return(void){
+  scoped(true);
+  TEST_ASSERT_EQUAL_size_t(1, trace_count());
+  scoped(false);
+  TEST_ASSERT_EQUAL_size_t(3, trace_count());
+}
+
+void test_dump_is_chrome_trace(void){
+  TRACE_BEGIN("outer");
+  TRACE_BEGIN("inner \"quoted\"");
+  TRACE_END();
+  TRACE_END();
+  const char* json = dump();
+  TEST_ASSERT_EQUAL_STRING_LEN("{\"traceEvents\":[", json, 16);
+  TEST_ASSERT_NOT_NULL(strstr(json, "{\"name\":\"outer\",\"ph\":\"X\","));
+  TEST_ASSERT_NOT_NULL(strstr(json, "{\"name\":\"inner \\\"quoted\\\"\",\"ph\":\"X\","));
+  TEST_ASSERT_NOT_NULL(strstr(json, "\"dropped_spans\":0}}\n"));
+  TEST_ASSERT_EQUAL_size_t(2, count_str(json, "\"dur\":"));
+}
+
+void test_full_ring_drops_oldest(void){
+  for(int i = 0; i < TRACE_RING_SIZE + 10; i++){
+    TRACE_BEGIN(i < 10 ? "old" : "new");
+    TRACE_END();
+  }
+  const char* json = dump();
+  TEST_ASSERT_NULL(strstr(json, "\"old\""));
+  TEST_ASSERT_EQUAL_size_t(TRACE_RING_SIZE, count_str(json, "\"new\""));
+  TEST_ASSERT_NOT_NULL(strstr(json, "\"dropped_spans\":10}}\n"));
+}
+
+void test_too_deep_spans_skipped(void){
+  for(int i = 0; i < TRACE_MAX_DEPTH + 2; i++){
+    TRACE_BEGIN("nested");
+  }
+  for(int i = 0; i < TRACE_MAX_DEPTH + 2; i++){
+    TRACE_END();
+  }
+  TEST_ASSERT_EQUAL_size_t(TRACE_MAX_DEPTH, trace_count());
+}
+
+static void* thread_spans(void* arg){
+  (void)(arg);
+  TRACE_BEGIN("thread");
+  TRACE_END();
+  return NULL;
+}
+
+void test_threads_have_own_rings(void){
+  pthread_t threads[3];
+  for(int i = 0; i < 3; i++){
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, thread_spans, NULL));
+  }
+  for(int i = 0; i < 3; i++){
+    pthread_join(threads[i], NULL);
+  }
+  thread_spans(NULL);
+  const char* json = dump();
+  TEST_ASSERT_EQUAL_size_t(4, count_str(json, "\"thread\""));
+  for(int tid = 1; tid <= 4; tid++){
+    char needle[16];
+    snprintf(needle, sizeof(needle), "\"tid\":%d,", tid);
+    TEST_ASSERT_EQUAL_size_t(1, count_str(json, needle));
+  }
+}
+
+void test_clear_drops_spans(void){
+  TRACE_BEGIN("outer");
+  TRACE_END();
+  trace_clear();
+  TEST_ASSERT_EQUAL_size_t(0, trace_count());
+  TRACE_BEGIN("outer");
+  TRACE_END();
+  TEST_ASSERT_EQUAL_size_t(1, trace_count());
+}
+
+void test_dump_to_missing_dir_fails(void){
+  errno = 0;
+  TEST_ASSERT_EQUAL_INT(-1, trace_dump("/tmp/does/not/exist.json"));
+  TEST_ASSERT_EQUAL_INT(ENOENT, errno);
+}
+
+int main(void){
+  UNITY_BEGIN();
+  RUN_TEST(test_disabled_records_nothing);
+  RUN_TEST(test_span_recorded_on_end);
+  RUN_TEST(test_unbalanced_end_ignored);
+  RUN_TEST(test_scope_closed_on_every_return);
+  RUN_TEST(test_dump_is_chrome_trace);
+  RUN_TEST(test_full_ring_drops_oldest);
+  RUN_TEST(test_too_deep_spans_skipped);
+  RUN_TEST(test_threads_have_own_rings);
+  RUN_TEST(test_clear_drops_spans);
+  RUN_TEST(test_dump_to_missing_dir_fails);
+  return UNITY_END();
+}
@@ -0,0 +1,222 @@
+/**
+ * @file thread_pool.c
+ * @brief Implementation of the work stealing thread pool
+ */
+
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * The task deque of a worker. Since all tasks of a batch are known up
+ * front and identified by their index, a deque is just the range
+ * [front, back) of task indices. The owner takes tasks from the front,
+ * thieves take them from the back.
+ */
+struct deque {
+  pthread_mutex_t lock;
+  size_t front;
+  size_t back;
+};
+
+struct tpool {
+  unsigned n_workers;
+  pthread_t* threads;
+  struct deque* deques;
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned long batch;
+  unsigned running;
+  bool shutdown;
+  tpool_task_t task;
+  void* ctx;
+};
+
+/**
+ * Argument of a worker thread
+ */
+struct worker {
+  tpool_t* pool;
+  unsigned id;
+};
+
+static bool take(struct deque* dq, size_t* task){
+  pthread_mutex_lock(&dq->lock);
+  bool found = dq->front < dq->back;
+  if(found){
+    *task = dq->front++;
+  }
+  pthread_mutex_unlock(&dq->lock);
+  return found;
+}
+
+/**
+ * Steals half of the remaining tasks of the first other worker which
+ * has any. The first stolen task is returned in @e task, the others
+ * are moved to the deque of @e self.
+ */
+static bool steal(tpool_t* pool, unsigned self, size_t* task){
+  for(unsigned i = 1; i < pool->n_workers; i++){
+    struct deque* victim = &pool->deques[(self + i) % pool->n_workers];
+    pthread_mutex_lock(&victim->lock);
+    size_t left = victim->back - victim->front;
+    size_t first = 0;
+    size_t end = 0;
+    if(left > 0){
+      end = victim->back;
+      first = end - (left + 1) / 2;
+      victim->back = first;
+    }
+    pthread_mutex_unlock(&victim->lock);
+    if(left > 0){
+      struct deque* own = &pool->deques[self];
+      pthread_mutex_lock(&own->lock);
+      own->front = first + 1;
+      own->back = end;
+      pthread_mutex_unlock(&own->lock);
+      *task = first;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Runs tasks of the current batch until no worker has any left
+ */
+static void work(tpool_t* pool, unsigned self){
+  size_t task;
+  while(take(&pool->deques[self], &task) || steal(pool, self, &task)){
+    pool->task(pool->ctx, task, self);
+  }
+}
+
+static void* worker_thread(void* arg){
+  struct worker* w = arg;
+  tpool_t* pool = w->pool;
+  unsigned self = w->id;
+  free(w);
+  unsigned long batch = 0;
+  pthread_mutex_lock(&pool->lock);
+  while(true){
+    while(!pool->shutdown && pool->batch == batch){
+      pthread_cond_wait(&pool->start, &pool->lock);
+    }
+    if(pool->shutdown){
+      break;
+    }
+    batch = pool->batch;
+    pthread_mutex_unlock(&pool->lock);
+    work(pool, self);
+    pthread_mutex_lock(&pool->lock);
+    if(--pool->running == 0){
+      pthread_cond_signal(&pool->done);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+tpool_t* tpool_create(unsigned n_workers){
+  if(n_workers == 0){
+    n_workers = 1;
+  }
+  tpool_t* pool = malloc(sizeof(tpool_t));
+  if(pool == NULL){
+    return NULL;
+  }
+  pool->threads = malloc(n_workers*sizeof(pthread_t));
+  pool->deques = malloc(n_workers*sizeof(struct deque));
+  if(pool->threads == NULL || pool->deques == NULL){
+    free(pool->threads);
+    free(pool->deques);
+    free(pool);
+    return NULL;
+  }
+  for(unsigned i = 0; i < n_workers; i++){
+    pool->deques[i].front = 0;
+    pool->deques[i].back = 0;
+  }
+  pthread_mutex_init(&pool->deques[0].lock, NULL);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  pool->batch = 0;
+  pool->running = 0;
+  pool->shutdown = false;
+  pool->task = NULL;
+  pool->ctx = NULL;
+  // Worker 0 is the thread calling tpool_run
+  pool->n_workers = 1;
+  for(unsigned i = 1; i < n_workers; i++){
+    struct worker* w = malloc(sizeof(struct worker));
+    if(w == NULL){
+      break;
+    }
+    w->pool = pool;
+    w->id = i;
+    pthread_mutex_init(&pool->deques[i].lock, NULL);
+    if(pthread_create(&pool->threads[i], NULL, worker_thread, w) != 0){
+      pthread_mutex_destroy(&pool->deques[i].lock);
+      free(w);
+      break;
+    }
+    pool->n_workers++;
+  }
+  return pool;
+}
+
+unsigned tpool_workers(const tpool_t* pool){
+  return pool->n_workers;
+}
+
+void tpool_run(tpool_t* pool, size_t n_tasks, tpool_task_t task, void* ctx){
+  unsigned n = pool->n_workers;
+  for(unsigned i = 0; i < n; i++){
+    pthread_mutex_lock(&pool->deques[i].lock);
+    pool->deques[i].front = n_tasks / n * i + (i < n_tasks % n ? i : n_tasks % n);
+    pool->deques[i].back = pool->deques[i].front + n_tasks / n
+      + (i < n_tasks % n ? 1 : 0);
+    pthread_mutex_unlock(&pool->deques[i].lock);
+  }
+  pthread_mutex_lock(&pool->lock);
+  pool->task = task;
+  pool->ctx = ctx;
+  pool->running = n - 1;
+  pool->batch++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  work(pool, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while(pool->running > 0){
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void tpool_destroy(tpool_t* pool){
+  if(pool == NULL){
+    return;
+  }
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = true;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+  for(unsigned i = 1; i < pool->n_workers; i++){
+    pthread_join(pool->threads[i], NULL);
+  }
+  for(unsigned i = 0; i < pool->n_workers; i++){
+    pthread_mutex_destroy(&pool->deques[i].lock);
+  }
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+  free(pool->threads);
+  free(pool->deques);
+  free(pool);
+}
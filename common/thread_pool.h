@@ -0,0 +1,61 @@
+/**
+ * @file thread_pool.h
+ * @brief Work stealing thread pool for running many independent tasks
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+struct tpool;
+typedef struct tpool tpool_t;
+
+/**
+ * @brief Function running a single task of a batch
+ *
+ * @param ctx The context handed to tpool_run
+ * @param task Index of the task in the batch
+ * @param worker Index of the worker running the task, less than the
+ *        number of workers of the pool. A worker never runs two tasks at
+ *        the same time, so it can index per-worker state.
+ */
+typedef void (*tpool_task_t)(void* ctx, size_t task, unsigned worker);
+
+/**
+ * @brief Starts a thread pool with @e n_workers workers
+ *
+ * The calling thread counts as worker 0 and takes part in tpool_run, so
+ * only @e n_workers - 1 threads are started. If some of them can't be
+ * started, the pool gets by with fewer workers.
+ *
+ * @param n_workers Number of workers, 0 is treated as 1
+ * @returns The pool or NULL on error
+ */
+tpool_t* tpool_create(unsigned n_workers);
+
+/**
+ * @brief Returns the number of workers of @e pool
+ */
+unsigned tpool_workers(const tpool_t* pool);
+
+/**
+ * @brief Runs @e n_tasks tasks on the workers of @e pool
+ *
+ * Each worker starts with a contiguous block of the task indices, which
+ * it works through front to back. A worker running out of tasks steals
+ * half of the remaining block of another worker, from its back end.
+ * Returns once every task has been run exactly once.
+ *
+ * @param pool The pool to run the tasks on
+ * @param n_tasks Number of tasks, which are indexed 0 to @e n_tasks - 1
+ * @param task Function running a single task
+ * @param ctx Passed on to @e task
+ */
+void tpool_run(tpool_t* pool, size_t n_tasks, tpool_task_t task, void* ctx);
+
+/**
+ * @brief Stops the workers of @e pool and frees it
+ *
+ * @param pool The pool to destroy, may be NULL
+ */
+void tpool_destroy(tpool_t* pool);
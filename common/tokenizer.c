@@ -5,86 +5,482 @@
 
 #include "tokenizer.h"
 
+#include "aoc_err.h"
+#include "delim_scan.h"
+#include "line_stream.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * Position of a single token in the input, which is the same in the
+ * tokenizer's buffer.
+ */
+struct tokrec {
+  size_t off;
+  size_t len;
+};
+
 struct tokintern {
-  char* s_input;
-  char* s_working;
-  char* s_save;
-  char* s_delim;
-  char* s_orig;
+  const char* src;
+  size_t src_len;
+  // Null terminated copies of the tokens, only made once n_tok or tok_at
+  // asks for them
+  char* s_buf;
+  size_t buf_cap;
+  bool copied;
+  // ENOMEM if the copies failed
+  int error;
+  struct tokrec* recs;
+  size_t recs_cap;
+  lstream_t* stream;
   int orig_count;
-  int num;
+  int next;
+  int n_shards;
+  int shards_cap;
+  int* shard_first;
+};
+
+/**
+ * A byte range of the input which is indexed on its own, possibly on a
+ * separate thread. Ranges always start and end on a delimiter (or the
+ * input's start/end), so no token crosses two of them.
+ */
+struct shard {
+  const char* s;
+  const delim_set_t* set;
+  size_t begin;
+  size_t end;
+  struct tokrec* recs;
+  size_t count;
+  size_t cap;
+  int error;
 };
 
-tok_t* get_tokenizer(char* s, char* delim){
+/**
+ * Appends the token [start, end) of the input to the index of @e sh.
+ */
+static int add_token(struct shard* sh, size_t start, size_t end){
+  if(sh->count == sh->cap){
+    size_t new_cap = sh->cap * 2;
+    struct tokrec* grown = realloc(sh->recs, new_cap*sizeof(struct tokrec));
+    if(grown == NULL){
+      return -1;
+    }
+    sh->recs = grown;
+    sh->cap = new_cap;
+  }
+  sh->recs[sh->count].off = start;
+  sh->recs[sh->count].len = end - start;
+  sh->count++;
+  return 0;
+}
+
+/**
+ * Indexes all tokens of @e sh in a single pass over its range. Just like
+ * strtok, runs of delimiters are skipped, so there are no empty tokens.
+ * The input is only read, the tokens stay where they are.
+ */
+static int index_shard(struct shard* sh){
+  sh->count = 0;
+  if(sh->recs == NULL){
+    sh->cap = (sh->end - sh->begin)/16 + 16;
+    sh->recs = malloc(sh->cap*sizeof(struct tokrec));
+    if(sh->recs == NULL){
+      return -1;
+    }
+  }
+  // The input is scanned in blocks of 64 bytes. Bit i of a block's mask
+  // is set for delimiters, so tokens start where a clear bit follows a
+  // set one and end where a set bit follows a clear one. The byte before
+  // the range counts as a delimiter.
+  uint64_t prev_delim = 1;
+  size_t tok_start = 0;
+  for(size_t block = sh->begin; block < sh->end; block += 64){
+    uint64_t mask;
+    if(sh->end - block >= 64){
+      mask = ds_mask64(sh->set, sh->s + block);
+    }
+    else{
+      // Pad the last block with delimiters, which closes a trailing token
+      char tail[64] = {0};
+      memcpy(tail, sh->s + block, sh->end - block);
+      mask = ds_mask64(sh->set, tail) | (~0ull << (sh->end - block));
+    }
+    uint64_t after_delim = (mask << 1) | prev_delim;
+    uint64_t starts = ~mask & after_delim;
+    uint64_t ends = mask & ~after_delim;
+    prev_delim = mask >> 63;
+    for(uint64_t events = starts | ends; events != 0; events &= events - 1){
+      unsigned i = __builtin_ctzll(events);
+      if(starts & (1ull << i)){
+        tok_start = block + i;
+      }
+      else if(add_token(sh, tok_start, block + i) != 0){
+        return -1;
+      }
+    }
+  }
+  if(!prev_delim){
+    // Range length is a multiple of 64 and ends within a token
+    return add_token(sh, tok_start, sh->end);
+  }
+  return 0;
+}
+
+static void* index_shard_thread(void* arg){
+  struct shard* sh = arg;
+  sh->error = index_shard(sh);
+  return NULL;
+}
+
+tok_t* get_tokenizer(const char* s, char* delim){
+  if(s == NULL){
+    return NULL;
+  }
+  return get_tokenizer_n(s, strlen(s), delim);
+}
+
+tok_t* get_tokenizer_n(const char* s, size_t len, char* delim){
+  return get_tokenizer_parallel(s, len, delim, 1);
+}
+
+/**
+ * Makes sure the shard table of @e tok can hold @e n_shards shards.
+ * Buffers are only ever grown, so a tokenizer which is reloaded with
+ * inputs of similar size stops allocating after the first one.
+ */
+static int reserve_shards(tok_t* tok, unsigned n_shards){
+  if(tok->shards_cap < (int) n_shards + 1){
+    int* grown = realloc(tok->shard_first, (n_shards+1)*sizeof(int));
+    if(grown == NULL){
+      return -1;
+    }
+    tok->shard_first = grown;
+    tok->shards_cap = n_shards + 1;
+  }
+  return 0;
+}
+
+/**
+ * Indexes the @e len bytes at @e s into @e tokenizer, reusing its
+ * buffers. Leaves the tokenizer empty on error.
+ */
+static int index_input(tok_t* tokenizer, const char* s, size_t len,
+                       const delim_set_t* set, unsigned n_shards){
+  tokenizer->orig_count = 0;
+  tokenizer->next = 0;
+  tokenizer->n_shards = 0;
+  tokenizer->src = s;
+  tokenizer->src_len = len;
+  tokenizer->copied = false;
+  tokenizer->error = 0;
+  if(reserve_shards(tokenizer, n_shards) != 0){
+    return -1;
+  }
+  struct shard* shards = calloc(n_shards, sizeof(struct shard));
+  pthread_t* threads = malloc(n_shards*sizeof(pthread_t));
+  bool* started = calloc(n_shards, sizeof(bool));
+  if(shards == NULL || threads == NULL || started == NULL){
+    free(shards);
+    free(threads);
+    free(started);
+    return -1;
+  }
+
+  // Cut the input into equally sized ranges and move each cut forward
+  // to the next delimiter, so no token is split.
+  size_t cut = 0;
+  for(unsigned i = 0; i < n_shards; i++){
+    shards[i].s = s;
+    shards[i].set = set;
+    shards[i].begin = cut;
+    cut = i == n_shards - 1 ? len : (len / n_shards) * (i + 1);
+    if(cut < shards[i].begin){
+      cut = shards[i].begin;
+    }
+    while(cut < len && !set->is_delim[(unsigned char) s[cut]]){
+      cut++;
+    }
+    shards[i].end = cut;
+  }
+  if(n_shards == 1 && tokenizer->recs != NULL){
+    // Index straight into the tokenizer's own records
+    shards[0].recs = tokenizer->recs;
+    shards[0].cap = tokenizer->recs_cap;
+    tokenizer->recs = NULL;
+    tokenizer->recs_cap = 0;
+  }
+  // The first shard is indexed on the calling thread. If a thread can't
+  // be started, its shard is indexed here as well.
+  for(unsigned i = 1; i < n_shards; i++){
+    started[i] = pthread_create(&threads[i], NULL, index_shard_thread,
+                                &shards[i]) == 0;
+  }
+  shards[0].error = index_shard(&shards[0]);
+  for(unsigned i = 1; i < n_shards; i++){
+    if(started[i]){
+      pthread_join(threads[i], NULL);
+    }
+    else{
+      shards[i].error = index_shard(&shards[i]);
+    }
+  }
+
+  bool error = false;
+  size_t total = 0;
+  for(unsigned i = 0; i < n_shards; i++){
+    error = error || shards[i].error != 0;
+    total += shards[i].count;
+  }
+  if(!error && total > INT_MAX){
+    // Tokens are counted and indexed with ints
+    AOC_ERR(AOC_ERR_RANGE, 0, "The input has %zu tokens, more than %d.",
+            total, INT_MAX);
+    error = true;
+  }
+  if(n_shards == 1 && shards[0].recs != NULL){
+    // Nothing to merge, adopt the only index
+    tokenizer->recs = shards[0].recs;
+    tokenizer->recs_cap = shards[0].cap;
+    shards[0].recs = NULL;
+  }
+  else if(!error && tokenizer->recs_cap < total){
+    free(tokenizer->recs);
+    tokenizer->recs = malloc(total*sizeof(struct tokrec));
+    tokenizer->recs_cap = tokenizer->recs == NULL ? 0 : total;
+    error = tokenizer->recs == NULL;
+  }
+  if(!error){
+    for(unsigned i = 0; i < n_shards; i++){
+      tokenizer->shard_first[i] = tokenizer->orig_count;
+      if(shards[i].recs != NULL){
+        memcpy(tokenizer->recs + tokenizer->orig_count, shards[i].recs,
+               shards[i].count*sizeof(struct tokrec));
+      }
+      tokenizer->orig_count += shards[i].count;
+    }
+    tokenizer->shard_first[n_shards] = tokenizer->orig_count;
+    tokenizer->n_shards = n_shards;
+  }
+  for(unsigned i = 0; i < n_shards; i++){
+    free(shards[i].recs);
+  }
+  free(shards);
+  free(threads);
+  free(started);
+  if(error){
+    tokenizer->orig_count = 0;
+    return -1;
+  }
+  return 0;
+}
+
+tok_t* get_tokenizer_parallel(const char* s, size_t len, char* delim,
+                              unsigned n_shards){
   if(s == NULL || delim == NULL){
     return NULL;
   }
-  if(!strncmp(s,"",sizeof(char))){
+  if(len == 0){
     return NULL;
   }
   if(!strncmp(delim,"",sizeof(char))){
     return NULL;
   }
+  delim_set_t set;
+  if(ds_init(&set, delim) != 0){
+    return NULL;
+  }
+  if(n_shards == 0){
+    n_shards = 1;
+  }
 
   tok_t* tokenizer = malloc(sizeof(tok_t));
   if(tokenizer == NULL){
     return NULL;
   }
-  tokenizer->s_orig = s;
-  tokenizer->s_working = strdup(s);
-  tokenizer->s_input = tokenizer->s_working;
-  tokenizer->s_delim = delim;
-  tokenizer->orig_count = 0;
-  tokenizer->num = 0;
+  tokenizer->s_buf = NULL;
+  tokenizer->buf_cap = 0;
+  tokenizer->copied = false;
+  tokenizer->error = 0;
+  tokenizer->recs = NULL;
+  tokenizer->recs_cap = 0;
+  tokenizer->stream = NULL;
+  tokenizer->shard_first = NULL;
+  tokenizer->shards_cap = 0;
+  if(index_input(tokenizer, s, len, &set, n_shards) != 0){
+    free_tok(tokenizer);
+    return NULL;
+  }
+  return tokenizer;
+}
 
-  // Just compute the number of tokens by running through the
-  // string. Seems horribly inefficient, but so does just counting
-  // the occurences of the delimeter by hand. That would also
-  // be a lot more complicated, programming wise, because we'd have
-  // to follow all of strtok's rules, like skipping initial occurences.
-  int count = 0;
-  while(n_tok(tokenizer) != NULL){
-    ++count;
+int reload_tok(tok_t* tok, const char* s, size_t len, char* delim,
+               unsigned n_shards){
+  if(tok == NULL || tok->stream != NULL){
+    return -1;
+  }
+  tok->orig_count = 0;
+  tok->next = 0;
+  tok->n_shards = 0;
+  if(s == NULL || delim == NULL || len == 0){
+    return -1;
+  }
+  delim_set_t set;
+  if(ds_init(&set, delim) != 0){
+    return -1;
+  }
+  if(n_shards == 0){
+    n_shards = 1;
   }
-  tokenizer->orig_count = count;
-  tokenizer->num = count;
-  reset_tok(tokenizer);
+  return index_input(tok, s, len, &set, n_shards);
+}
 
+tok_t* get_stream_tokenizer(const char* fpath, char* delim){
+  if(fpath == NULL || delim == NULL){
+    return NULL;
+  }
+  tok_t* tokenizer = malloc(sizeof(tok_t));
+  if(tokenizer == NULL){
+    return NULL;
+  }
+  tokenizer->stream = ls_open(fpath, delim, 0);
+  if(tokenizer->stream == NULL){
+    free(tokenizer);
+    return NULL;
+  }
+  tokenizer->src = NULL;
+  tokenizer->src_len = 0;
+  tokenizer->s_buf = NULL;
+  tokenizer->buf_cap = 0;
+  tokenizer->copied = false;
+  tokenizer->error = 0;
+  tokenizer->recs = NULL;
+  tokenizer->recs_cap = 0;
+  tokenizer->n_shards = 0;
+  tokenizer->shards_cap = 0;
+  tokenizer->shard_first = NULL;
+  // The number of tokens is unknown without reading the entire input
+  tokenizer->orig_count = -1;
+  tokenizer->next = 0;
   return tokenizer;
 }
 
+/**
+ * Copies the tokens of @e tok to the same offsets in its buffer and
+ * terminates them there, once per input. Returns -1 and sets the
+ * tokenizer's error if the buffer can't be allocated.
+ */
+static int copy_tokens(tok_t* tok){
+  if(tok->copied){
+    return 0;
+  }
+  if(tok->buf_cap < tok->src_len + 1){
+    char* grown = realloc(tok->s_buf, tok->src_len + 1);
+    if(grown == NULL){
+      tok->error = ENOMEM;
+      return -1;
+    }
+    tok->s_buf = grown;
+    tok->buf_cap = tok->src_len + 1;
+  }
+  for(int i = 0; i < tok->orig_count; i++){
+    struct tokrec rec = tok->recs[i];
+    memcpy(tok->s_buf + rec.off, tok->src + rec.off, rec.len);
+    tok->s_buf[rec.off + rec.len] = '\0';
+  }
+  tok->copied = true;
+  return 0;
+}
+
 char* n_tok(tok_t* tok){
   if(tok == NULL){
     return NULL;
   }
-  char* ret = strtok_r(tok->s_input, tok->s_delim, &tok->s_save);
-  if(tok->s_input != NULL){
-    // First call with this string - all subsequent calls need
-    // to set the first strtok_r argument to the NULL pointer.
-    tok->s_input = NULL;
+  if(tok->stream != NULL){
+    return ls_next(tok->stream, NULL);
   }
-  if(ret != NULL){
-    tok->num--;
+  if(tok->next == tok->orig_count || copy_tokens(tok) != 0){
+    return NULL;
   }
-  return ret;
+  return tok->s_buf + tok->recs[tok->next++].off;
 }
 
 void free_tok(tok_t* tok){
-  free(tok->s_working);
+  ls_close(tok->stream);
+  free(tok->shard_first);
+  free(tok->recs);
+  free(tok->s_buf);
   free(tok);
 }
 
 void reset_tok(tok_t* tok){
-  free(tok->s_working);
-  tok->s_working = strdup(tok->s_orig);
-  tok->s_input = tok->s_working;
-  tok->num = tok->orig_count;
+  if(tok->stream != NULL){
+    ls_reset(tok->stream);
+    return;
+  }
+  tok->next = 0;
 }
 
 int tok_count(tok_t* tok){
-  return tok->num;
+  if(tok->stream != NULL){
+    return -1;
+  }
+  return tok->orig_count - tok->next;
+}
+
+int tok_error(tok_t* tok){
+  if(tok->stream != NULL){
+    return ls_error(tok->stream);
+  }
+  return tok->error;
+}
+
+char* tok_at(tok_t* tok, int i){
+  if(tok == NULL || tok->stream != NULL || i < 0 || i >= tok->orig_count
+     || copy_tokens(tok) != 0){
+    return NULL;
+  }
+  return tok->s_buf + tok->recs[i].off;
+}
+
+const char* tok_view(tok_t* tok, int i){
+  if(tok == NULL || tok->stream != NULL || i < 0 || i >= tok->orig_count){
+    return NULL;
+  }
+  return tok->src + tok->recs[i].off;
+}
+
+size_t tok_len(tok_t* tok, int i){
+  if(tok == NULL || tok->stream != NULL || i < 0 || i >= tok->orig_count){
+    return 0;
+  }
+  return tok->recs[i].len;
+}
+
+int tok_shards(tok_t* tok){
+  if(tok == NULL){
+    return 0;
+  }
+  return tok->n_shards;
+}
+
+int tok_shard_first(tok_t* tok, int shard){
+  if(tok == NULL || shard < 0 || shard >= tok->n_shards){
+    return -1;
+  }
+  return tok->shard_first[shard];
+}
+
+int tok_shard_count(tok_t* tok, int shard){
+  if(tok == NULL || shard < 0 || shard >= tok->n_shards){
+    return 0;
+  }
+  return tok->shard_first[shard+1] - tok->shard_first[shard];
 }
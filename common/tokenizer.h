@@ -3,12 +3,39 @@
  * @brief A string tokenizer utility.
  */
 
+#include <stddef.h>
+
 struct tokintern;
 
 typedef struct tokintern tok_t;
 
-tok_t* get_tokenizer(char* s, char* delim);
+/*
+ * The tokenizers index the input in place, so it must stay valid until
+ * the tokenizer is freed or reloaded.
+ */
+tok_t* get_tokenizer(const char* s, char* delim);
+tok_t* get_tokenizer_n(const char* s, size_t len, char* delim);
+tok_t* get_tokenizer_parallel(const char* s, size_t len, char* delim,
+                              unsigned n_shards);
+tok_t* get_stream_tokenizer(const char* fpath, char* delim);
+int reload_tok(tok_t* tok, const char* s, size_t len, char* delim,
+               unsigned n_shards);
 char* n_tok(tok_t* tok);
 void free_tok(tok_t* tok);
 void reset_tok(tok_t* tok);
 int tok_count(tok_t* tok);
+int tok_error(tok_t* tok);
+char* tok_at(tok_t* tok, int i);
+/*
+ * Token @e i in place in the input. Unlike n_tok and tok_at, which copy
+ * the whole input to a null terminated buffer on first use, this
+ * allocates nothing. The token is tok_len bytes long and followed by a
+ * delimiter or the end of the input. Callers which need null terminated
+ * tokens, like day 04 handing its lines to regexec, still pay for the
+ * copy.
+ */
+const char* tok_view(tok_t* tok, int i);
+size_t tok_len(tok_t* tok, int i);
+int tok_shards(tok_t* tok);
+int tok_shard_first(tok_t* tok, int shard);
+int tok_shard_count(tok_t* tok, int shard);
@@ -0,0 +1,217 @@
+/**
+ * @file trace.c
+ * @brief Implementation of the trace spans
+ */
+
+#include "trace.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+bool trace_enabled = false;
+
+struct span{
+  const char* name;
+  uint64_t start_ns;
+  uint64_t dur_ns;
+};
+
+/**
+ * The spans of one thread. Open spans only keep their start, they go
+ * into the ring once they're closed.
+ */
+struct ring{
+  struct ring* next;
+  unsigned tid;
+  unsigned depth;
+  uint64_t open_ns[TRACE_MAX_DEPTH];
+  const char* open_names[TRACE_MAX_DEPTH];
+  size_t written;
+  struct span spans[TRACE_RING_SIZE];
+};
+
+// All rings since the last clear, the dump needs those of finished
+// threads too. A clear starts a new generation, which invalidates the
+// ring pointers the threads still hold.
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct ring* rings = NULL;
+static unsigned n_rings = 0;
+static unsigned generation = 0;
+
+static _Thread_local struct ring* thread_ring = NULL;
+static _Thread_local unsigned thread_generation = 0;
+
+/**
+ * Returns the ring of the calling thread, or NULL if it has none in
+ * the current generation.
+ */
+static struct ring* current_ring(void){
+  if(thread_generation != __atomic_load_n(&generation, __ATOMIC_ACQUIRE)){
+    return NULL;
+  }
+  return thread_ring;
+}
+
+static uint64_t now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * Returns the ring of the calling thread, creating it on first use.
+ * Returns NULL if it can't be allocated, the spans are dropped then.
+ */
+static struct ring* get_ring(void){
+  struct ring* current = current_ring();
+  if(current != NULL){
+    return current;
+  }
+  struct ring* ring = malloc(sizeof(struct ring));
+  if(ring == NULL){
+    return NULL;
+  }
+  ring->depth = 0;
+  ring->written = 0;
+  pthread_mutex_lock(&rings_lock);
+  ring->tid = ++n_rings;
+  ring->next = rings;
+  rings = ring;
+  thread_generation = generation;
+  pthread_mutex_unlock(&rings_lock);
+  thread_ring = ring;
+  return ring;
+}
+
+void trace_enable(bool enable){
+  trace_enabled = enable;
+}
+
+void trace_begin(const char* name){
+  struct ring* ring = get_ring();
+  if(ring == NULL){
+    return;
+  }
+  if(ring->depth < TRACE_MAX_DEPTH){
+    ring->open_names[ring->depth] = name;
+    ring->open_ns[ring->depth] = now_ns();
+  }
+  ring->depth++;
+}
+
+void trace_end(void){
+  uint64_t end = now_ns();
+  struct ring* ring = current_ring();
+  if(ring == NULL || ring->depth == 0){
+    return;
+  }
+  ring->depth--;
+  if(ring->depth >= TRACE_MAX_DEPTH){
+    return;
+  }
+  struct span* span = &ring->spans[ring->written % TRACE_RING_SIZE];
+  span->name = ring->open_names[ring->depth];
+  span->start_ns = ring->open_ns[ring->depth];
+  span->dur_ns = end - span->start_ns;
+  ring->written++;
+}
+
+/**
+ * Prints @e s as a JSON string to @e out
+ */
+static void print_json_string(FILE* out, const char* s){
+  fputc('"', out);
+  for(; *s != '\0'; s++){
+    if(*s == '"' || *s == '\\'){
+      fprintf(out, "\\%c", *s);
+    }
+    else if((unsigned char) *s < 0x20){
+      fprintf(out, "\\u%04x", (unsigned char) *s);
+    }
+    else{
+      fputc(*s, out);
+    }
+  }
+  fputc('"', out);
+}
+
+/**
+ * Prints @e ns as microseconds, the unit of trace_event timestamps
+ */
+static void print_us(FILE* out, uint64_t ns){
+  fprintf(out, "%llu.%03u", (unsigned long long) (ns / 1000),
+          (unsigned) (ns % 1000));
+}
+
+int trace_dump(const char* fpath){
+  FILE* out = fopen(fpath, "w");
+  if(out == NULL){
+    return -1;
+  }
+  long pid = getpid();
+  size_t dropped = 0;
+  bool first = true;
+  fprintf(out, "{\"traceEvents\":[");
+  pthread_mutex_lock(&rings_lock);
+  for(struct ring* ring = rings; ring != NULL; ring = ring->next){
+    size_t start = 0;
+    if(ring->written > TRACE_RING_SIZE){
+      start = ring->written - TRACE_RING_SIZE;
+      dropped += start;
+    }
+    for(size_t i = start; i < ring->written; i++){
+      const struct span* span = &ring->spans[i % TRACE_RING_SIZE];
+      fprintf(out, "%s\n{\"name\":", first ? "" : ",");
+      print_json_string(out, span->name);
+      fprintf(out, ",\"ph\":\"X\",\"pid\":%ld,\"tid\":%u,\"ts\":",
+              pid, ring->tid);
+      print_us(out, span->start_ns);
+      fprintf(out, ",\"dur\":");
+      print_us(out, span->dur_ns);
+      fputc('}', out);
+      first = false;
+    }
+  }
+  pthread_mutex_unlock(&rings_lock);
+  fprintf(out, "\n],\"displayTimeUnit\":\"ns\","
+          "\"otherData\":{\"dropped_spans\":%zu}}\n", dropped);
+  int error = ferror(out) ? EIO : 0;
+  if(fclose(out) != 0 && error == 0){
+    error = errno;
+  }
+  if(error != 0){
+    errno = error;
+    return -1;
+  }
+  return 0;
+}
+
+void trace_clear(void){
+  pthread_mutex_lock(&rings_lock);
+  struct ring* ring = rings;
+  while(ring != NULL){
+    struct ring* next = ring->next;
+    free(ring);
+    ring = next;
+  }
+  rings = NULL;
+  n_rings = 0;
+  __atomic_add_fetch(&generation, 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&rings_lock);
+  thread_ring = NULL;
+}
+
+size_t trace_count(void){
+  size_t count = 0;
+  pthread_mutex_lock(&rings_lock);
+  for(struct ring* ring = rings; ring != NULL; ring = ring->next){
+    count += ring->written;
+  }
+  pthread_mutex_unlock(&rings_lock);
+  return count;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file trace.h
+ * @brief Scoped trace spans with Chrome trace_event output
+ *
+ * Spans are recorded as complete events into a ring buffer of the
+ * thread which ends them, so recording takes no locks. Once a ring is
+ * full, the oldest events are overwritten. trace_dump writes the spans
+ * of all threads as a Chrome trace_event JSON file, which can be opened
+ * in chrome://tracing or Perfetto.
+ *
+ * Tracing starts out disabled, then the span macros cost a single
+ * predictable branch. Defining AOC_NO_TRACE compiles them out entirely.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Spans per thread kept before the oldest ones are overwritten
+ */
+#define TRACE_RING_SIZE 4096
+
+/**
+ * Spans nested deeper than this are not recorded
+ */
+#define TRACE_MAX_DEPTH 32
+
+extern bool trace_enabled;
+
+/**
+ * @brief Enables or disables recording of spans
+ *
+ * Only change this while no spans are open, e.g. before a day's
+ * functions run.
+ */
+void trace_enable(bool enable);
+
+/**
+ * @brief Opens a span named @e name on the calling thread
+ *
+ * Use TRACE_BEGIN instead. @e name must stay valid until the trace is
+ * dumped, which string literals do.
+ */
+void trace_begin(const char* name);
+
+/**
+ * @brief Closes the innermost open span of the calling thread
+ *
+ * Use TRACE_END instead.
+ */
+void trace_end(void);
+
+/**
+ * @brief Writes all recorded spans to @e fpath in Chrome's trace format
+ *
+ * Must not be called while other threads record spans.
+ *
+ * @param fpath Path of the JSON file to write
+ * @returns 0 on success, -1 with errno set if the file can't be written
+ */
+int trace_dump(const char* fpath);
+
+/**
+ * @brief Drops all recorded spans and frees the threads' rings
+ *
+ * Must not be called while other threads record spans.
+ */
+void trace_clear(void);
+
+/**
+ * @brief Returns the number of spans recorded since the last clear,
+ *        including overwritten ones
+ */
+size_t trace_count(void);
+
+#ifdef AOC_NO_TRACE
+
+#define TRACE_BEGIN(name) ((void) 0)
+#define TRACE_END() ((void) 0)
+#define TRACE_SCOPE(name) ((void) 0)
+
+#else
+
+#define TRACE_BEGIN(name) do{                   \
+    if(__builtin_expect(trace_enabled, false)){ \
+      trace_begin(name);                        \
+    }                                           \
+  } while(0)
+
+#define TRACE_END() do{                         \
+    if(__builtin_expect(trace_enabled, false)){ \
+      trace_end();                              \
+    }                                           \
+  } while(0)
+
+static inline bool trace_scope_begin(const char* name){
+  if(__builtin_expect(trace_enabled, false)){
+    trace_begin(name);
+    return true;
+  }
+  return false;
+}
+
+static inline void trace_scope_end(bool* open){
+  if(*open){
+    trace_end();
+  }
+}
+
+#define TRACE_CAT_(a, b) a ## b
+#define TRACE_CAT(a, b) TRACE_CAT_(a, b)
+
+/**
+ * Opens a span which is closed when the enclosing block is left, also
+ * on an early return.
+ */
+#define TRACE_SCOPE(name)                                        \
+  bool TRACE_CAT(trace_scope_, __LINE__)                         \
+  __attribute__((cleanup(trace_scope_end), unused))              \
+  = trace_scope_begin(name)
+
+#endif
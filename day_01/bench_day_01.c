@@ -0,0 +1,140 @@
+/**
+ * @file bench_day_01.c
+ * @brief Compares the implementations of day 01
+ *
+ * Usage: bench_day_01 [LINES]
+ *
+ * Generates LINES random frequency changes, one per line, and computes
+ * the resulting frequency with compute_freq on a tokenizer and with
+ * compute_freq_raw for each fastparse kernel the CPU supports. Then runs
+ * both raw parts with the fastest kernel on 1, 2, 4, ... threads, up to
+ * one per CPU. Prints the best time of several rounds for each, next to a
+ * plain read of the buffer as the memory bandwidth to aim for.
+ */
+
+#include "chronal_calibration.h"
+#include "fastparse.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#define ROUNDS 5
+
+static uint64_t now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec*1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static volatile uint64_t sink;
+
+static char* read_words(const char* input, size_t len){
+  uint64_t sum = 0;
+  for(size_t i = 0; i + 8 <= len; i += 8){
+    uint64_t word;
+    memcpy(&word, input + i, 8);
+    sum += word;
+  }
+  sink = sum;
+  return strdup("");
+}
+
+static char* tokenized(const char* input, size_t len){
+  tok_t* tok = get_tokenizer_n(input, len, "\n");
+  if(tok == NULL){
+    return NULL;
+  }
+  char* res = compute_freq(tok);
+  free_tok(tok);
+  return res;
+}
+
+/**
+ * Runs @e f ROUNDS times and prints its best throughput. Returns its
+ * result, to be freed by the caller.
+ */
+static char* run(const char* name, char* (*f)(const char*, size_t),
+                 const char* input, size_t len){
+  uint64_t best = UINT64_MAX;
+  char* res = NULL;
+  for(int r = 0; r < ROUNDS; r++){
+    free(res);
+    uint64_t start = now_ns();
+    res = f(input, len);
+    uint64_t t = now_ns() - start;
+    best = t < best ? t : best;
+  }
+  printf("%-16s %8.2f ms %8.1f MB/s\n", name, best / 1e6,
+         len / 1e6 / (best > 0 ? best / 1e9 : 1e-9));
+  return res;
+}
+
+int main(int argc, char** argv){
+  static const char* impl_names[] = {"scalar", "swar", "sse4.1", "avx2"};
+  static char* (*parts[])(const char*, size_t) = {
+    compute_freq_raw, get_first_repetition_raw,
+  };
+  size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+  // Sign, up to six digits and the newline
+  char* input = malloc(8*n + 1);
+  if(n == 0 || input == NULL){
+    fprintf(stderr, "Usage: %s [LINES]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  srand(2018);
+  size_t len = 0;
+  for(size_t i = 0; i < n; i++){
+    len += sprintf(input + len, "%c%d\n", rand() % 2 ? '+' : '-',
+                   rand() % 200000);
+  }
+  printf("%zu lines, %.1f MB\n", n, len / 1e6);
+  free(run("memory read", read_words, input, len));
+  char* exp = run("tokenizer", tokenized, input, len);
+  int ret = exp == NULL ? EXIT_FAILURE : EXIT_SUCCESS;
+  for(int impl = FP_IMPL_SCALAR; impl <= FP_IMPL_AVX2; impl++){
+    if(fp_set_impl(impl) != 0){
+      continue;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "raw %s", impl_names[impl]);
+    char* res = run(name, compute_freq_raw, input, len);
+    if(res == NULL || exp == NULL || strcmp(res, exp) != 0){
+      fprintf(stderr, "%s: results differ (%s vs %s).\n", name,
+              res == NULL ? "error" : res, exp == NULL ? "error" : exp);
+      ret = EXIT_FAILURE;
+    }
+    free(res);
+  }
+  for(int impl = FP_IMPL_AVX2; fp_set_impl(impl) != 0; impl--){
+  }
+  long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  for(int part = 0; part < 2; part++){
+    char* first = NULL;
+    for(unsigned threads = 1; threads == 1 || (long) threads <= n_cpus;
+        threads *= 2){
+      set_scan_threads(threads);
+      char name[32];
+      snprintf(name, sizeof(name), "part %d, %u thr", part + 1, threads);
+      char* res = run(name, parts[part], input, len);
+      if(res == NULL || (first != NULL && strcmp(res, first) != 0)){
+        fprintf(stderr, "%s: results differ.\n", name);
+        ret = EXIT_FAILURE;
+      }
+      if(first == NULL){
+        first = res;
+      }
+      else{
+        free(res);
+      }
+    }
+    free(first);
+  }
+  free(exp);
+  free(input);
+  return ret;
+}
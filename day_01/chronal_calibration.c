@@ -6,28 +6,45 @@
 #include "chronal_calibration.h"
 
 #include "aoc_err.h"
+#include "fastparse.h"
+#include "hashmap.h"
+#include "thread_pool.h"
 
 #include <errno.h>
-#include <search.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-char* compute_freq(tok_t* tok){
-  long res = 0;
-  char* curr;
-  long parsed;
-  while((curr = n_tok(tok)) != NULL){
-    errno = 0;
-    parsed = strtol(curr, NULL, 10);
-    if(errno != 0){
-      set_aoc_err_msg("Error parsing frequency numbers", errno);
-      return NULL;
-    }
-    res += parsed;
+#include <unistd.h>
+
+/**
+ * Parses a single frequency change like "+3" or "-12" into @e change.
+ * @e s is the @e len bytes of a token in place in the input.
+ */
+static int parse_change(const char* s, size_t len, long* change){
+  int64_t parsed;
+  switch(fp_parse_i64(s, NULL, &parsed)){
+  case FP_OK:
+    *change = parsed;
+    return 0;
+  case FP_OVERFLOW:
+    AOC_ERR(AOC_ERR_RANGE, ERANGE, "Error parsing frequency numbers");
+    return -1;
+  default:
+    AOC_ERR(AOC_ERR_PARSE, 0, "Invalid frequency change \"%.*s\".",
+            (int) len, s);
+    return -1;
   }
+}
+
+/**
+ * Formats the resulting frequency @e res as a heap allocated string.
+ */
+static char* format_freq(long res){
   int count = 0;
   long n = res;
   while(n != 0){
@@ -39,58 +56,726 @@ char* compute_freq(tok_t* tok){
   return output;
 }
 
-int treecomp(const void* first, const void* second){
-  if(*((long*)first) < *((long*)second)){
-    return -1;
+char* compute_freq(tok_t* tok){
+  long res = 0;
+  long parsed;
+  int count = tok_count(tok);
+  for(int i = 0; i < count; i++){
+    if(parse_change(tok_view(tok, i), tok_len(tok, i), &parsed) != 0){
+      return NULL;
+    }
+    res += parsed;
   }
-  else if(*((long*)first) > *((long*)second)){
-    return 1;
+  return format_freq(res);
+}
+
+/**
+ * Shards with less work than this aren't worth a thread of their own
+ */
+#define SCAN_MIN_SHARD_BYTES (1u << 20)
+#define SCAN_MIN_SHARD_CHANGES (1u << 17)
+
+static unsigned scan_threads = 0;
+
+void set_scan_threads(unsigned n){
+  scan_threads = n;
+}
+
+/**
+ * Returns the number of shards to split @e items items of work into,
+ * with at least @e min_items in each, unless set_scan_threads forced a
+ * number.
+ */
+static unsigned scan_shards(size_t items, size_t min_items){
+  size_t shards = scan_threads;
+  if(shards == 0){
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    shards = items / min_items;
+    if(n_cpus > 0 && shards > (size_t) n_cpus){
+      shards = n_cpus;
+    }
+  }
+  if(shards > items){
+    shards = items;
+  }
+  return shards > 1 ? shards : 1;
+}
+
+/**
+ * Runs @e task on each of the @e n_shards shards, on @e pool if there
+ * is one and on the calling thread otherwise.
+ */
+static void run_shards(tpool_t* pool, unsigned n_shards, tpool_task_t task,
+                       void* ctx){
+  if(pool != NULL){
+    tpool_run(pool, n_shards, task, ctx);
+    return;
+  }
+  for(unsigned shard = 0; shard < n_shards; shard++){
+    task(ctx, shard, 0);
+  }
+}
+
+/**
+ * Starts a pool for @e n_shards shards. Without one, which is no error,
+ * the shards run one after the other.
+ */
+static tpool_t* shard_pool(unsigned n_shards){
+  return n_shards > 1 ? tpool_create(n_shards) : NULL;
+}
+
+/**
+ * A scan over the lines of the raw input, cut into shards at newlines.
+ * The first pass sums and counts the changes of each shard, the second
+ * one parses them into @e changes and @e sums, starting at the offsets
+ * of the shards before.
+ */
+struct line_scan{
+  const char* input;
+  bool count;
+  // n_shards + 1 cuts, shard i ends with the newline at cuts[i+1]
+  size_t* cuts;
+  fp_status_t* status;
+  const char** bad;
+  // Per shard: its count and sum after the first pass, the counts and
+  // sums of the shards before it after the offsets are propagated
+  size_t* counts;
+  long* sums_before;
+  // Per shard: whether a frequency overflowed in the second pass
+  bool* overflow;
+  long* changes;
+  long* sums;
+};
+
+static void cut_lines(const char* input, size_t len, size_t* cuts,
+                      unsigned n_shards){
+  cuts[0] = 0;
+  for(unsigned i = 1; i < n_shards; i++){
+    size_t cut = len / n_shards * i;
+    if(cut < cuts[i-1]){
+      cut = cuts[i-1];
+    }
+    const char* nl = memchr(input + cut, '\n', len - cut);
+    cuts[i] = nl == NULL ? len : (size_t) (nl - input);
+  }
+  cuts[n_shards] = len;
+}
+
+static size_t count_lines(const char* s, size_t len){
+  size_t count = 0;
+  char prev = '\n';
+  for(size_t i = 0; i < len; i++){
+    count += prev == '\n' && s[i] != '\n';
+    prev = s[i];
+  }
+  return count;
+}
+
+static void sum_lines_shard(void* ctx, size_t shard, unsigned worker){
+  (void)(worker);
+  struct line_scan* scan = ctx;
+  const char* s = scan->input + scan->cuts[shard];
+  size_t len = scan->cuts[shard+1] - scan->cuts[shard];
+  int64_t sum;
+  scan->status[shard] = fp_sum_lines_i64(s, len, &sum, &scan->bad[shard]);
+  scan->sums_before[shard] = sum;
+  scan->counts[shard] = scan->count ? count_lines(s, len) : 0;
+}
+
+static void parse_lines_shard(void* ctx, size_t shard, unsigned worker){
+  (void)(worker);
+  struct line_scan* scan = ctx;
+  const char* p = scan->input + scan->cuts[shard];
+  const char* end = scan->input + scan->cuts[shard+1];
+  size_t idx = scan->counts[shard];
+  long sum = scan->sums_before[shard];
+  bool overflow = false;
+  while(p < end){
+    const char* nl = memchr(p, '\n', end - p);
+    if(nl == NULL){
+      nl = end;
+    }
+    if(nl > p){
+      // Checked by the first pass
+      int64_t change;
+      fp_parse_i64(p, NULL, &change);
+      scan->changes[idx] = change;
+      scan->sums[idx] = sum;
+      overflow |= __builtin_add_overflow(sum, change, &sum);
+      idx++;
+    }
+    p = nl + 1;
+  }
+  scan->overflow[shard] = overflow;
+}
+
+/**
+ * Sets the AoC error for a failed fp_sum_lines_i64
+ */
+static void sum_error(fp_status_t status, const char* bad){
+  if(status == FP_OVERFLOW){
+    AOC_ERR(AOC_ERR_RANGE, ERANGE, "Error parsing frequency numbers");
   }
   else{
-    return 0;
+    AOC_ERR(AOC_ERR_PARSE, 0, "Invalid frequency change \"%.*s\".",
+            (int) strcspn(bad, "\n"), bad);
   }
 }
 
-char* get_first_repetition(tok_t* tok){
-  long* sum = malloc(sizeof(long));
-  *sum = 0;
-  long* prevsum = malloc(sizeof(long));
-  *prevsum = 0;
-  char* curr;
-  long parsed;
-  void* treeroot = NULL;
+/**
+ * Runs the first pass of a line scan over @e input on @e pool, then
+ * propagates the offsets of the shards. Sets an AoC error and returns
+ * -1 if a change is invalid or the sum overflows. Receives the number
+ * of changes in @e n, if counted, and their sum in @e total.
+ */
+static int scan_line_sums(struct line_scan* scan, tpool_t* pool,
+                          unsigned n_shards, size_t* n, long* total){
+  run_shards(pool, n_shards, sum_lines_shard, scan);
+  size_t count = 0;
+  long sum = 0;
+  for(unsigned i = 0; i < n_shards; i++){
+    if(scan->status[i] != FP_OK){
+      sum_error(scan->status[i], scan->bad[i]);
+      return -1;
+    }
+    long shard_sum = scan->sums_before[i];
+    size_t shard_count = scan->counts[i];
+    scan->sums_before[i] = sum;
+    scan->counts[i] = count;
+    if(__builtin_add_overflow(sum, shard_sum, &sum)){
+      sum_error(FP_OVERFLOW, NULL);
+      return -1;
+    }
+    count += shard_count;
+  }
+  *n = count;
+  *total = sum;
+  return 0;
+}
+
+/**
+ * Allocates the per shard arrays of @e scan for @e n_shards shards over
+ * @e input. Returns -1 after setting an AoC error if that fails.
+ */
+static int line_scan_init(struct line_scan* scan, const char* input,
+                          size_t len, unsigned n_shards, bool count){
+  scan->input = input;
+  scan->count = count;
+  scan->cuts = malloc((n_shards + 1)*sizeof(size_t));
+  scan->status = malloc(n_shards*sizeof(fp_status_t));
+  scan->bad = malloc(n_shards*sizeof(const char*));
+  scan->counts = malloc(n_shards*sizeof(size_t));
+  scan->sums_before = malloc(n_shards*sizeof(long));
+  scan->overflow = malloc(n_shards*sizeof(bool));
+  scan->changes = NULL;
+  scan->sums = NULL;
+  if(scan->cuts == NULL || scan->status == NULL || scan->bad == NULL
+     || scan->counts == NULL || scan->sums_before == NULL
+     || scan->overflow == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for the input shards.");
+    return -1;
+  }
+  cut_lines(input, len, scan->cuts, n_shards);
+  return 0;
+}
+
+static void line_scan_free(struct line_scan* scan){
+  free(scan->cuts);
+  free(scan->status);
+  free(scan->bad);
+  free(scan->counts);
+  free(scan->sums_before);
+  free(scan->overflow);
+}
+
+char* compute_freq_raw(const char* input, size_t len){
+  unsigned n_shards = scan_shards(len, SCAN_MIN_SHARD_BYTES);
+  struct line_scan scan;
+  if(line_scan_init(&scan, input, len, n_shards, false) != 0){
+    line_scan_free(&scan);
+    return NULL;
+  }
+  tpool_t* pool = shard_pool(n_shards);
+  size_t n;
+  long sum;
+  int ret = scan_line_sums(&scan, pool, n_shards, &n, &sum);
+  tpool_destroy(pool);
+  line_scan_free(&scan);
+  return ret == 0 ? format_freq(sum) : NULL;
+}
+
+HASHSET_DEFINE(sumset, long)
+
+long* parse_changes(tok_t* tok, size_t* n){
+  if(tok == NULL){
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is NULL.");
+    return NULL;
+  }
+  int count = tok_count(tok);
+  // One more, so an empty input doesn't look like an allocation failure
+  long* changes = malloc((count + 1u)*sizeof(long));
+  if(changes == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for the frequency changes.");
+    return NULL;
+  }
+  for(int i = 0; i < count; i++){
+    if(parse_change(tok_view(tok, i), tok_len(tok, i), &changes[i]) != 0){
+      free(changes);
+      return NULL;
+    }
+  }
+  *n = count;
+  return changes;
+}
+
+static rep_mode_t rep_mode = REP_AUTO;
+static size_t rep_budget = REP_DEFAULT_BUDGET;
+
+void set_repetition_mode(rep_mode_t mode){
+  rep_mode = mode;
+}
+
+void set_repetition_budget(size_t bytes){
+  rep_budget = bytes;
+}
+
+/**
+ * Computes the range of frequencies the simulation can reach before
+ * the first repetition. With the frequencies of the first cycle in
+ * [lo, hi] and a drift T > 0, each frequency meets a larger one of
+ * its residue class within (hi - lo)/T cycles, so if nothing repeated
+ * up to 2*hi - lo, nothing ever will. Negative drifts are mirrored.
+ * The range is clamped to the values of a long. Sets an AoC error and
+ * returns -1 if a frequency of the first cycle overflows.
+ */
+static int reach_bounds(const long* changes, size_t n, long* lo, long* hi){
+  long sum = 0;
+  *lo = 0;
+  *hi = 0;
+  for(size_t i = 0; i < n; i++){
+    if(__builtin_add_overflow(sum, changes[i], &sum)){
+      sum_error(FP_OVERFLOW, NULL);
+      return -1;
+    }
+    if(i + 1 < n){
+      *lo = sum < *lo ? sum : *lo;
+      *hi = sum > *hi ? sum : *hi;
+    }
+  }
+  long span;
+  if(__builtin_sub_overflow(*hi, *lo, &span)){
+    span = LONG_MAX;
+  }
+  if(sum > 0 && __builtin_add_overflow(*hi, span, hi)){
+    *hi = LONG_MAX;
+  }
+  else if(sum < 0 && __builtin_sub_overflow(*lo, span, lo)){
+    *lo = LONG_MIN;
+  }
+  return 0;
+}
+
+/**
+ * Whether a frequency that overflowed with @e change has left the
+ * reachable range [lo, hi] as well, so it proves that nothing repeats.
+ * It hasn't if the bound on its side was clamped to the values of a
+ * long.
+ */
+static bool overflow_beyond(long change, long lo, long hi){
+  return change > 0 ? hi < LONG_MAX : lo > LONG_MIN;
+}
+
+/**
+ * Simulation remembering the frequencies seen in a hash set
+ */
+static int simulate_hashset(const long* changes, size_t n, long lo, long hi,
+                            long* freq){
+  sumset_t seen;
+  sumset_init(&seen);
+  long sum = 0;
+  // Room for the sums of the first cycle, later cycles grow the set
+  int inserted = -1;
+  if(sumset_reserve(&seen, n + 1) == 0){
+    inserted = sumset_insert(&seen, sum);
+  }
+  bool out_of_range = false;
+  for(size_t i = 0; inserted > 0; i = i + 1 == n ? 0 : i + 1){
+    if(__builtin_add_overflow(sum, changes[i], &sum)){
+      out_of_range = !overflow_beyond(changes[i], lo, hi);
+      break;
+    }
+    if(sum < lo || sum > hi){
+      break;
+    }
+    inserted = sumset_insert(&seen, sum);
+  }
+  sumset_free(&seen);
+  if(inserted < 0){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for the frequencies seen.");
+    return -1;
+  }
+  if(out_of_range){
+    AOC_ERR(AOC_ERR_RANGE, 0, "The frequencies leave the values of a long "
+            "before repeating.");
+    return -1;
+  }
+  if(inserted > 0){
+    AOC_ERR(AOC_ERR_NOTFOUND, 0, "The frequencies never repeat.");
+    return -1;
+  }
+  *freq = sum;
+  return 0;
+}
+
+/**
+ * Simulation remembering the frequencies seen in a bitmap over [lo, hi],
+ * which must be less than the whole range of a long
+ */
+static int simulate_bitmap(const long* changes, size_t n, long lo, long hi,
+                           long* freq){
+  unsigned long bits = (unsigned long) hi - (unsigned long) lo + 1ul;
+  uint64_t* seen = calloc((bits + 63)/64, sizeof(uint64_t));
+  if(seen == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for the frequencies seen.");
+    return -1;
+  }
+  long sum = 0;
+  // Offsets from lo in unsigned arithmetic, where leaving the range on
+  // either side shows up as an offset of at least bits
+  unsigned long off = 0ul - (unsigned long) lo;
   bool repeated = false;
-  long* searchres;
-  // Insert initial zero
-  tsearch(sum, &treeroot, treecomp);
-  while(!repeated){
-    while((curr = n_tok(tok)) != NULL){
-      errno = 0;
-      parsed = strtol(curr, NULL, 10);
-      if(errno != 0){
-        set_aoc_err_msg("Error parsing frequency numbers", errno);
-        return NULL;
+  bool out_of_range = false;
+  for(size_t i = 0; off < bits; i = i + 1 == n ? 0 : i + 1){
+    uint64_t bit = UINT64_C(1) << (off % 64);
+    if(seen[off/64] & bit){
+      repeated = true;
+      break;
+    }
+    seen[off/64] |= bit;
+    if(__builtin_add_overflow(sum, changes[i], &sum)){
+      out_of_range = !overflow_beyond(changes[i], lo, hi);
+      break;
+    }
+    off = (unsigned long) sum - (unsigned long) lo;
+  }
+  free(seen);
+  if(out_of_range){
+    AOC_ERR(AOC_ERR_RANGE, 0, "The frequencies leave the values of a long "
+            "before repeating.");
+    return -1;
+  }
+  if(!repeated){
+    AOC_ERR(AOC_ERR_NOTFOUND, 0, "The frequencies never repeat.");
+    return -1;
+  }
+  *freq = sum;
+  return 0;
+}
+
+int simulate_repetition(const long* changes, size_t n, long* freq){
+  if(n == 0){
+    AOC_ERR(AOC_ERR_INVAL, 0, "No frequency changes.");
+    return -1;
+  }
+  long lo, hi;
+  if(reach_bounds(changes, n, &lo, &hi) != 0){
+    return -1;
+  }
+  unsigned long span = (unsigned long) hi - (unsigned long) lo;
+  // In words of 64 bits, for the span + 1 frequencies
+  unsigned long bitmap_bytes = (span/64 + 1)*sizeof(uint64_t);
+  if(span < ULONG_MAX && bitmap_bytes <= rep_budget){
+    return simulate_bitmap(changes, n, lo, hi, freq);
+  }
+  return simulate_hashset(changes, n, lo, hi, freq);
+}
+
+/**
+ * A scan over an array of changes, cut into equal shards. The first
+ * pass sums the changes of each shard, the second one writes their
+ * prefix sums, starting at the sum of the shards before.
+ */
+struct array_scan{
+  const long* changes;
+  long* sums;
+  size_t n;
+  unsigned n_shards;
+  // Per shard: its sum after the first pass, the sum of the shards
+  // before it after the offsets are propagated
+  long* sums_before;
+  // Per shard: whether a sum in it overflowed
+  bool* overflow;
+};
+
+static void sum_array_shard(void* ctx, size_t shard, unsigned worker){
+  (void)(worker);
+  struct array_scan* scan = ctx;
+  size_t begin = scan->n / scan->n_shards * shard;
+  size_t end = shard + 1 == scan->n_shards ? scan->n
+    : scan->n / scan->n_shards * (shard + 1);
+  long sum = 0;
+  bool overflow = false;
+  for(size_t i = begin; i < end; i++){
+    overflow |= __builtin_add_overflow(sum, scan->changes[i], &sum);
+  }
+  scan->sums_before[shard] = sum;
+  scan->overflow[shard] = overflow;
+}
+
+static void write_array_shard(void* ctx, size_t shard, unsigned worker){
+  (void)(worker);
+  struct array_scan* scan = ctx;
+  size_t begin = scan->n / scan->n_shards * shard;
+  size_t end = shard + 1 == scan->n_shards ? scan->n
+    : scan->n / scan->n_shards * (shard + 1);
+  long sum = scan->sums_before[shard];
+  bool overflow = false;
+  for(size_t i = begin; i < end; i++){
+    scan->sums[i] = sum;
+    overflow |= __builtin_add_overflow(sum, scan->changes[i], &sum);
+  }
+  scan->overflow[shard] = overflow;
+}
+
+/**
+ * Returns whether a sum of one of the @e n_shards shards overflowed,
+ * after setting an AoC error.
+ */
+static bool shards_overflowed(const bool* overflow, unsigned n_shards){
+  for(unsigned i = 0; i < n_shards; i++){
+    if(overflow[i]){
+      sum_error(FP_OVERFLOW, NULL);
+      return true;
+    }
+  }
+  return false;
+}
+
+int prefix_sums(const long* changes, size_t n, long* sums, long* total){
+  unsigned n_shards = scan_shards(n, SCAN_MIN_SHARD_CHANGES);
+  struct array_scan scan = {
+    .changes = changes,
+    .sums = sums,
+    .n = n,
+    .n_shards = n_shards,
+    .sums_before = malloc(n_shards*sizeof(long)),
+    .overflow = malloc(n_shards*sizeof(bool)),
+  };
+  if(scan.sums_before == NULL || scan.overflow == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for the input shards.");
+    free(scan.sums_before);
+    free(scan.overflow);
+    return -1;
+  }
+  tpool_t* pool = shard_pool(n_shards);
+  run_shards(pool, n_shards, sum_array_shard, &scan);
+  long sum = 0;
+  bool overflow = shards_overflowed(scan.overflow, n_shards);
+  for(unsigned i = 0; i < n_shards && !overflow; i++){
+    long shard_sum = scan.sums_before[i];
+    scan.sums_before[i] = sum;
+    if(__builtin_add_overflow(sum, shard_sum, &sum)){
+      sum_error(FP_OVERFLOW, NULL);
+      overflow = true;
+    }
+  }
+  if(!overflow){
+    // Frequencies within a shard may leave the range even if its sum
+    // and offset fit
+    run_shards(pool, n_shards, write_array_shard, &scan);
+    overflow = shards_overflowed(scan.overflow, n_shards);
+  }
+  tpool_destroy(pool);
+  free(scan.sums_before);
+  free(scan.overflow);
+  if(overflow){
+    return -1;
+  }
+  *total = sum;
+  return 0;
+}
+
+/**
+ * A frequency of the first cycle: reached after @e idx changes, at
+ * @e key above the lowest frequency possible, which is congruent to
+ * @e residue modulo the drift. Offsetting the frequencies keeps them
+ * unsigned, so residues and differences can't overflow.
+ */
+struct partial{
+  unsigned long residue;
+  unsigned long key;
+  size_t idx;
+};
+
+static int comp_partial(const void* a, const void* b){
+  const struct partial* pa = a;
+  const struct partial* pb = b;
+  if(pa->residue != pb->residue){
+    return pa->residue < pb->residue ? -1 : 1;
+  }
+  if(pa->key != pb->key){
+    return pa->key < pb->key ? -1 : 1;
+  }
+  return (pa->idx > pb->idx) - (pa->idx < pb->idx);
+}
+
+/**
+ * Frequency f_i + k*T of cycle k is reached at step k*n + i, so the
+ * frequencies of index i and j can only meet if f_i and f_j are
+ * congruent modulo the drift T. For a positive T, f_i catches up with
+ * a larger f_j after (f_j - f_i)/T cycles, and the nearest larger
+ * frequency of the same residue is the first one it catches. Equal
+ * frequencies of the first cycle meet in that cycle already.
+ *
+ * The steps are compared as (cycles, index) pairs, which keeps them
+ * exact even when cycles*n would overflow. A negative T is handled by
+ * mirroring the frequencies, which is where the keys come in: -f_i
+ * doesn't fit a long for f_i == LONG_MIN, but LONG_MAX - f_i fits an
+ * unsigned long. As all keys are offset alike, they still group by
+ * residue, and their differences are those of the frequencies.
+ */
+static int closed_form(const long* changes, const long* sums, size_t n,
+                       long drift, long* freq){
+  if(drift == 0){
+    // Repeats within the first two cycles, nothing to gain
+    return simulate_repetition(changes, n, freq);
+  }
+  if(drift == LONG_MIN){
+    AOC_ERR(AOC_ERR_RANGE, 0, "The frequencies drift by %ld per cycle, "
+            "which is out of range.", drift);
+    return -1;
+  }
+  // Mirror a negative drift, so frequencies only ever grow
+  bool mirror = drift < 0;
+  unsigned long m = mirror ? -(unsigned long) drift : (unsigned long) drift;
+  struct partial* parts = malloc(n*sizeof(struct partial));
+  if(parts == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for %zu frequencies.", n);
+    return -1;
+  }
+  for(size_t i = 0; i < n; i++){
+    parts[i].key = mirror ? (unsigned long) LONG_MAX - (unsigned long) sums[i]
+      : (unsigned long) sums[i] - (unsigned long) LONG_MIN;
+    parts[i].residue = parts[i].key % m;
+    parts[i].idx = i;
+  }
+  qsort(parts, n, sizeof(struct partial), comp_partial);
+  bool found = false;
+  unsigned long best_cycles = 0;
+  size_t best_idx = 0;
+  // Index of the repeated frequency
+  size_t best_rep = 0;
+  for(size_t run = 0; run < n; ){
+    // parts[run] has the lowest index of its run of equal frequencies
+    size_t next = run + 1;
+    for(; next < n && parts[next].residue == parts[run].residue
+          && parts[next].key == parts[run].key; next++){
+      // Repeats the frequency of parts[run] in the first cycle
+      if(!found || best_cycles > 0 || parts[next].idx < best_idx){
+        found = true;
+        best_cycles = 0;
+        best_idx = parts[next].idx;
+        best_rep = parts[next].idx;
       }
-      prevsum = sum;
-      sum = malloc(sizeof(long));
-      *sum = *prevsum + parsed;
-      searchres = tsearch(sum, &treeroot, treecomp);
-      if(*((long**)searchres) != sum){
-        repeated = true;
-        break;
+    }
+    if(next < n && parts[next].residue == parts[run].residue){
+      unsigned long cycles = (parts[next].key - parts[run].key)/m;
+      if(!found || cycles < best_cycles
+         || (cycles == best_cycles && parts[run].idx < best_idx)){
+        found = true;
+        best_cycles = cycles;
+        best_idx = parts[run].idx;
+        best_rep = parts[next].idx;
       }
     }
-    reset_tok(tok);
+    run = next;
   }
-  int count = 0;
-  long n = *sum;
-  while(n != 0){
-    n /= 10l;
-    count++;
+  free(parts);
+  if(!found){
+    AOC_ERR(AOC_ERR_NOTFOUND, 0, "The frequencies never repeat.");
+    return -1;
   }
-  char* output = malloc(count+2);
-  snprintf(output, count+2, "%ld",*sum);
-  tdestroy(treeroot,free);
-  return output;
+  *freq = sums[best_rep];
+  return 0;
+}
+
+int closed_form_repetition(const long* changes, size_t n, long* freq){
+  if(n == 0){
+    AOC_ERR(AOC_ERR_INVAL, 0, "No frequency changes.");
+    return -1;
+  }
+  long* sums = malloc(n*sizeof(long));
+  if(sums == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for %zu frequencies.", n);
+    return -1;
+  }
+  long drift;
+  int ret = prefix_sums(changes, n, sums, &drift);
+  if(ret == 0){
+    ret = closed_form(changes, sums, n, drift, freq);
+  }
+  free(sums);
+  return ret;
+}
 
+int first_repetition(const long* changes, size_t n, long* freq){
+  if(rep_mode == REP_SIMULATE){
+    return simulate_repetition(changes, n, freq);
+  }
+  return closed_form_repetition(changes, n, freq);
+}
+
+char* get_first_repetition(tok_t* tok){
+  size_t n;
+  long* changes = parse_changes(tok, &n);
+  if(changes == NULL){
+    return NULL;
+  }
+  long sum;
+  int ret = first_repetition(changes, n, &sum);
+  free(changes);
+  if(ret != 0){
+    return NULL;
+  }
+  return format_freq(sum);
+}
+
+char* get_first_repetition_raw(const char* input, size_t len){
+  unsigned n_shards = scan_shards(len, SCAN_MIN_SHARD_BYTES);
+  struct line_scan scan;
+  if(line_scan_init(&scan, input, len, n_shards, true) != 0){
+    line_scan_free(&scan);
+    return NULL;
+  }
+  tpool_t* pool = shard_pool(n_shards);
+  size_t n;
+  long drift;
+  long freq;
+  int ret = scan_line_sums(&scan, pool, n_shards, &n, &drift);
+  if(ret == 0 && n == 0){
+    AOC_ERR(AOC_ERR_INVAL, 0, "No frequency changes.");
+    ret = -1;
+  }
+  if(ret == 0){
+    scan.changes = malloc(n*sizeof(long));
+    scan.sums = malloc(n*sizeof(long));
+    if(scan.changes == NULL || scan.sums == NULL){
+      AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for %zu frequencies.", n);
+      ret = -1;
+    }
+  }
+  if(ret == 0){
+    run_shards(pool, n_shards, parse_lines_shard, &scan);
+    ret = shards_overflowed(scan.overflow, n_shards) ? -1 : 0;
+  }
+  tpool_destroy(pool);
+  if(ret == 0){
+    ret = rep_mode == REP_SIMULATE
+      ? simulate_repetition(scan.changes, n, &freq)
+      : closed_form(scan.changes, scan.sums, n, drift, &freq);
+  }
+  free(scan.changes);
+  free(scan.sums);
+  line_scan_free(&scan);
+  return ret == 0 ? format_freq(freq) : NULL;
 }
@@ -5,6 +5,136 @@
 
 #include "tokenizer.h"
 
+#include <stddef.h>
+
 char* compute_freq(tok_t* tok);
 
 char* get_first_repetition(tok_t* tok);
+
+/**
+ * @brief compute_freq on the raw input, without a tokenizer
+ *
+ * Cuts the input into shards at newlines and sums the changes of each
+ * shard with fp_sum_lines_i64 on a thread of its own, see
+ * set_scan_threads.
+ *
+ * @param input The null terminated input, one change per line
+ * @param len Length of @e input
+ * @returns The resulting frequency, to be freed by the caller, or NULL
+ *          on error
+ */
+char* compute_freq_raw(const char* input, size_t len);
+
+/**
+ * @brief get_first_repetition on the raw input, without a tokenizer
+ *
+ * Sums the shards of the input in parallel like compute_freq_raw, which
+ * gives each shard the offset its frequencies start at. A second
+ * parallel pass then parses the changes and writes the frequencies of
+ * the first cycle, which the closed form starts from.
+ *
+ * @param input The null terminated input, one change per line
+ * @param len Length of @e input
+ * @returns The first repeated frequency, to be freed by the caller, or
+ *          NULL on error
+ */
+char* get_first_repetition_raw(const char* input, size_t len);
+
+/**
+ * Upper bound for set_scan_threads
+ */
+#define SCAN_MAX_THREADS 1024u
+
+/**
+ * @brief Sets the number of threads of the parallel scans
+ *
+ * @param n The number of threads, up to SCAN_MAX_THREADS. 0 picks one
+ *        per CPU, as long as each gets enough work to be worth it
+ */
+void set_scan_threads(unsigned n);
+
+/**
+ * @brief Parallel exclusive prefix sums of the frequency changes
+ *
+ * Each thread sums its shard of @e changes, the shard sums are turned
+ * into offsets, then each thread writes the prefix sums of its shard
+ * starting at its offset.
+ *
+ * @param changes The frequency changes
+ * @param n The number of changes
+ * @param sums Receives the @e n frequencies before each change
+ * @param total Receives the sum of all changes
+ * @returns 0 on success, -1 on error, with an AOC_ERR_RANGE error if a
+ *          sum doesn't fit a long
+ */
+int prefix_sums(const long* changes, size_t n, long* sums, long* total);
+
+/**
+ * @brief Parses all frequency changes of @e tok into an array
+ *
+ * @param tok The tokenizer with one change per token
+ * @param n Receives the number of changes
+ * @returns The changes, to be freed by the caller, or NULL on error
+ */
+long* parse_changes(tok_t* tok, size_t* n);
+
+/**
+ * Ways to find the first repeated frequency
+ */
+typedef enum rep_mode{
+  REP_AUTO,        ///< The fastest one, currently the closed form
+  REP_SIMULATE,    ///< Apply the changes until a frequency repeats
+  REP_CLOSED_FORM, ///< Compute it from the frequencies of one cycle
+} rep_mode_t;
+
+/**
+ * Default memory budget for the bitmap of simulate_repetition
+ */
+#define REP_DEFAULT_BUDGET (16u << 20)
+
+/**
+ * @brief Selects the algorithm used by first_repetition
+ */
+void set_repetition_mode(rep_mode_t mode);
+
+/**
+ * @brief Sets the memory budget for the bitmap of simulate_repetition
+ *
+ * @param bytes The largest bitmap to use, 0 always uses the hash set
+ */
+void set_repetition_budget(size_t bytes);
+
+/**
+ * @brief Finds the first frequency reached twice
+ *
+ * Applies the @e n @e changes over and over, starting at 0, until a
+ * frequency is reached the second time, using the algorithm selected
+ * with set_repetition_mode.
+ *
+ * @param changes The frequency changes
+ * @param n The number of changes
+ * @param freq Receives the first repeated frequency
+ * @returns 0 on success, -1 on error
+ */
+int first_repetition(const long* changes, size_t n, long* freq);
+
+/**
+ * @brief first_repetition by applying the changes one after the other
+ *
+ * Takes time in the number of steps until the repetition. The
+ * frequencies seen are remembered in a bitmap over all frequencies
+ * which can be reached before the first repetition, if that fits the
+ * budget set with set_repetition_budget, else in a hash set. Sets an
+ * AOC_ERR_NOTFOUND error if the frequencies never repeat.
+ */
+int simulate_repetition(const long* changes, size_t n, long* freq);
+
+/**
+ * @brief first_repetition computed from a single cycle
+ *
+ * Takes O(n log n) time and O(n) memory, however many cycles it takes
+ * until the repetition. Falls back to simulate_repetition if the
+ * changes add up to 0, then the frequencies repeat within two cycles.
+ * Sets an AOC_ERR_NOTFOUND error if the frequencies never repeat.
+ */
+int closed_form_repetition(const long* changes, size_t n, long* freq);
@@ -6,6 +6,117 @@
 #include "chronal_calibration.h"
 #include "main.h"
 
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* rep_modes[] = {
+  [REP_AUTO] = "auto",
+  [REP_SIMULATE] = "simulate",
+  [REP_CLOSED_FORM] = "closed",
+};
+
+/**
+ * Parses @e s as a memory budget in bytes, with an optional K, M or G
+ * suffix. Returns 0 on success.
+ */
+static int parse_budget(const char* s, size_t* bytes){
+  char* end;
+  errno = 0;
+  unsigned long long val = strtoull(s, &end, 10);
+  if(errno != 0 || end == s || *s == '-'){
+    return -1;
+  }
+  unsigned shift = 0;
+  switch(*end){
+  case 'K':
+    shift = 10;
+    break;
+  case 'M':
+    shift = 20;
+    break;
+  case 'G':
+    shift = 30;
+    break;
+  case '\0':
+    break;
+  default:
+    return -1;
+  }
+  if(shift > 0 && *++end != '\0'){
+    return -1;
+  }
+  if(val > SIZE_MAX >> shift){
+    return -1;
+  }
+  *bytes = (size_t) val << shift;
+  return 0;
+}
+
+/**
+ * Consumes the day's own options in front of the runner's. Returns the
+ * number of arguments consumed or -1 on error.
+ */
+static int parse_day_opts(int argc, char** argv){
+  int argi = 1;
+  while(argi + 1 < argc){
+    if(strcmp(argv[argi], "--rep-mode") == 0){
+      size_t mode = 0;
+      for(; mode < sizeof(rep_modes)/sizeof(rep_modes[0]); mode++){
+        if(strcmp(argv[argi+1], rep_modes[mode]) == 0){
+          break;
+        }
+      }
+      if(mode == sizeof(rep_modes)/sizeof(rep_modes[0])){
+        fprintf(stderr, "\"%s\" is an invalid repetition mode. "
+                "Choose auto, simulate or closed.\n", argv[argi+1]);
+        return -1;
+      }
+      set_repetition_mode(mode);
+    }
+    else if(strcmp(argv[argi], "--rep-budget") == 0){
+      size_t bytes;
+      if(parse_budget(argv[argi+1], &bytes) != 0){
+        fprintf(stderr, "\"%s\" is an invalid memory budget.\n",
+                argv[argi+1]);
+        return -1;
+      }
+      set_repetition_budget(bytes);
+    }
+    else if(strcmp(argv[argi], "--scan-threads") == 0){
+      char* end;
+      errno = 0;
+      unsigned long threads = strtoul(argv[argi+1], &end, 10);
+      if(errno != 0 || end == argv[argi+1] || *end != '\0'
+         || *argv[argi+1] == '-' || threads > SCAN_MAX_THREADS){
+        fprintf(stderr, "\"%s\" is an invalid number of threads.\n",
+                argv[argi+1]);
+        return -1;
+      }
+      set_scan_threads(threads);
+    }
+    else{
+      break;
+    }
+    argi += 2;
+  }
+  return argi - 1;
+}
+
 int main(int argc, char** argv){
-  return aoc_main(argc, argv, compute_freq, get_first_repetition);
+  int consumed = parse_day_opts(argc, argv);
+  if(consumed < 0){
+    return EXIT_FAILURE;
+  }
+  // The runner sees the program name followed by its own arguments
+  argv[consumed] = argv[0];
+  aoc_day_t day = {
+    .part1 = compute_freq,
+    .part2 = get_first_repetition,
+    .raw1 = compute_freq_raw,
+    .raw2 = get_first_repetition_raw,
+  };
+  return aoc_run(argc - consumed, argv + consumed, &day);
 }
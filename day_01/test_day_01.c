@@ -4,9 +4,13 @@
  */
 
 #include "chronal_calibration.h"
+#include "aoc_err.h"
 #include <unity.h>
 
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void test_single_entry(void){
   char input[] = "+1\n";
@@ -98,6 +102,435 @@ void test_part2_aoc_example_4(void){
   free(res);
 }
 
+void test_part1_invalid_change_sets_error(void){
+  char input[] = "+1\nfoo\n";
+  tok_t* tok = get_tokenizer(input, "\n");
+  char* res = compute_freq(tok);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Invalid frequency change \"foo\".",err);
+  free(err);
+  free_tok(tok);
+}
+
+void test_part1_raw_matches_tokenizer(void){
+  srand(2024);
+  char input[4096];
+  for(int round = 0; round < 200; round++){
+    char* p = input;
+    for(int i = rand() % 300; i >= 0; i--){
+      p += sprintf(p, "%+d\n", rand() % 2000001 - 1000000);
+    }
+    // With and without the last newline
+    p -= rand() % 2;
+    *p = '\0';
+    char* raw = compute_freq_raw(input, p - input);
+    tok_t* tok = get_tokenizer(input, "\n");
+    char* res = compute_freq(tok);
+    TEST_ASSERT_EQUAL_STRING(res, raw);
+    free_tok(tok);
+    free(res);
+    free(raw);
+  }
+}
+
+void test_part1_raw_invalid_change_sets_error(void){
+  char input[] = "+1\nfoo\n+2\n";
+  char* res = compute_freq_raw(input, sizeof(input) - 1);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Invalid frequency change \"foo\".",err);
+  free(err);
+}
+
+void test_part1_raw_overflow_sets_error(void){
+  char input[] = "+9223372036854775807\n+1\n";
+  char* res = compute_freq_raw(input, sizeof(input) - 1);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Error parsing frequency numbers\n"
+                           "Numerical result out of range",err);
+  free(err);
+}
+
+void test_part2_overflowing_change_sets_error(void){
+  char input[] = "+1\n-99999999999999999999\n";
+  tok_t* tok = get_tokenizer(input, "\n");
+  char* res = get_first_repetition(tok);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Error parsing frequency numbers\n"
+                           "Numerical result out of range",err);
+  free(err);
+  free_tok(tok);
+}
+
+void test_part2_parses_changes_once(void){
+  char input[] = "+7\n+7\n-2\n-7\n-4";
+  tok_t* tok = get_tokenizer(input, "\n");
+  size_t n;
+  long* changes = parse_changes(tok, &n);
+  long exp[] = {7, 7, -2, -7, -4};
+  TEST_ASSERT_EQUAL_size_t(5, n);
+  TEST_ASSERT_EQUAL_MEMORY(exp, changes, sizeof(exp));
+  long freq;
+  TEST_ASSERT_EQUAL_INT(0, first_repetition(changes, n, &freq));
+  TEST_ASSERT_EQUAL_INT64(14, freq);
+  free(changes);
+  free_tok(tok);
+}
+
+void test_part2_many_cycles(void){
+  // Drifts by one per cycle, repeats 10000 only after 9999 cycles
+  long changes[] = {10000, -9999};
+  long freq;
+  TEST_ASSERT_EQUAL_INT(0, first_repetition(changes, 2, &freq));
+  TEST_ASSERT_EQUAL_INT64(10000, freq);
+}
+
+void test_part2_no_changes_sets_error(void){
+  long freq;
+  TEST_ASSERT_EQUAL_INT(-1, first_repetition(NULL, 0, &freq));
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("No frequency changes.",err);
+  free(err);
+}
+
+/**
+ * The AoC examples as change arrays, with their first repetition
+ */
+static const struct{
+  long changes[5];
+  size_t n;
+  long exp;
+} examples[] = {
+  {{1, -1}, 2, 0},
+  {{3, 3, 4, -2, -4}, 5, 10},
+  {{-6, 3, 8, 5, -6}, 5, 5},
+  {{7, 7, -2, -7, -4}, 5, 14},
+  {{1, -2, 3, 1}, 4, 2},
+};
+
+void test_part2_both_modes_solve_examples(void){
+  for(size_t i = 0; i < sizeof(examples)/sizeof(examples[0]); i++){
+    long freq = -1;
+    TEST_ASSERT_EQUAL_INT(0, simulate_repetition(examples[i].changes,
+                                                 examples[i].n, &freq));
+    TEST_ASSERT_EQUAL_INT64(examples[i].exp, freq);
+    freq = -1;
+    TEST_ASSERT_EQUAL_INT(0, closed_form_repetition(examples[i].changes,
+                                                    examples[i].n, &freq));
+    TEST_ASSERT_EQUAL_INT64(examples[i].exp, freq);
+  }
+}
+
+void test_part2_closed_form_matches_simulation(void){
+  srand(2018);
+  long changes[40];
+  int compared = 0;
+  for(int round = 0; round < 2000; round++){
+    size_t n = 1 + rand() % 40;
+    for(size_t i = 0; i < n; i++){
+      changes[i] = rand() % 41 - 20;
+    }
+    long closed;
+    int closed_ret = closed_form_repetition(changes, n, &closed);
+    // Both detectors of the simulation, the bitmap and the hash set
+    size_t budgets[] = {REP_DEFAULT_BUDGET, 0};
+    for(size_t b = 0; b < 2; b++){
+      set_repetition_budget(budgets[b]);
+      long simulated;
+      TEST_ASSERT_EQUAL_INT(closed_ret, simulate_repetition(changes, n, &simulated));
+      if(closed_ret == 0){
+        TEST_ASSERT_EQUAL_INT64(closed, simulated);
+      }
+    }
+    set_repetition_budget(REP_DEFAULT_BUDGET);
+    if(closed_ret != 0){
+      // Never repeats
+      free(get_latest_aoc_err_msg());
+      continue;
+    }
+    compared++;
+  }
+  // Most random inputs do repeat
+  TEST_ASSERT_GREATER_THAN(1000, compared);
+}
+
+void test_part2_simulation_never_repeats_sets_error(void){
+  long rising[] = {2, 1};
+  long falling[] = {-5, 3, -2};
+  long freq;
+  size_t budgets[] = {REP_DEFAULT_BUDGET, 0};
+  for(size_t b = 0; b < 2; b++){
+    set_repetition_budget(budgets[b]);
+    TEST_ASSERT_EQUAL_INT(-1, simulate_repetition(rising, 2, &freq));
+    char* err = get_latest_aoc_err_msg();
+    TEST_ASSERT_EQUAL_STRING("The frequencies never repeat.",err);
+    free(err);
+    TEST_ASSERT_EQUAL_INT(-1, simulate_repetition(falling, 3, &freq));
+    err = get_latest_aoc_err_msg();
+    TEST_ASSERT_EQUAL_STRING("The frequencies never repeat.",err);
+    free(err);
+  }
+  set_repetition_budget(REP_DEFAULT_BUDGET);
+}
+
+void test_part2_bitmap_at_range_limits(void){
+  // Frequencies right at the ends of a long, too wide for any bitmap
+  long changes[] = {LONG_MAX, LONG_MIN + 1, -1, 1};
+  long freq;
+  TEST_ASSERT_EQUAL_INT(0, simulate_repetition(changes, 4, &freq));
+  TEST_ASSERT_EQUAL_INT64(0, freq);
+  // 2001 frequencies can be reached, a bitmap of 256 bytes
+  long wide[] = {1000, -999};
+  for(size_t budget = 254; budget <= 258; budget++){
+    set_repetition_budget(budget);
+    TEST_ASSERT_EQUAL_INT(0, simulate_repetition(wide, 2, &freq));
+    TEST_ASSERT_EQUAL_INT64(1000, freq);
+  }
+  set_repetition_budget(REP_DEFAULT_BUDGET);
+}
+
+void test_part2_closed_form_many_cycles(void){
+  // Drifts by one per cycle, repeats only after a billion cycles
+  long changes[] = {1000000000, -999999999};
+  long freq;
+  TEST_ASSERT_EQUAL_INT(0, closed_form_repetition(changes, 2, &freq));
+  TEST_ASSERT_EQUAL_INT64(1000000000, freq);
+  long falling[] = {-1000000000, 999999999};
+  TEST_ASSERT_EQUAL_INT(0, closed_form_repetition(falling, 2, &freq));
+  TEST_ASSERT_EQUAL_INT64(-1000000000, freq);
+}
+
+void test_part2_closed_form_never_repeats_sets_error(void){
+  long changes[] = {2, 1};
+  long freq;
+  TEST_ASSERT_EQUAL_INT(-1, closed_form_repetition(changes, 2, &freq));
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("The frequencies never repeat.",err);
+  free(err);
+}
+
+void test_part2_closed_form_extreme_frequencies(void){
+  // Mirrored for the negative drift, LONG_MIN is reached after 2^63 cycles
+  long falling[] = {LONG_MIN, LONG_MAX};
+  long freq;
+  TEST_ASSERT_EQUAL_INT(0, closed_form_repetition(falling, 2, &freq));
+  TEST_ASSERT_EQUAL_INT64(LONG_MIN, freq);
+  long rising[] = {LONG_MAX, 1 - LONG_MAX};
+  TEST_ASSERT_EQUAL_INT(0, closed_form_repetition(rising, 2, &freq));
+  TEST_ASSERT_EQUAL_INT64(LONG_MAX, freq);
+  // Residues of a drift beyond LONG_MAX/2
+  long wide[] = {LONG_MAX - 1, 1};
+  TEST_ASSERT_EQUAL_INT(-1, closed_form_repetition(wide, 2, &freq));
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("The frequencies never repeat.",err);
+  free(err);
+}
+
+void test_part2_closed_form_drift_out_of_range_sets_error(void){
+  long changes[] = {LONG_MIN};
+  long freq;
+  TEST_ASSERT_EQUAL_INT(-1, closed_form_repetition(changes, 1, &freq));
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("The frequencies drift by -9223372036854775808 "
+                           "per cycle, which is out of range.",err);
+  free(err);
+}
+
+void test_part2_selected_mode_used(void){
+  char input[] = "+7\n+7\n-2\n-7\n-4";
+  tok_t* tok = get_tokenizer(input, "\n");
+  set_repetition_mode(REP_SIMULATE);
+  char* res = get_first_repetition(tok);
+  TEST_ASSERT_EQUAL_STRING("14",res);
+  free(res);
+  reset_tok(tok);
+  set_repetition_mode(REP_CLOSED_FORM);
+  res = get_first_repetition(tok);
+  TEST_ASSERT_EQUAL_STRING("14",res);
+  free(res);
+  set_repetition_mode(REP_AUTO);
+  free_tok(tok);
+}
+
+void test_part2_simulate_overflow_in_first_cycle_sets_error(void){
+  char input[] = "+9223372036854775807\n+1\n-5";
+  tok_t* tok = get_tokenizer(input, "\n");
+  set_repetition_mode(REP_SIMULATE);
+  char* res = get_first_repetition(tok);
+  set_repetition_mode(REP_AUTO);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Error parsing frequency numbers\n"
+                           "Numerical result out of range",err);
+  free(err);
+  free_tok(tok);
+}
+
+void test_part2_simulate_frequencies_past_long_set_error(void){
+  // Reaches LONG_MAX in the fourth cycle, before the bounds prove that
+  // nothing repeats
+  long changes[] = {5000000000000000000l, -3000000000000000000l};
+  long freq;
+  TEST_ASSERT_EQUAL_INT(-1, simulate_repetition(changes, 2, &freq));
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("The frequencies leave the values of a long "
+                           "before repeating.",err);
+  free(err);
+}
+
+void test_part2_simulate_overflow_beyond_bounds_never_repeats(void){
+  // The bounds are [-1, 6200000000000000001], the second cycle leaves
+  // them by overflowing from 6199999999999999999
+  long changes[] = {-1l, 3100000000000000001l, 3100000000000000000l};
+  long freq;
+  TEST_ASSERT_EQUAL_INT(-1, simulate_repetition(changes, 3, &freq));
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("The frequencies never repeat.",err);
+  free(err);
+}
+
+void test_prefix_sums_any_threads(void){
+  srand(2025);
+  long changes[1000];
+  long exp[1000];
+  long exp_total = 0;
+  for(size_t i = 0; i < 1000; i++){
+    changes[i] = rand() % 2001 - 1000;
+    exp[i] = exp_total;
+    exp_total += changes[i];
+  }
+  for(unsigned threads = 0; threads <= 7; threads++){
+    set_scan_threads(threads);
+    for(size_t n = 1; n <= 1000; n += 333){
+      long sums[1000];
+      long total;
+      TEST_ASSERT_EQUAL_INT(0, prefix_sums(changes, n, sums, &total));
+      TEST_ASSERT_EQUAL_MEMORY(exp, sums, n*sizeof(long));
+      TEST_ASSERT_EQUAL_INT64(n == 1000 ? exp_total : exp[n], total);
+    }
+  }
+  set_scan_threads(0);
+}
+
+static void assert_same_result(char* exp, char* res){
+  if(exp == NULL){
+    TEST_ASSERT_NULL(res);
+  }
+  else{
+    TEST_ASSERT_EQUAL_STRING(exp, res);
+  }
+  free(exp);
+  free(res);
+}
+
+void test_raw_parts_match_tokenizer_any_threads(void){
+  srand(2025);
+  char input[4096];
+  for(int round = 0; round < 100; round++){
+    char* p = input;
+    for(int i = rand() % 300; i >= 0; i--){
+      // Some empty lines, which the tokenizer skips as well
+      p += sprintf(p, rand() % 10 ? "%+d\n" : "%+d\n\n",
+                   rand() % 201 - 100);
+    }
+    p -= rand() % 2;
+    *p = '\0';
+    tok_t* tok = get_tokenizer(input, "\n");
+    char* exp1 = compute_freq(tok);
+    reset_tok(tok);
+    char* exp2 = get_first_repetition(tok);
+    free_tok(tok);
+    for(unsigned threads = 1; threads <= 4; threads++){
+      set_scan_threads(threads);
+      char* res1 = compute_freq_raw(input, p - input);
+      TEST_ASSERT_EQUAL_STRING(exp1, res1);
+      free(res1);
+      char* exp = exp2 == NULL ? NULL : strdup(exp2);
+      assert_same_result(exp, get_first_repetition_raw(input, p - input));
+    }
+    free(exp1);
+    free(exp2);
+  }
+  set_scan_threads(0);
+}
+
+void test_part2_raw_first_invalid_shard_reported(void){
+  char input[] = "+1\n+2\nfoo\n+3\n+4\nbar\n+5\n";
+  set_scan_threads(4);
+  char* res = get_first_repetition_raw(input, sizeof(input) - 1);
+  set_scan_threads(0);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Invalid frequency change \"foo\".",err);
+  free(err);
+}
+
+void test_part2_raw_overflow_across_shards_sets_error(void){
+  char input[] = "+9223372036854775807\n+1\n";
+  set_scan_threads(2);
+  char* res = get_first_repetition_raw(input, sizeof(input) - 1);
+  set_scan_threads(0);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Error parsing frequency numbers\n"
+                           "Numerical result out of range",err);
+  free(err);
+}
+
+void test_part2_overflow_across_shards_sets_error(void){
+  char input[] = "+9223372036854775807\n+1\n";
+  tok_t* tok = get_tokenizer(input, "\n");
+  set_scan_threads(2);
+  char* res = get_first_repetition(tok);
+  set_scan_threads(0);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Error parsing frequency numbers\n"
+                           "Numerical result out of range",err);
+  free(err);
+  free_tok(tok);
+}
+
+void test_prefix_sums_overflow_within_shard_sets_error(void){
+  // Sums up to LONG_MAX - 1, but passes LONG_MAX + 1 on the way
+  long changes[] = {LONG_MAX, 1, -2};
+  for(unsigned threads = 1; threads <= 3; threads++){
+    set_scan_threads(threads);
+    long sums[3];
+    long total;
+    TEST_ASSERT_EQUAL_INT(-1, prefix_sums(changes, 3, sums, &total));
+    char* err = get_latest_aoc_err_msg();
+    TEST_ASSERT_EQUAL_STRING("Error parsing frequency numbers\n"
+                             "Numerical result out of range",err);
+    free(err);
+  }
+  set_scan_threads(0);
+}
+
+void test_part2_raw_overflow_within_shard_sets_error(void){
+  char input[] = "+9223372036854775807\n+1\n-2\n";
+  set_scan_threads(2);
+  char* res = get_first_repetition_raw(input, sizeof(input) - 1);
+  set_scan_threads(0);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Error parsing frequency numbers\n"
+                           "Numerical result out of range",err);
+  free(err);
+}
+
+void test_part2_raw_no_changes_sets_error(void){
+  char input[] = "\n\n";
+  char* res = get_first_repetition_raw(input, sizeof(input) - 1);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("No frequency changes.",err);
+  free(err);
+}
+
 int main(void){
   UNITY_BEGIN();
   RUN_TEST(test_single_entry);
@@ -110,5 +543,33 @@ int main(void){
   RUN_TEST(test_part2_aoc_example_2);
   RUN_TEST(test_part2_aoc_example_3);
   RUN_TEST(test_part2_aoc_example_4);
-  UNITY_END();
+  RUN_TEST(test_part1_invalid_change_sets_error);
+  RUN_TEST(test_part1_raw_matches_tokenizer);
+  RUN_TEST(test_part1_raw_invalid_change_sets_error);
+  RUN_TEST(test_part1_raw_overflow_sets_error);
+  RUN_TEST(test_part2_overflowing_change_sets_error);
+  RUN_TEST(test_part2_parses_changes_once);
+  RUN_TEST(test_part2_many_cycles);
+  RUN_TEST(test_part2_no_changes_sets_error);
+  RUN_TEST(test_part2_both_modes_solve_examples);
+  RUN_TEST(test_part2_closed_form_matches_simulation);
+  RUN_TEST(test_part2_closed_form_many_cycles);
+  RUN_TEST(test_part2_simulation_never_repeats_sets_error);
+  RUN_TEST(test_part2_bitmap_at_range_limits);
+  RUN_TEST(test_part2_closed_form_never_repeats_sets_error);
+  RUN_TEST(test_part2_closed_form_extreme_frequencies);
+  RUN_TEST(test_part2_closed_form_drift_out_of_range_sets_error);
+  RUN_TEST(test_part2_selected_mode_used);
+  RUN_TEST(test_part2_simulate_overflow_in_first_cycle_sets_error);
+  RUN_TEST(test_part2_simulate_frequencies_past_long_set_error);
+  RUN_TEST(test_part2_simulate_overflow_beyond_bounds_never_repeats);
+  RUN_TEST(test_prefix_sums_any_threads);
+  RUN_TEST(test_raw_parts_match_tokenizer_any_threads);
+  RUN_TEST(test_part2_raw_first_invalid_shard_reported);
+  RUN_TEST(test_part2_raw_overflow_across_shards_sets_error);
+  RUN_TEST(test_part2_raw_no_changes_sets_error);
+  RUN_TEST(test_part2_overflow_across_shards_sets_error);
+  RUN_TEST(test_prefix_sums_overflow_within_shard_sets_error);
+  RUN_TEST(test_part2_raw_overflow_within_shard_sets_error);
+  return UNITY_END();
 }
@@ -9,5 +9,6 @@
 #include <stddef.h>
 
 int main(int argc, char** argv){
-  return aoc_main(argc, argv, box_checksum, similar_id);
+  return aoc_main_streaming(argc, argv, box_checksum, similar_id,
+                            AOC_STREAM_PART1);
 }
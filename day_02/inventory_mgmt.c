@@ -15,11 +15,7 @@
 
 char* box_checksum(tok_t* tok){
   if(tok == NULL){
-    set_aoc_err_msg("Tokenizer is NULL.", 0);
-    return NULL;
-  }
-  if(tok_count(tok) == 0){
-    set_aoc_err_msg("Tokenizer is empty.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is NULL.");
     return NULL;
   }
   unsigned doubles = 0;
@@ -28,15 +24,15 @@ char* box_checksum(tok_t* tok){
   char* id;
   bool saw_triple;
   bool saw_double;
+  bool saw_id = false;
   while((id = n_tok(tok)) != NULL){
+    saw_id = true;
     memset(counts,'\0',sizeof(unsigned)*26);
     saw_triple = false;
     saw_double = false;
     for(char* c = id; *c != '\0'; c++){
       if(((int) *c) < 97 || ((int) *c) > 122){
-        char buff[64];
-        snprintf(buff, 64, "Invalid char \"%c\" in \"%s\".", *c, id);
-        set_aoc_err_msg(buff, 0 );
+        AOC_ERR(AOC_ERR_PARSE, 0, "Invalid char \"%c\" in \"%s\".", *c, id);
         return NULL;
       }
       counts[((int)*c)-97]++;
@@ -52,6 +48,12 @@ char* box_checksum(tok_t* tok){
       }
     }
   }
+  if(!saw_id){
+    // Streaming tokenizers can't tell they're empty up front, so this
+    // is checked here instead of with tok_count
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is empty.");
+    return NULL;
+  }
   unsigned checksum = doubles * triples;
   unsigned n = checksum;
   unsigned count = 0;
@@ -64,12 +66,13 @@ char* box_checksum(tok_t* tok){
   return out;
 }
 
-bool s_comp(char* s1, char* s2, size_t* diff_index){
-  if(strlen(s1) != strlen(s2)){
+bool s_comp(const char* s1, size_t len1, const char* s2, size_t len2,
+            size_t* diff_index){
+  if(len1 != len2){
     return false;
   }
   int numdiff = 0;
-  for(size_t i = 0; i<strlen(s1) && numdiff<2; i++){
+  for(size_t i = 0; i<len1 && numdiff<2; i++){
     if(s1[i] != s2[i]){
       numdiff++;
       *diff_index = i;
@@ -80,39 +83,39 @@ bool s_comp(char* s1, char* s2, size_t* diff_index){
 
 char* similar_id(tok_t* tok){
   if(tok == NULL){
-    set_aoc_err_msg("Tokenizer is NULL.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is NULL.");
     return NULL;
   }
   if(tok_count(tok) == 0){
-    set_aoc_err_msg("Tokenizer is empty.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is empty.");
     return NULL;
   }
   int num_toks = tok_count(tok);
-  char** s_tab = malloc(sizeof(char*)*num_toks);
-  char* curr;
-  char** counter = s_tab;
-  while((curr = n_tok(tok)) != NULL){
-    *(counter++) = curr;
-  }
-  char* res_id = NULL;
+  int res_index = -1;
   size_t diff_index;
-  for(int outer = 0; outer<num_toks && res_id == NULL; outer++){
+  for(int outer = 0; outer<num_toks && res_index == -1; outer++){
+    const char* s_outer = tok_view(tok, outer);
+    size_t len_outer = tok_len(tok, outer);
     for(int inner = outer+1; inner<num_toks; inner++){
-      if(s_comp(s_tab[outer], s_tab[inner], &diff_index)){
-        res_id = s_tab[outer];
+      if(s_comp(s_outer, len_outer, tok_view(tok, inner), tok_len(tok, inner),
+                &diff_index)){
+        res_index = outer;
         break;
       }
     }
   }
-  free(s_tab);
   char* out = NULL;
-  if(res_id != NULL){
-    out = malloc(strlen(res_id));
+  if(res_index != -1){
+    // The IDs are views into the input, not null terminated
+    const char* res_id = tok_view(tok, res_index);
+    size_t res_len = tok_len(tok, res_index);
+    out = malloc(res_len);
     memcpy(out, res_id, diff_index);
-    memcpy(out+diff_index, res_id+diff_index+1,strlen(res_id)-diff_index);
+    memcpy(out+diff_index, res_id+diff_index+1, res_len-diff_index-1);
+    out[res_len-1] = '\0';
   }
   else{
-    set_aoc_err_msg("No Match Found.", 0);
+    AOC_ERR(AOC_ERR_NOTFOUND, 0, "No Match Found.");
   }
   return out;
 }
@@ -9,8 +9,11 @@
 #include <unity.h>
 
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 
+#include <unistd.h>
+
 void test_part1_tok_null_returns_null(void){
   char* res = box_checksum(NULL);
   TEST_ASSERT_NULL(res);
@@ -30,6 +33,39 @@ void test_part1_empty_tok_returns_null(void){
   free_tok(tok);
 }
 
+/**
+ * Runs box_checksum on a streaming tokenizer over a file with @e content
+ */
+static char* checksum_streamed(const char* content){
+  char fpath[] = "/tmp/day_02_ut_XXXXXX";
+  int fd = mkstemp(fpath);
+  TEST_ASSERT_NOT_EQUAL(-1, fd);
+  FILE* f = fdopen(fd, "w");
+  fputs(content, f);
+  fclose(f);
+  tok_t* tok = get_stream_tokenizer(fpath, "\n");
+  TEST_ASSERT_NOT_NULL(tok);
+  char* res = box_checksum(tok);
+  free_tok(tok);
+  unlink(fpath);
+  return res;
+}
+
+void test_part1_streamed_aoc_example(void){
+  char* res = checksum_streamed("abcdef\nbababc\nabbcde\nabcccd\naabcdd\n"
+                                "abcdee\nababab\n");
+  TEST_ASSERT_EQUAL_STRING("12",res);
+  free(res);
+}
+
+void test_part1_streamed_empty_returns_null(void){
+  char* res = checksum_streamed("\n");
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Tokenizer is empty.", err);
+  free(err);
+}
+
 void test_part1_triples_not_counted_as_doubles(void){
   char in[] = "abcbb\nabgtrt";
   tok_t* tok = get_tokenizer(in, "\n");
@@ -156,6 +192,8 @@ int main(void){
   UNITY_BEGIN();
   RUN_TEST(test_part1_tok_null_returns_null);
   RUN_TEST(test_part1_empty_tok_returns_null);
+  RUN_TEST(test_part1_streamed_aoc_example);
+  RUN_TEST(test_part1_streamed_empty_returns_null);
   RUN_TEST(test_part1_triples_not_counted_as_doubles);
   RUN_TEST(test_part1_multiple_doubles_in_id_counted_only_once);
   RUN_TEST(test_part1_multiple_triples_in_id_counted_only_once);
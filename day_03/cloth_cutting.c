@@ -6,67 +6,136 @@
 #include "cloth_cutting.h"
 
 #include "aoc_err.h"
-#include "dllist.h"
+#include "fastparse.h"
+#include "idxlist.h"
+#include "trace.h"
 
+#include <errno.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-int parse_claim(char* in, claim_t* claim){
-  int res = sscanf(in, "#%u @ %u,%u: %ux%u",
-                   &claim->id,
-                   &claim->startx,
-                   &claim->starty,
-                   &claim->lengthx,
-                   &claim->lengthy
-                   );
-  return res == 5 ? 0 : -1;
+/**
+ * Parses the unsigned number at @e p into @e val, followed by the
+ * literal @e sep. Returns the position behind @e sep or NULL if the
+ * input doesn't match. Passes NULL through, so calls can be chained.
+ */
+static const char* parse_field(const char* p, unsigned* val, const char* sep){
+  uint64_t parsed;
+  if(p == NULL || fp_parse_u64(p, &p, &parsed) != FP_OK || parsed > UINT_MAX){
+    return NULL;
+  }
+  *val = parsed;
+  size_t len = strlen(sep);
+  return strncmp(p, sep, len) == 0 ? p + len : NULL;
+}
+
+int parse_claim(const char* in, claim_t* claim){
+  // The format of "#%u @ %u,%u: %ux%u", with single spaces only
+  if(*in != '#'){
+    return -1;
+  }
+  const char* p = in + 1;
+  p = parse_field(p, &claim->id, " @ ");
+  p = parse_field(p, &claim->startx, ",");
+  p = parse_field(p, &claim->starty, ": ");
+  p = parse_field(p, &claim->lengthx, "x");
+  p = parse_field(p, &claim->lengthy, "");
+  return p == NULL ? -1 : 0;
+}
+
+static int parse_claims_into(tok_t* tok, claim_t* claims){
+  int num_claims = tok_count(tok);
+  for(int i = 0; i<num_claims; i++){
+    // Claims are parsed in place, the number at their end stops at the
+    // delimiter behind them
+    if(parse_claim(tok_view(tok, i), &claims[i]) != 0){
+      AOC_ERR(AOC_ERR_PARSE, 0, "Error while parsing \"%.*s\".",
+              (int) tok_len(tok, i), tok_view(tok, i));
+      return -1;
+    }
+  }
+  return 0;
 }
 
 claim_t* parse_all_claims(tok_t* tok){
   if(tok == NULL){
-    set_aoc_err_msg("Tokenizer is NULL.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is NULL.");
     return NULL;
   }
   claim_t* claims = malloc(sizeof(claim_t)*tok_count(tok));
-  char* curr_in = NULL;
-  claim_t* curr_claim = claims;
-  bool error = false;
-  while((curr_in = n_tok(tok)) != NULL){
-    if(parse_claim(curr_in, curr_claim++) != 0){
-      error = true;
-      break;
-    }
-  }
-  if(error){
-    char errmsg[64];
-    snprintf(errmsg, 64, "Error while parsing \"%s\".", curr_in);
-    set_aoc_err_msg(errmsg, 0);
+  if(parse_claims_into(tok, claims) != 0){
     free(claims);
     return NULL;
   }
   return claims;
 }
 
-char* cloth_slicing(tok_t* tok){
+claims_t* prepare_claims(tok_t* tok, arena_t* arena){
   if(tok == NULL){
-    set_aoc_err_msg("Tokenizer is NULL.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is NULL.");
     return NULL;
   }
   if(tok_count(tok) == 0){
-    set_aoc_err_msg("Tokenizer is empty.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is empty.");
     return NULL;
   }
-  int num_claims = tok_count(tok);
-  claim_t* claims = parse_all_claims(tok);
-  if(claims == NULL){
+  claims_t* claims = arena_alloc(arena, sizeof(claims_t));
+  claim_t* parsed = arena_alloc(arena, sizeof(claim_t)*tok_count(tok));
+  if(claims == NULL || parsed == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for %d claims.", tok_count(tok));
     return NULL;
   }
-  unsigned* cloth = malloc(1000*1000*sizeof(unsigned));
-  memset(cloth,0,1000*1000*sizeof(unsigned));
-  claim_t* curr = claims;
+  TRACE_BEGIN("parse claims");
+  int parsed_ok = parse_claims_into(tok, parsed);
+  TRACE_END();
+  if(parsed_ok != 0){
+    return NULL;
+  }
+  claims->num_claims = tok_count(tok);
+  claims->claims = parsed;
+  return claims;
+}
+
+/**
+ * Runs @e part on the claims of @e tok, with an arena of its own for
+ * the call. The result is copied to the heap.
+ */
+static char* run_on_claims(tok_t* tok,
+                           char* (*part)(const claims_t*, arena_t*)){
+  arena_t* arena = arena_create(0);
+  if(arena == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Could not create an arena.");
+    return NULL;
+  }
+  char* res = NULL;
+  claims_t* claims = prepare_claims(tok, arena);
+  if(claims != NULL){
+    char* arena_res = part(claims, arena);
+    res = arena_res == NULL ? NULL : strdup(arena_res);
+  }
+  arena_destroy(arena);
+  return res;
+}
+
+char* cloth_slicing(tok_t* tok){
+  TRACE_SCOPE("cloth_slicing");
+  return run_on_claims(tok, count_overlaps);
+}
+
+char* count_overlaps(const claims_t* claims, arena_t* arena){
+  int num_claims = claims->num_claims;
+  unsigned* cloth = arena_calloc(arena, 1000*1000, sizeof(unsigned));
+  if(cloth == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for the cloth.");
+    return NULL;
+  }
+  TRACE_BEGIN("fill grid");
+  const claim_t* curr = claims->claims;
   for(int i = 0; i<num_claims; i++){
     for(unsigned x = curr->startx*1000; x<curr->startx*1000+curr->lengthx*1000;
         x+=1000){
@@ -76,23 +145,16 @@ char* cloth_slicing(tok_t* tok){
     }
     curr++;
   }
-  free(claims);
+  TRACE_END();
+  TRACE_BEGIN("count overlaps");
   unsigned overlaps = 0;
   for(unsigned i = 0; i<1000*1000; i++){
     if(cloth[i]>1){
       overlaps++;
     }
   }
-  unsigned temp = overlaps;
-  unsigned count = 0;
-  while(temp != 0){
-    temp /= 10u;
-    count++;
-  }
-  char* res = malloc(count+2);
-  snprintf(res,count+2, "%u",overlaps);
-  free(cloth);
-  return res;
+  TRACE_END();
+  return arena_sprintf(arena, "%u", overlaps);
 }
 
 bool intersect(claim_t* a, claim_t* b){
@@ -105,13 +167,6 @@ bool intersect(claim_t* a, claim_t* b){
   return true;
 }
 
-struct bidir{
-  node_t* candidate;
-  claim_t* claim;
-};
-
-typedef struct bidir bidir_t;
-
 /**
  * Alright. Lets admit up front that this is not how this was supposed
  * to look. My initial idea was: Okay, lets just reuse Part 1, after
@@ -145,69 +200,45 @@ typedef struct bidir bidir_t;
  * it also doesn't use the big "cloth" array either.
  *
  */
-char* find_valid_claim(tok_t* tok){
-  if(tok == NULL){
-    set_aoc_err_msg("Tokenizer is NULL.", 0);
-    return NULL;
-  }
-  if(tok_count(tok) == 0){
-    set_aoc_err_msg("Tokenizer is empty.", 0);
-    return NULL;
-  }
-  int num_claims = tok_count(tok);
-  claim_t* claims = parse_all_claims(tok);
-  if(claims == NULL){
+char* valid_claim_id(const claims_t* all_claims, arena_t* arena){
+  uint32_t num_claims = all_claims->num_claims;
+  claim_t* claims = all_claims->claims;
+  // The candidates are linked by their index into claims, so whether the
+  // claim of the inner loop is still a candidate is a lookup by index
+  idx_link_t* links = arena_alloc(arena, num_claims*sizeof(idx_link_t));
+  if(links == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for %u candidates.", num_claims);
     return NULL;
   }
-  dllist_t* candidates = init_list();
-  bidir_t* bidirlist = malloc(num_claims*sizeof(bidir_t));
-  bidir_t* curr_bidir = bidirlist;
-  node_t* curr_candidate;
-  claim_t* curr_claim = claims;
-  for(int i=0; i<num_claims; i++){
-    curr_candidate = append(candidates, curr_claim);
-    curr_bidir->claim = curr_claim;
-    curr_bidir->candidate = curr_candidate;
-    curr_bidir++;
-    curr_claim++;
-  }
-  curr_candidate = head(candidates);
+  idxlist_t candidates;
+  idxlist_init_full(&candidates, links, num_claims);
+  uint32_t curr_candidate = idxlist_head(&candidates);
   bool intersects;
-  while(curr_candidate != NULL){
-    curr_bidir = bidirlist;
+  while(curr_candidate != IDXLIST_NIL){
     intersects = false;
-    for(int i=0; i<num_claims; i++){
-      if(((claim_t*)data(curr_candidate))->id != curr_bidir->claim->id){
-        if(intersect(((claim_t*)data(curr_candidate)), curr_bidir->claim)){
-          if(curr_bidir->candidate != NULL){
-            remove_node(candidates, curr_bidir->candidate);
-            curr_bidir->candidate = NULL;
-          }
-          intersects = true;
-          break;
+    for(uint32_t i=0; i<num_claims; i++){
+      if(i != curr_candidate && intersect(&claims[curr_candidate], &claims[i])){
+        if(idxlist_contains(&candidates, i)){
+          idxlist_remove(&candidates, i);
         }
+        intersects = true;
+        break;
       }
-      curr_bidir++;
     }
     if(intersects){
-      bidirlist[((claim_t*)data(curr_candidate))->id-1].candidate = NULL;
-      curr_candidate = remove_node(candidates, curr_candidate);
+      curr_candidate = idxlist_remove(&candidates, curr_candidate);
     }
     else{
-      curr_candidate = next(curr_candidate);
+      curr_candidate = idxlist_next(&candidates, curr_candidate);
     }
   }
-  free(bidirlist);
-  claim_t* valid_claim = data(head(candidates));
-  free_dllist(candidates);
-  unsigned n = valid_claim->id;
-  unsigned counter = 0;
-  while(n != 0){
-    n /= 10;
-    counter++;
-  }
-  char* res = malloc(counter+2);
-  snprintf(res,counter+2,"%u",valid_claim->id);
-  free(claims);
-  return res;
+  if(idxlist_head(&candidates) == IDXLIST_NIL){
+    AOC_ERR(AOC_ERR_NOTFOUND, 0, "No claim without overlaps.");
+    return NULL;
+  }
+  return arena_sprintf(arena, "%u", claims[idxlist_head(&candidates)].id);
+}
+
+char* find_valid_claim(tok_t* tok){
+  return run_on_claims(tok, valid_claim_id);
 }
@@ -3,6 +3,7 @@
  * @brief AoC 2018 Day 03, Cloth Cutting
  */
 
+#include "arena.h"
 #include "tokenizer.h"
 
 struct claim{
@@ -15,8 +16,23 @@ struct claim{
 
 typedef struct claim claim_t;
 
+/**
+ * All claims of an input, shared by both parts. Allocated from the
+ * arena handed to prepare_claims.
+ */
+typedef struct claims{
+  int num_claims;
+  claim_t* claims;
+} claims_t;
+
 claim_t* parse_all_claims(tok_t* tok);
 
+claims_t* prepare_claims(tok_t* tok, arena_t* arena);
+
 char* cloth_slicing(tok_t* tok);
 
+char* count_overlaps(const claims_t* claims, arena_t* arena);
+
 char* find_valid_claim(tok_t* tok);
+
+char* valid_claim_id(const claims_t* claims, arena_t* arena);
@@ -8,6 +8,25 @@
 
 #include <stddef.h>
 
+static void* prepare(tok_t* tok, arena_t* arena){
+  return prepare_claims(tok, arena);
+}
+
+static char* prepared1(void* claims, arena_t* arena){
+  return count_overlaps(claims, arena);
+}
+
+static char* prepared2(void* claims, arena_t* arena){
+  return valid_claim_id(claims, arena);
+}
+
 int main(int argc, char** argv){
-  return aoc_main(argc, argv, cloth_slicing, find_valid_claim);
+  aoc_day_t day = {
+    .part1 = cloth_slicing,
+    .part2 = find_valid_claim,
+    .prepare = prepare,
+    .prepared1 = prepared1,
+    .prepared2 = prepared2,
+  };
+  return aoc_run(argc, argv, &day);
 }
@@ -180,6 +180,31 @@ void test_part2_overlap_in_middle(void){
   free(res);
 }
 
+void test_part2_all_claims_overlap_sets_error(void){
+  char in[] = "#1 @ 1,1: 2x2\n#2 @ 2,2: 2x2\n";
+  tok_t* tok = get_tokenizer(in, "\n");
+  char* res = find_valid_claim(tok);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("No claim without overlaps.", err);
+  free(err);
+  free_tok(tok);
+}
+
+void test_both_parts_share_prepared_claims(void){
+  char in[] = "#1 @ 1,3: 4x4\n#2 @ 3,1: 4x4\n#3 @ 5,5: 2x2";
+  tok_t* tok = get_tokenizer(in, "\n");
+  arena_t* arena = arena_create(0);
+  claims_t* claims = prepare_claims(tok, arena);
+  TEST_ASSERT_EQUAL_INT(3, claims->num_claims);
+  char* res1 = count_overlaps(claims, arena);
+  char* res2 = valid_claim_id(claims, arena);
+  TEST_ASSERT_EQUAL_STRING("4",res1);
+  TEST_ASSERT_EQUAL_STRING("3",res2);
+  arena_destroy(arena);
+  free_tok(tok);
+}
+
 int main(void){
   UNITY_BEGIN();
   RUN_TEST(test_part1_tok_null_returns_null);
@@ -197,5 +222,7 @@ int main(void){
   RUN_TEST(test_part2_failed_parse_leads_to_abort_and_sets_error_msg);
   RUN_TEST(test_part2_aoc_example);
   RUN_TEST(test_part2_overlap_in_middle);
+  RUN_TEST(test_part2_all_claims_overlap_sets_error);
+  RUN_TEST(test_both_parts_share_prepared_claims);
   return UNITY_END();
 }
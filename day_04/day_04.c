@@ -8,6 +8,25 @@
 
 #include <stddef.h>
 
+static void* prepare(tok_t* tok, arena_t* arena){
+  return analyze_schedule(tok, arena);
+}
+
+static char* prepared1(void* sched, arena_t* arena){
+  return most_asleep_guard_sched(sched, arena);
+}
+
+static char* prepared2(void* sched, arena_t* arena){
+  return most_asleep_minute_sched(sched, arena);
+}
+
 int main(int argc, char** argv){
-  return aoc_main(argc, argv, most_asleep_guard, most_asleep_minute);
+  aoc_day_t day = {
+    .part1 = most_asleep_guard,
+    .part2 = most_asleep_minute,
+    .prepare = prepare,
+    .prepared1 = prepared1,
+    .prepared2 = prepared2,
+  };
+  return aoc_run(argc, argv, &day);
 }
@@ -6,30 +6,93 @@
 #include "repose_record.h"
 
 #include "aoc_err.h"
+#include "fastparse.h"
+#include "hashmap.h"
+#include "trace.h"
 
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
 #include <regex.h>
-#include <search.h>
 #include <string.h>
 
-static regex_t* shiftstart = NULL;
-static regex_t* asleep = NULL;
-static regex_t* wakeup = NULL;
+// Compiled lazily and freed by free_entry_regexes. Every thread has its own, so
+// schedules can be parsed on several threads at once.
+static _Thread_local regex_t* shiftstart = NULL;
+static _Thread_local regex_t* asleep = NULL;
+static _Thread_local regex_t* wakeup = NULL;
+
+/**
+ * Parses the unsigned number at @e p into @e val if it is at most @e max,
+ * followed by the character @e sep. Returns the position behind @e sep
+ * or NULL if the input doesn't match. Passes NULL through.
+ */
+static const char* parse_field(const char* p, int* val, unsigned max, char sep){
+  uint64_t parsed;
+  if(p == NULL || fp_parse_u64(p, &p, &parsed) != FP_OK || parsed > max
+     || *p != sep){
+    return NULL;
+  }
+  *val = parsed;
+  return p + 1;
+}
+
+/**
+ * Day of the week (0 is Sunday) and day of the year of a date in the
+ * Gregorian calendar, as strptime would set them
+ */
+static void set_weekday(struct tm* t){
+  static const int month_start[] = {0, 31, 59, 90, 120, 151, 181, 212, 243,
+                                    273, 304, 334};
+  static const int month_offset[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+  int year = t->tm_year + 1900;
+  bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  t->tm_yday = month_start[t->tm_mon] + t->tm_mday - 1
+    + (leap && t->tm_mon > 1);
+  int y = t->tm_mon < 2 ? year - 1 : year;
+  t->tm_wday = (y + y/4 - y/100 + y/400 + month_offset[t->tm_mon]
+                + t->tm_mday) % 7;
+}
+
+/**
+ * Parses "[%Y-%m-%d %H:%M]" at the start of @e s into @e t. Returns the
+ * position behind it or NULL if @e s doesn't start with a timestamp.
+ */
+static const char* parse_timestamp(const char* s, struct tm* t){
+  if(*s != '['){
+    return NULL;
+  }
+  const char* p = s + 1;
+  int year = 0;
+  int month = 0;
+  p = parse_field(p, &year, 9999, '-');
+  p = parse_field(p, &month, 12, '-');
+  p = parse_field(p, &t->tm_mday, 31, ' ');
+  p = parse_field(p, &t->tm_hour, 23, ':');
+  p = parse_field(p, &t->tm_min, 59, ']');
+  if(p == NULL || month == 0 || t->tm_mday == 0){
+    return NULL;
+  }
+  t->tm_year = year - 1900;
+  t->tm_mon = month - 1;
+  set_weekday(t);
+  return p;
+}
 
 int parse_entry(const char* s, entry_t* en){
   if(s == NULL || en == NULL){
     return -1;
   }
   *en = (entry_t) {0};
-  char* remainder = strptime(s, "[%Y-%m-%d %H:%M]", &en->timestamp);
+  const char* remainder = parse_timestamp(s, &en->timestamp);
   if(remainder == NULL){
-    char errbuff[128];
-    snprintf(errbuff, 128, "Failed to parse time in \"%s\".", s);
-    set_aoc_err_msg(errbuff, 0);
+    AOC_ERR(AOC_ERR_PARSE, 0, "Failed to parse time in \"%s\".", s);
     return -1;
   }
   if(shiftstart == NULL && asleep == NULL && wakeup == NULL){
@@ -43,13 +106,12 @@ int parse_entry(const char* s, entry_t* en){
   }
   if(regexec(shiftstart, remainder, 0, NULL, 0) == 0){
     en->action = START;
-    int res = sscanf(remainder, " Guard #%d begins shift", &en->guardid);
-    if(res != 1){
-      char errbuff[128];
-      snprintf(errbuff, 128, "Failed to parse Guard ID in \"%s\".", s);
-      set_aoc_err_msg(errbuff, 0);
+    uint64_t id;
+    if(fp_parse_all_u64(remainder, NULL, &id, 1) != 1 || id > UINT_MAX){
+      AOC_ERR(AOC_ERR_PARSE, 0, "Failed to parse Guard ID in \"%s\".", s);
       return -1;
     }
+    en->guardid = id;
   }
   else if(regexec(asleep, remainder, 0, NULL, 0) == 0){
     en->action = ASLEEP;
@@ -58,30 +120,24 @@ int parse_entry(const char* s, entry_t* en){
     en->action = AWAKE;
   }
   else{
-    char errbuff[128];
-    snprintf(errbuff, 128, "Failed to match action in \"%s\".", s);
-    set_aoc_err_msg(errbuff, 0);
+    AOC_ERR(AOC_ERR_PARSE, 0, "Failed to match action in \"%s\".", s);
     return -1;
   }
   return 0;
 }
 
-void free_sched(sched_t* schedule){
-  // First, free the compiled regexps
-  regfree(shiftstart);
-  free(shiftstart);
-  shiftstart = NULL;
-  regfree(asleep);
-  free(asleep);
-  asleep = NULL;
-  regfree(wakeup);
-  free(wakeup);
-  wakeup = NULL;
-  if(schedule != NULL){
-    free(schedule->schedule);
-    free(schedule->schedstore);
-    free(schedule->guardids);
-    free(schedule);
+void free_entry_regexes(void){
+  // Unless no entry got that far
+  if(shiftstart != NULL){
+    regfree(shiftstart);
+    free(shiftstart);
+    shiftstart = NULL;
+    regfree(asleep);
+    free(asleep);
+    asleep = NULL;
+    regfree(wakeup);
+    free(wakeup);
+    wakeup = NULL;
   }
 }
 
@@ -101,13 +157,6 @@ int comp_guard_guard_id(const void* first, const void* second){
   return 0;
 }
 
-void tree_destroy(void* node){
-  // Empty because tdestroy needs destory function to apply to nodes,
-  // but our node data is stored in a single array which is destroyed
-  // separately.
-  (void)(node);
-}
-
 int comp_entry_by_time(const void* first, const void* second){
   entry_t* pfirst = *((entry_t**) first);
   entry_t* psecond = *((entry_t**) second);
@@ -144,8 +193,6 @@ int comp_entry_by_time(const void* first, const void* second){
   return 0;
 }
 
-static void* globbuf = NULL;
-
 void set_guard_ids(sched_t* sched){
   unsigned curr_guard;
   for(size_t i = 0; i<sched->entrycount; i++){
@@ -158,76 +205,101 @@ void set_guard_ids(sched_t* sched){
   }
 }
 
-void act_treewalk(const void* nodep, const VISIT which, const int depth){
-  (void)(depth);
-  if(globbuf != NULL
-     && (which == postorder || which == leaf)
-     ){
-    *((unsigned *)globbuf) = **((unsigned**) nodep);
-    globbuf = ((unsigned*) globbuf)+1;
-  }
-}
+HASHSET_DEFINE(idset, unsigned)
 
-sched_t* parse_schedule(tok_t* tok){
+sched_t* parse_schedule(tok_t* tok, arena_t* arena){
+  TRACE_SCOPE("parse_schedule");
   if(tok == NULL){
-    set_aoc_err_msg("Tokenizer is NULL.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is NULL.");
     return NULL;
   }
   if(tok_count(tok) == 0){
-    set_aoc_err_msg("Tokenizer is empty.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is empty.");
+    return NULL;
+  }
+  sched_t* sched = arena_alloc(arena, sizeof(sched_t));
+  if(sched == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for the schedule.");
     return NULL;
   }
-  sched_t* sched = malloc(sizeof(sched_t));
   sched->entrycount = tok_count(tok);
   sched->guardcount = 0u;
-  sched->schedstore = malloc(sched->entrycount*sizeof(entry_t));
-  sched->schedule = malloc(sched->entrycount*sizeof(entry_t*));
-  sched->guardids = NULL;
-  void* guard_ids = NULL;
-  char* curr_entry = NULL;
+  sched->schedstore = arena_alloc(arena, sched->entrycount*sizeof(entry_t));
+  sched->schedule = arena_alloc(arena, sched->entrycount*sizeof(entry_t*));
+  // At most one new guard per entry
+  sched->guardids = arena_alloc(arena, sched->entrycount*sizeof(unsigned));
+  if(sched->schedstore == NULL || sched->schedule == NULL
+     || sched->guardids == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for %u schedule entries.",
+            sched->entrycount);
+    return NULL;
+  }
+  idset_t guard_ids;
+  idset_init(&guard_ids);
   entry_t* curr_store_entry = sched->schedstore;
   entry_t** curr_sched_entry = sched->schedule;
-  while((curr_entry = n_tok(tok)) != NULL){
-    if(parse_entry(curr_entry, curr_store_entry) != 0){
+  for(unsigned i = 0; i < sched->entrycount; i++){
+    // Not tok_view, parse_entry hands the line to regexec
+    const char* line = tok_at(tok, i);
+    if(line == NULL){
+      // Only if copying the tokens failed
+      AOC_ERR(AOC_ERR_SYS, tok_error(tok), "Could not read entry %u.", i);
+      idset_free(&guard_ids);
+      free_entry_regexes();
+      return NULL;
+    }
+    if(parse_entry(line, curr_store_entry) != 0){
       // Parse error, returning
-      if(guard_ids!=NULL){
-        tdestroy(guard_ids,tree_destroy);
-      }
-      free_sched(sched);
+      idset_free(&guard_ids);
+      free_entry_regexes();
       return NULL;
     }
     if(curr_store_entry->action == START){
-      if(tfind(&curr_store_entry->guardid,&guard_ids,comp_entry_guard_id) == NULL){
-        sched->guardcount++;
-        tsearch(&curr_store_entry->guardid,&guard_ids,comp_entry_guard_id);
+      int inserted = idset_insert(&guard_ids, curr_store_entry->guardid);
+      if(inserted < 0){
+        AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for the guard IDs.");
+        idset_free(&guard_ids);
+        free_entry_regexes();
+        return NULL;
+      }
+      if(inserted){
+        sched->guardids[sched->guardcount++] = curr_store_entry->guardid;
       }
     }
     *curr_sched_entry = curr_store_entry;
     curr_store_entry++;
     curr_sched_entry++;
   }
+  free_entry_regexes();
+  TRACE_BEGIN("sort schedule");
   qsort(sched->schedule, sched->entrycount, sizeof(entry_t*), comp_entry_by_time);
-  sched->guardids = malloc(sizeof(unsigned)*sched->guardcount);
-  globbuf = sched->guardids;
-  twalk(guard_ids, act_treewalk);
-  globbuf = NULL;
+  // Sorted for the lookup in analyze_schedule
+  qsort(sched->guardids, sched->guardcount, sizeof(unsigned), comp_entry_guard_id);
+  TRACE_END();
   set_guard_ids(sched);
-  tdestroy(guard_ids,tree_destroy);
+  idset_free(&guard_ids);
   return sched;
 }
 
-analyzed_sched_t* analyze_schedule(tok_t* tok){
+analyzed_sched_t* analyze_schedule(tok_t* tok, arena_t* arena){
+  TRACE_SCOPE("analyze_schedule");
   if(tok == NULL){
-    set_aoc_err_msg("Tokenizer is NULL.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is NULL.");
     return NULL;
   }
-  sched_t* sched = parse_schedule(tok);
+  sched_t* sched = parse_schedule(tok, arena);
   if(sched == NULL){
     return NULL;
   }
-  analyzed_sched_t* res = malloc(sizeof(analyzed_sched_t));
+  analyzed_sched_t* res = arena_alloc(arena, sizeof(analyzed_sched_t));
+  guard_t* guards = arena_alloc(arena, sizeof(guard_t)*sched->guardcount);
+  if(res == NULL || guards == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Out of memory for %u guards.",
+            sched->guardcount);
+    return NULL;
+  }
   res->n_guards = sched->guardcount;
-  res->a_guards = malloc(sizeof(guard_t)*res->n_guards);
+  res->a_guards = guards;
   res->schedule = sched;
   // Init the guards array
   for(size_t i = 0; i < res->n_guards; i++){
@@ -235,6 +307,7 @@ analyzed_sched_t* analyze_schedule(tok_t* tok){
     res->a_guards[i].total_minutes_asleep = 0;
     memset(res->a_guards[i].minutes_asleep, 0, sizeof(unsigned)*60);
   }
+  TRACE_SCOPE("tally sleep");
   guard_t* curr_guard;
   entry_t* curr_entry;
   entry_t* last_asleep = NULL;
@@ -245,11 +318,8 @@ analyzed_sched_t* analyze_schedule(tok_t* tok){
       curr_guard = bsearch(&curr_entry->guardid, res->a_guards, res->n_guards,
                            sizeof(guard_t), comp_guard_guard_id);
       if(curr_guard == NULL){
-        char errbuff[128];
-        snprintf(errbuff, 128, "Could not find guard %u in guards array.",
-                 curr_entry->guardid);
-        free_analyzed_sched(res);
-        set_aoc_err_msg(errbuff, 0);
+        AOC_ERR(AOC_ERR_NOTFOUND, 0, "Could not find guard %u in guards array.",
+                curr_entry->guardid);
         return NULL;
       }
       break;
@@ -258,12 +328,11 @@ analyzed_sched_t* analyze_schedule(tok_t* tok){
         last_asleep = curr_entry;
       }
       else{
-        char errbuff[128];
-        snprintf(errbuff, 128, "Got an ASLEEP on %s without preceding AWAKE since %s.",
-                 asctime(&curr_entry->timestamp),
-                 asctime(&last_asleep->timestamp));
-        free_analyzed_sched(res);
-        set_aoc_err_msg(errbuff, 0);
+        char curr_time[26];
+        char last_time[26];
+        AOC_ERR(AOC_ERR_PARSE, 0, "Got an ASLEEP on %s without preceding AWAKE since %s.",
+                asctime_r(&curr_entry->timestamp, curr_time),
+                asctime_r(&last_asleep->timestamp, last_time));
         return NULL;
       }
       break;
@@ -276,11 +345,10 @@ analyzed_sched_t* analyze_schedule(tok_t* tok){
         last_asleep = NULL;
       }
       else{
-        char errbuff[128];
-        snprintf(errbuff, 128, "Got an AWAKE on %s without preceding ASLEEP.",
-                 asctime(&curr_entry->timestamp));
-        free_analyzed_sched(res);
-        set_aoc_err_msg(errbuff, 0);
+        char curr_time[26];
+        AOC_ERR(AOC_ERR_PARSE, 0, "Got an AWAKE on %s without preceding ASLEEP.",
+                asctime_r(&curr_entry->timestamp, curr_time));
+        return NULL;
       }
       break;
     }
@@ -288,28 +356,41 @@ analyzed_sched_t* analyze_schedule(tok_t* tok){
   return res;
 }
 
-void free_analyzed_sched(analyzed_sched_t* sched){
-  if(sched != NULL){
-    free(sched->a_guards);
-    free_sched(sched->schedule);
-    free(sched);
-  }
-}
-
-char* most_asleep_guard(tok_t* tok){
+/**
+ * Runs @e part on the analyzed schedule of @e tok, with an arena of its
+ * own for the call. The result is copied to the heap.
+ */
+static char* run_on_schedule(tok_t* tok,
+                             char* (*part)(const analyzed_sched_t*, arena_t*)){
   if(tok == NULL){
-    set_aoc_err_msg("Tokenizer is NULL.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is NULL.");
     return NULL;
   }
   if(tok_count(tok) == 0){
-    set_aoc_err_msg("Tokenizer is empty.", 0);
+    AOC_ERR(AOC_ERR_INVAL, 0, "Tokenizer is empty.");
     return NULL;
   }
-  analyzed_sched_t* sched = analyze_schedule(tok);
-  if(sched == NULL){
+  arena_t* arena = arena_create(0);
+  if(arena == NULL){
+    AOC_ERR(AOC_ERR_SYS, ENOMEM, "Could not create an arena.");
     return NULL;
   }
-  guard_t* max_guard = sched->a_guards;
+  char* res = NULL;
+  analyzed_sched_t* sched = analyze_schedule(tok, arena);
+  if(sched != NULL){
+    char* arena_res = part(sched, arena);
+    res = arena_res == NULL ? NULL : strdup(arena_res);
+  }
+  arena_destroy(arena);
+  return res;
+}
+
+char* most_asleep_guard(tok_t* tok){
+  return run_on_schedule(tok, most_asleep_guard_sched);
+}
+
+char* most_asleep_guard_sched(const analyzed_sched_t* sched, arena_t* arena){
+  const guard_t* max_guard = sched->a_guards;
   for(size_t i = 1; i < sched->n_guards; i++){
     if(sched->a_guards[i].total_minutes_asleep > max_guard->total_minutes_asleep){
       max_guard = &sched->a_guards[i];
@@ -321,32 +402,15 @@ char* most_asleep_guard(tok_t* tok){
       max_minute = i;
     }
   }
-  unsigned n = max_guard->id * max_minute;
-  unsigned counter = 0;
-  while(n != 0){
-    n /= 10;
-    counter++;
-  }
-  char* res = malloc(counter+2);
-  snprintf(res,counter+2,"%u",max_guard->id * max_minute);
-  free_analyzed_sched(sched);
-  return res;
+  return arena_sprintf(arena, "%u", max_guard->id * max_minute);
 }
 
 char* most_asleep_minute(tok_t* tok){
-  if(tok == NULL){
-    set_aoc_err_msg("Tokenizer is NULL.", 0);
-    return NULL;
-  }
-  if(tok_count(tok) == 0){
-    set_aoc_err_msg("Tokenizer is empty.", 0);
-    return NULL;
-  }
-  analyzed_sched_t* sched = analyze_schedule(tok);
-  if(sched == NULL){
-    return NULL;
-  }
-  guard_t* worst_guard = sched->a_guards;
+  return run_on_schedule(tok, most_asleep_minute_sched);
+}
+
+char* most_asleep_minute_sched(const analyzed_sched_t* sched, arena_t* arena){
+  const guard_t* worst_guard = sched->a_guards;
   unsigned most_asleep_min = 0;
   for(size_t i = 0; i < sched->n_guards; i++){
     for(size_t k = 0; k < 60; k++){
@@ -356,14 +420,5 @@ char* most_asleep_minute(tok_t* tok){
       }
     }
   }
-  unsigned n = worst_guard->id * most_asleep_min;
-  unsigned counter = 0;
-  while(n != 0){
-    n /= 10;
-    counter++;
-  }
-  char* res = malloc(counter+2);
-  snprintf(res,counter+2,"%u",worst_guard->id * most_asleep_min);
-  free_analyzed_sched(sched);
-  return res;
+  return arena_sprintf(arena, "%u", worst_guard->id * most_asleep_min);
 }
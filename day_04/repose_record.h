@@ -3,6 +3,7 @@
  * @brief AoC 2018 Day 04, Repose Record
  */
 
+#include "arena.h"
 #include "tokenizer.h"
 
 #include <time.h>
@@ -29,6 +30,11 @@ typedef struct guard{
   unsigned minutes_asleep[60];
 } guard_t;
 
+/**
+ * The analyzed schedule of an input, shared by both parts. Allocated
+ * from the arena handed to analyze_schedule, like the schedule it
+ * points to.
+ */
 typedef struct analyzed_sched{
   size_t n_guards;
   guard_t* a_guards;
@@ -37,14 +43,16 @@ typedef struct analyzed_sched{
 
 int parse_entry(const char* s, entry_t* en);
 
-sched_t* parse_schedule(tok_t* tok);
-
-void free_sched(sched_t* schedule);
+void free_entry_regexes(void);
 
-void free_analyzed_sched(analyzed_sched_t* sched);
+sched_t* parse_schedule(tok_t* tok, arena_t* arena);
 
-analyzed_sched_t* analyze_schedule(tok_t* tok);
+analyzed_sched_t* analyze_schedule(tok_t* tok, arena_t* arena);
 
 char* most_asleep_guard(tok_t* tok);
 
+char* most_asleep_guard_sched(const analyzed_sched_t* sched, arena_t* arena);
+
 char* most_asleep_minute(tok_t* tok);
+
+char* most_asleep_minute_sched(const analyzed_sched_t* sched, arena_t* arena);
@@ -11,6 +11,16 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+static arena_t* arena;
+
+void setUp(void){
+  arena = arena_create(0);
+}
+
+void tearDown(void){
+  arena_destroy(arena);
+}
+
 void check_tm(struct tm* exp, struct tm* actual){
   TEST_ASSERT_EQUAL_INT(exp->tm_sec, actual->tm_sec);
   TEST_ASSERT_EQUAL_INT(exp->tm_min, actual->tm_min);
@@ -58,7 +68,7 @@ void test_parse_entry_regex_error_sets_error_message(void){
   TEST_ASSERT_EQUAL_STRING("Failed to match action in "
                            "\"[1518-06-03 00:17] fallaaaaawers asleep\".", err);
   free(err);
-  free_sched(NULL);
+  free_entry_regexes();
 }
 
 void test_parse_entry_parses_shift_start_event_correctly(void){
@@ -69,7 +79,7 @@ void test_parse_entry_parses_shift_start_event_correctly(void){
   int res = parse_entry(in, &actual);
   TEST_ASSERT_EQUAL_INT(0,res);
   check_entry(&exp, &actual);
-  free_sched(NULL);
+  free_entry_regexes();
 }
 
 void test_parse_entry_parses_falling_asleep_event_correctly(void){
@@ -80,7 +90,7 @@ void test_parse_entry_parses_falling_asleep_event_correctly(void){
   int res = parse_entry(in, &actual);
   TEST_ASSERT_EQUAL_INT(0,res);
   check_entry(&exp, &actual);
-  free_sched(NULL);
+  free_entry_regexes();
 }
 
 void test_parse_entry_parses_waking_up_event_correctly(void){
@@ -91,11 +101,11 @@ void test_parse_entry_parses_waking_up_event_correctly(void){
   int res = parse_entry(in, &actual);
   TEST_ASSERT_EQUAL_INT(0,res);
   check_entry(&exp, &actual);
-  free_sched(NULL);
+  free_entry_regexes();
 }
 
 void test_parse_sched_tok_null_returns_null(void){
-  sched_t* res = parse_schedule(NULL);
+  sched_t* res = parse_schedule(NULL, arena);
   TEST_ASSERT_NULL(res);
   char* err = get_latest_aoc_err_msg();
   TEST_ASSERT_EQUAL_STRING("Tokenizer is NULL.", err);
@@ -109,11 +119,10 @@ void test_parse_sched_single_guard_counts_correct(void){
     "[1518-11-01 00:25] wakes up\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  sched_t* res = parse_schedule(tok);
+  sched_t* res = parse_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(5,res->entrycount);
   TEST_ASSERT_EQUAL_UINT(1,res->guardcount);
-  free_sched(res);
   free_tok(tok);
 }
 
@@ -134,13 +143,12 @@ void test_parse_sched_single_guard_correct_entries(void){
     "[1518-11-01 00:25] wakes up\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  sched_t* res = parse_schedule(tok);
+  sched_t* res = parse_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   entry_t* exp = single_guard_expected_schedule();
   for(int i=0; i<5; i++){
     check_entry(exp+i, &(res->schedstore[i]));
   }
-  free_sched(res);
   free_tok(tok);
   free(exp);
 }
@@ -152,7 +160,7 @@ void test_parse_sched_single_guard_sorted_by_time(void){
     "[1518-11-01 00:25] wakes up\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  sched_t* res = parse_schedule(tok);
+  sched_t* res = parse_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   entry_t* exp = single_guard_expected_schedule();
   check_entry(exp+2, res->schedule[0]);
@@ -160,7 +168,6 @@ void test_parse_sched_single_guard_sorted_by_time(void){
   check_entry(exp+3, res->schedule[2]);
   check_entry(exp+1, res->schedule[3]);
   check_entry(exp+4, res->schedule[4]);
-  free_sched(res);
   free_tok(tok);
   free(exp);
 }
@@ -172,11 +179,10 @@ void test_parse_sched_single_guard_id_correct(void){
     "[1518-11-01 00:25] wakes up\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  sched_t* res = parse_schedule(tok);
+  sched_t* res = parse_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(1u,res->guardcount);
   TEST_ASSERT_EQUAL_UINT(10u,res->guardids[0]);
-  free_sched(res);
   free_tok(tok);
 }
 
@@ -235,11 +241,10 @@ void test_parse_sched_multi_guard_counts_correct(void){
     "[1518-11-03 00:25] wakes up\n"
     "[1518-11-02 00:51] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  sched_t* res = parse_schedule(tok);
+  sched_t* res = parse_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(20,res->entrycount);
   TEST_ASSERT_EQUAL_UINT(3,res->guardcount);
-  free_sched(res);
   free_tok(tok);
 }
 
@@ -265,13 +270,12 @@ void test_parse_sched_multi_guard_id_correct(void){
     "[1518-11-03 00:25] wakes up\n"
     "[1518-11-02 00:51] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  sched_t* res = parse_schedule(tok);
+  sched_t* res = parse_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(3u,res->guardcount);
   TEST_ASSERT_EQUAL_UINT(2u,res->guardids[0]);
   TEST_ASSERT_EQUAL_UINT(10u,res->guardids[1]);
   TEST_ASSERT_EQUAL_UINT(167u,res->guardids[2]);
-  free_sched(res);
   free_tok(tok);
 }
 
@@ -297,13 +301,12 @@ void test_parse_sched_multi_guard_correct_entries(void){
     "[1518-11-03 00:25] wakes up\n"
     "[1518-11-02 00:51] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  sched_t* res = parse_schedule(tok);
+  sched_t* res = parse_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   entry_t* exp = multi_guard_expected_schedule();
   for(int i=0; i<20; i++){
     check_entry(exp+i, &(res->schedstore[i]));
   }
-  free_sched(res);
   free_tok(tok);
   free(exp);
 }
@@ -330,7 +333,7 @@ void test_parse_sched_multi_guard_sorted_by_time(void){
     "[1518-11-03 00:25] wakes up\n"
     "[1518-11-02 00:51] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  sched_t* res = parse_schedule(tok);
+  sched_t* res = parse_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   entry_t* exp = multi_guard_expected_schedule();
   check_entry(exp+3, res->schedule[0]);
@@ -353,7 +356,6 @@ void test_parse_sched_multi_guard_sorted_by_time(void){
   check_entry(exp+9, res->schedule[17]);
   check_entry(exp+10, res->schedule[18]);
   check_entry(exp+11, res->schedule[19]);
-  free_sched(res);
   free_tok(tok);
   free(exp);
 }
@@ -366,7 +368,7 @@ void test_parse_schedule_failed_parse_error_message(void){
     "[1518-06-03 00:17] fallaaaaawers asleep\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  sched_t* res = parse_schedule(tok);
+  sched_t* res = parse_schedule(tok, arena);
   TEST_ASSERT_NULL(res);
   char* err = get_latest_aoc_err_msg();
   TEST_ASSERT_EQUAL_STRING("Failed to match action in "
@@ -376,7 +378,7 @@ void test_parse_schedule_failed_parse_error_message(void){
 }
 
 void test_analyze_sched_tok_null_returns_null(void){
-  analyzed_sched_t* res = analyze_schedule(NULL);
+  analyzed_sched_t* res = analyze_schedule(NULL, arena);
   TEST_ASSERT_NULL(res);
   char* err = get_latest_aoc_err_msg();
   TEST_ASSERT_EQUAL_STRING("Tokenizer is NULL.", err);
@@ -391,7 +393,7 @@ void test_analyze_schedule_failed_parse_error_message(void){
     "[1518-06-03 00:17] fallaaaaawers asleep\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NULL(res);
   char* err = get_latest_aoc_err_msg();
   TEST_ASSERT_EQUAL_STRING("Failed to match action in "
@@ -400,6 +402,31 @@ void test_analyze_schedule_failed_parse_error_message(void){
   free_tok(tok);
 }
 
+void test_analyze_schedule_malformed_first_time_returns_null(void){
+  char in[] = "#1 @ 393,863: 11x29\n"
+    "[1518-11-01 00:00] Guard #10 begins shift\n";
+  tok_t* tok = get_tokenizer(in, "\n");
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Failed to parse time in \"#1 @ 393,863: 11x29\".", err);
+  free(err);
+  free_tok(tok);
+}
+
+void test_analyze_schedule_awake_without_asleep_returns_null(void){
+  char in[] = "[1518-11-01 00:00] Guard #10 begins shift\n"
+    "[1518-11-01 00:25] wakes up\n";
+  tok_t* tok = get_tokenizer(in, "\n");
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
+  TEST_ASSERT_NULL(res);
+  char* err = get_latest_aoc_err_msg();
+  TEST_ASSERT_EQUAL_STRING("Got an AWAKE on Fri Nov  1 00:25:00 1518\n"
+                           " without preceding ASLEEP.", err);
+  free(err);
+  free_tok(tok);
+}
+
 void test_analyze_schedule_single_guard_single_shift_guardcount(void){
   char in[] = "[1518-11-01 00:05] falls asleep\n"
     "[1518-11-01 00:30] falls asleep\n"
@@ -407,10 +434,9 @@ void test_analyze_schedule_single_guard_single_shift_guardcount(void){
     "[1518-11-01 00:25] wakes up\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(1u,res->n_guards);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -421,10 +447,9 @@ void test_analyze_schedule_single_guard_single_shift_correct_id(void){
     "[1518-11-01 00:25] wakes up\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(10u,res->a_guards[0].id);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -435,10 +460,9 @@ void test_analyze_schedule_single_guard_single_shift_sched_not_null(void){
     "[1518-11-01 00:25] wakes up\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_NOT_NULL(res->schedule);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -449,10 +473,9 @@ void test_analyze_schedule_single_guard_single_shift_sum_minutes_asleep(void){
     "[1518-11-01 00:25] wakes up\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(45u,res->a_guards[0].total_minutes_asleep);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -466,10 +489,9 @@ void test_analyze_schedule_single_guard_single_shift_minutes_asleep(void){
                       0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,
                       0,0,0,0};
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT_ARRAY(exp,res->a_guards[0].minutes_asleep,60);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -485,10 +507,9 @@ void test_analyze_schedule_single_guard_multi_shift_sum_minutes_asleep(void){
     "[1518-11-01 00:25] wakes up\n"
     "[1518-11-01 00:55] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(69u,res->a_guards[0].total_minutes_asleep);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -507,10 +528,9 @@ void test_analyze_schedule_single_guard_multi_shift_minutes_asleep(void){
                       0,1,2,2,2,2,2,2,2,2,2,2,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,
                       0,0,0,0};
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT_ARRAY(exp,res->a_guards[0].minutes_asleep,60);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -536,10 +556,9 @@ void test_analyze_schedule_multi_guard_guardcount(void){
     "[1518-11-03 00:25] wakes up\n"
     "[1518-11-02 00:51] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(3u,res->n_guards);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -565,12 +584,11 @@ void test_analyze_schedule_multi_guard_correct_id(void){
     "[1518-11-03 00:25] wakes up\n"
     "[1518-11-02 00:51] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(2u,res->a_guards[0].id);
   TEST_ASSERT_EQUAL_UINT(10u,res->a_guards[1].id);
   TEST_ASSERT_EQUAL_UINT(167u,res->a_guards[2].id);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -596,12 +614,11 @@ void test_analyze_schedule_multi_guard_sum_minutes_asleep(void){
     "[1518-11-03 00:25] wakes up\n"
     "[1518-11-02 00:51] wakes up\n";
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT(15u,res->a_guards[0].total_minutes_asleep);
   TEST_ASSERT_EQUAL_UINT(79u,res->a_guards[1].total_minutes_asleep);
   TEST_ASSERT_EQUAL_UINT(7u,res->a_guards[2].total_minutes_asleep);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -637,12 +654,11 @@ void test_analyze_schedule_multi_guard_minutes_asleep(void){
                           0,0,0,0,0,0}
   };
   tok_t* tok = get_tokenizer(in, "\n");
-  analyzed_sched_t* res = analyze_schedule(tok);
+  analyzed_sched_t* res = analyze_schedule(tok, arena);
   TEST_ASSERT_NOT_NULL(res);
   TEST_ASSERT_EQUAL_UINT_ARRAY(exp[0],res->a_guards[0].minutes_asleep,60);
   TEST_ASSERT_EQUAL_UINT_ARRAY(exp[1],res->a_guards[1].minutes_asleep,60);
   TEST_ASSERT_EQUAL_UINT_ARRAY(exp[2],res->a_guards[2].minutes_asleep,60);
-  free_analyzed_sched(res);
   free_tok(tok);
 }
 
@@ -734,6 +750,33 @@ void test_part2_aoc_example(void){
   free(res);
 }
 
+void test_both_parts_share_analyzed_schedule(void){
+  char in[] = "[1518-11-01 00:00] Guard #10 begins shift\n"
+    "[1518-11-01 00:05] falls asleep\n"
+    "[1518-11-01 00:25] wakes up\n"
+    "[1518-11-01 00:30] falls asleep\n"
+    "[1518-11-01 00:55] wakes up\n"
+    "[1518-11-01 23:58] Guard #99 begins shift\n"
+    "[1518-11-02 00:40] falls asleep\n"
+    "[1518-11-02 00:50] wakes up\n"
+    "[1518-11-03 00:05] Guard #10 begins shift\n"
+    "[1518-11-03 00:24] falls asleep\n"
+    "[1518-11-03 00:29] wakes up\n"
+    "[1518-11-04 00:02] Guard #99 begins shift\n"
+    "[1518-11-04 00:36] falls asleep\n"
+    "[1518-11-04 00:46] wakes up\n"
+    "[1518-11-05 00:03] Guard #99 begins shift\n"
+    "[1518-11-05 00:45] falls asleep\n"
+    "[1518-11-05 00:55] wakes up\n";
+  tok_t* tok = get_tokenizer(in, "\n");
+  analyzed_sched_t* sched = analyze_schedule(tok, arena);
+  char* res1 = most_asleep_guard_sched(sched, arena);
+  char* res2 = most_asleep_minute_sched(sched, arena);
+  TEST_ASSERT_EQUAL_STRING("240",res1);
+  TEST_ASSERT_EQUAL_STRING("4455",res2);
+  free_tok(tok);
+}
+
 int main(void){
   UNITY_BEGIN();
   RUN_TEST(test_parse_entry_null_string_returns_error);
@@ -755,6 +798,8 @@ int main(void){
   RUN_TEST(test_parse_schedule_failed_parse_error_message);
   RUN_TEST(test_analyze_sched_tok_null_returns_null);
   RUN_TEST(test_analyze_schedule_failed_parse_error_message);
+  RUN_TEST(test_analyze_schedule_malformed_first_time_returns_null);
+  RUN_TEST(test_analyze_schedule_awake_without_asleep_returns_null);
   RUN_TEST(test_analyze_schedule_single_guard_single_shift_guardcount);
   RUN_TEST(test_analyze_schedule_single_guard_single_shift_correct_id);
   RUN_TEST(test_analyze_schedule_single_guard_single_shift_sched_not_null);
@@ -772,5 +817,6 @@ int main(void){
   RUN_TEST(test_part2_tok_null_returns_null);
   RUN_TEST(test_part2_empty_tok_returns_null);
   RUN_TEST(test_part2_aoc_example);
+  RUN_TEST(test_both_parts_share_analyzed_schedule);
   return UNITY_END();
 }